@@ -70,6 +70,7 @@ static void group_add (EelCanvasGroup *group,
                        EelCanvasItem  *item);
 static void group_remove (EelCanvasGroup *group,
                           EelCanvasItem  *item);
+static void group_index_invalidate_order (EelCanvasGroup *group);
 static void redraw_and_repick_if_mapped (EelCanvasItem *item);
 
 /*** EelCanvasItem ***/
@@ -578,6 +579,8 @@ put_item_after (GList *link,
             return FALSE;
         }
 
+        group_index_invalidate_order (parent);
+
         link->prev->next = link->next;
 
         if (link->next)
@@ -601,6 +604,8 @@ put_item_after (GList *link,
             return FALSE;
         }
 
+        group_index_invalidate_order (parent);
+
         if (link->next)
         {
             link->next->prev = link->prev;
@@ -1450,6 +1455,362 @@ eel_canvas_group_get_property (GObject    *gobject,
     }
 }
 
+/* Spatial index of the children of a group.
+ *
+ * Children are filed in square cells of the canvas, by their bounds in canvas
+ * pixels. Drawing and picking then only look at the children in the cells
+ * covered by the area of interest, instead of at all of them. Children that
+ * cover too many cells are kept apart, and always looked at.
+ */
+
+/* Below this number of children, a plain walk of the list is fast enough */
+#define GROUP_INDEX_MIN_ITEMS 256
+#define GROUP_INDEX_CELL_SIZE 256
+#define GROUP_INDEX_MAX_CELLS_PER_ITEM 64
+
+typedef struct
+{
+    EelCanvasItem *item;
+
+    /* Cells the item is filed in */
+    int cx1, cy1, cx2, cy2;
+    gboolean large;
+
+    /* Position in the stacking order of the group */
+    guint order;
+    /* Avoids returning an item once per cell it is in */
+    guint query_stamp;
+} GroupIndexEntry;
+
+typedef struct
+{
+    gint64 key;
+    GPtrArray *entries;
+} GroupIndexCell;
+
+struct _EelCanvasGroupIndex
+{
+    GHashTable *cells;
+    GHashTable *entries;
+    GPtrArray *large_entries;
+
+    gboolean order_valid;
+    guint next_order;
+    guint query_stamp;
+};
+
+static gint64
+group_index_cell_key (int cx,
+                      int cy)
+{
+    return ((gint64) cx << 32) | (guint32) cy;
+}
+
+static int
+group_index_cell_coordinate (double coordinate)
+{
+    return (int) CLAMP (floor (coordinate / GROUP_INDEX_CELL_SIZE),
+                        G_MININT / 2, G_MAXINT / 2);
+}
+
+static void
+group_index_cell_free (GroupIndexCell *cell)
+{
+    g_ptr_array_unref (cell->entries);
+    g_free (cell);
+}
+
+static void
+group_index_file_entry (EelCanvasGroupIndex *index,
+                        GroupIndexEntry     *entry)
+{
+    EelCanvasItem *item;
+    GroupIndexCell *cell;
+    gint64 key;
+    int cx, cy;
+
+    item = entry->item;
+
+    entry->cx1 = group_index_cell_coordinate (item->x1);
+    entry->cy1 = group_index_cell_coordinate (item->y1);
+    entry->cx2 = group_index_cell_coordinate (item->x2);
+    entry->cy2 = group_index_cell_coordinate (item->y2);
+
+    entry->large = ((gint64) (entry->cx2 - entry->cx1 + 1) *
+                    (entry->cy2 - entry->cy1 + 1)) > GROUP_INDEX_MAX_CELLS_PER_ITEM;
+    if (entry->large)
+    {
+        g_ptr_array_add (index->large_entries, entry);
+        return;
+    }
+
+    for (cy = entry->cy1; cy <= entry->cy2; cy++)
+    {
+        for (cx = entry->cx1; cx <= entry->cx2; cx++)
+        {
+            key = group_index_cell_key (cx, cy);
+            cell = g_hash_table_lookup (index->cells, &key);
+            if (cell == NULL)
+            {
+                cell = g_new (GroupIndexCell, 1);
+                cell->key = key;
+                cell->entries = g_ptr_array_new ();
+                g_hash_table_insert (index->cells, &cell->key, cell);
+            }
+
+            g_ptr_array_add (cell->entries, entry);
+        }
+    }
+}
+
+static void
+group_index_unfile_entry (EelCanvasGroupIndex *index,
+                          GroupIndexEntry     *entry)
+{
+    GroupIndexCell *cell;
+    gint64 key;
+    int cx, cy;
+
+    if (entry->large)
+    {
+        g_ptr_array_remove_fast (index->large_entries, entry);
+        return;
+    }
+
+    for (cy = entry->cy1; cy <= entry->cy2; cy++)
+    {
+        for (cx = entry->cx1; cx <= entry->cx2; cx++)
+        {
+            key = group_index_cell_key (cx, cy);
+            cell = g_hash_table_lookup (index->cells, &key);
+            if (cell == NULL)
+            {
+                continue;
+            }
+
+            g_ptr_array_remove_fast (cell->entries, entry);
+            if (cell->entries->len == 0)
+            {
+                g_hash_table_remove (index->cells, &key);
+            }
+        }
+    }
+}
+
+static void
+group_index_add (EelCanvasGroupIndex *index,
+                 EelCanvasItem       *item)
+{
+    GroupIndexEntry *entry;
+
+    entry = g_new0 (GroupIndexEntry, 1);
+    entry->item = item;
+    entry->order = index->next_order++;
+
+    g_hash_table_insert (index->entries, item, entry);
+    group_index_file_entry (index, entry);
+}
+
+static void
+group_index_remove (EelCanvasGroupIndex *index,
+                    EelCanvasItem       *item)
+{
+    GroupIndexEntry *entry;
+
+    entry = g_hash_table_lookup (index->entries, item);
+    if (entry == NULL)
+    {
+        return;
+    }
+
+    group_index_unfile_entry (index, entry);
+    g_hash_table_remove (index->entries, item);
+}
+
+/* Files the item again if its bounds moved to other cells */
+static void
+group_index_update (EelCanvasGroupIndex *index,
+                    EelCanvasItem       *item)
+{
+    GroupIndexEntry *entry;
+
+    entry = g_hash_table_lookup (index->entries, item);
+    if (entry == NULL)
+    {
+        return;
+    }
+
+    if (entry->cx1 == group_index_cell_coordinate (item->x1) &&
+        entry->cy1 == group_index_cell_coordinate (item->y1) &&
+        entry->cx2 == group_index_cell_coordinate (item->x2) &&
+        entry->cy2 == group_index_cell_coordinate (item->y2))
+    {
+        return;
+    }
+
+    group_index_unfile_entry (index, entry);
+    group_index_file_entry (index, entry);
+}
+
+static void
+group_index_free (EelCanvasGroupIndex *index)
+{
+    g_hash_table_destroy (index->cells);
+    g_hash_table_destroy (index->entries);
+    g_ptr_array_unref (index->large_entries);
+    g_free (index);
+}
+
+static void
+group_index_invalidate_order (EelCanvasGroup *group)
+{
+    if (group->index != NULL)
+    {
+        group->index->order_valid = FALSE;
+    }
+}
+
+static void
+group_index_ensure_order (EelCanvasGroup *group)
+{
+    EelCanvasGroupIndex *index;
+    GroupIndexEntry *entry;
+    GList *list;
+
+    index = group->index;
+    if (index->order_valid)
+    {
+        return;
+    }
+
+    index->next_order = 0;
+    for (list = group->item_list; list; list = list->next)
+    {
+        entry = g_hash_table_lookup (index->entries, list->data);
+        entry->order = index->next_order++;
+    }
+
+    index->order_valid = TRUE;
+}
+
+/* Creates the index once the group has enough children, or drops it when it
+ * doesn't anymore, and tells whether it's there. */
+static gboolean
+group_index_check (EelCanvasGroup *group)
+{
+    GList *list;
+
+    if (group->n_items < GROUP_INDEX_MIN_ITEMS / 2 && group->index != NULL)
+    {
+        g_clear_pointer (&group->index, group_index_free);
+    }
+    else if (group->n_items >= GROUP_INDEX_MIN_ITEMS && group->index == NULL)
+    {
+        group->index = g_new0 (EelCanvasGroupIndex, 1);
+        group->index->cells = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+                                                     NULL,
+                                                     (GDestroyNotify) group_index_cell_free);
+        group->index->entries = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+        group->index->large_entries = g_ptr_array_new ();
+        group->index->order_valid = TRUE;
+
+        for (list = group->item_list; list; list = list->next)
+        {
+            group_index_add (group->index, list->data);
+        }
+    }
+
+    return group->index != NULL;
+}
+
+static gint
+compare_entries_by_order (gconstpointer a,
+                          gconstpointer b)
+{
+    const GroupIndexEntry *entry_a = *(GroupIndexEntry **) a;
+    const GroupIndexEntry *entry_b = *(GroupIndexEntry **) b;
+
+    return (entry_a->order > entry_b->order) - (entry_a->order < entry_b->order);
+}
+
+/* Returns the children whose bounds intersect the given area, in canvas
+ * pixels, in their stacking order. */
+static GPtrArray *
+group_index_query (EelCanvasGroup *group,
+                   int             x1,
+                   int             y1,
+                   int             x2,
+                   int             y2)
+{
+    EelCanvasGroupIndex *index;
+    GPtrArray *result;
+    GroupIndexCell *cell;
+    GroupIndexEntry *entry;
+    EelCanvasItem *item;
+    gint64 key;
+    int cx1, cy1, cx2, cy2;
+    int cx, cy;
+    guint i;
+
+    index = group->index;
+    group_index_ensure_order (group);
+
+    index->query_stamp++;
+    result = g_ptr_array_new ();
+
+    cx1 = group_index_cell_coordinate (x1);
+    cy1 = group_index_cell_coordinate (y1);
+    cx2 = group_index_cell_coordinate (x2);
+    cy2 = group_index_cell_coordinate (y2);
+
+    for (cy = cy1; cy <= cy2; cy++)
+    {
+        for (cx = cx1; cx <= cx2; cx++)
+        {
+            key = group_index_cell_key (cx, cy);
+            cell = g_hash_table_lookup (index->cells, &key);
+            if (cell == NULL)
+            {
+                continue;
+            }
+
+            for (i = 0; i < cell->entries->len; i++)
+            {
+                entry = g_ptr_array_index (cell->entries, i);
+                if (entry->query_stamp != index->query_stamp)
+                {
+                    entry->query_stamp = index->query_stamp;
+                    g_ptr_array_add (result, entry);
+                }
+            }
+        }
+    }
+
+    for (i = 0; i < index->large_entries->len; i++)
+    {
+        g_ptr_array_add (result, g_ptr_array_index (index->large_entries, i));
+    }
+
+    /* Drop the ones that only share a cell with the area */
+    for (i = 0; i < result->len;)
+    {
+        entry = g_ptr_array_index (result, i);
+        item = entry->item;
+        if (item->x1 > x2 || item->y1 > y2 || item->x2 < x1 || item->y2 < y1)
+        {
+            g_ptr_array_remove_index_fast (result, i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    g_ptr_array_sort (result, compare_entries_by_order);
+
+    return result;
+}
+
 /* Destroy handler for canvas groups */
 static void
 eel_canvas_group_destroy (EelCanvasItem *object)
@@ -1471,6 +1832,8 @@ eel_canvas_group_destroy (EelCanvasItem *object)
         eel_canvas_item_destroy (child);
     }
 
+    g_clear_pointer (&group->index, group_index_free);
+
     if (EEL_CANVAS_ITEM_CLASS (group_parent_class)->destroy)
     {
         (*EEL_CANVAS_ITEM_CLASS (group_parent_class)->destroy)(object);
@@ -1505,6 +1868,11 @@ eel_canvas_group_update (EelCanvasItem *item,
 
         eel_canvas_item_invoke_update (i, i2w_dx + group->xpos, i2w_dy + group->ypos, flags);
 
+        if (group->index != NULL)
+        {
+            group_index_update (group->index, i);
+        }
+
         if (first)
         {
             first = FALSE;
@@ -1617,12 +1985,33 @@ eel_canvas_group_draw (EelCanvasItem  *item,
     EelCanvasGroup *group;
     GList *list;
     EelCanvasItem *child = NULL;
+    g_autoptr (GPtrArray) children = NULL;
+    cairo_rectangle_int_t extents;
+    guint i;
 
     group = EEL_CANVAS_GROUP (item);
 
-    for (list = group->item_list; list; list = list->next)
+    if (group_index_check (group))
     {
-        child = list->data;
+        cairo_region_get_extents (region, &extents);
+        children = group_index_query (group, extents.x, extents.y,
+                                      extents.x + extents.width,
+                                      extents.y + extents.height);
+    }
+
+    list = group->item_list;
+    i = 0;
+    while (children != NULL ? i < children->len : list != NULL)
+    {
+        if (children != NULL)
+        {
+            child = ((GroupIndexEntry *) g_ptr_array_index (children, i++))->item;
+        }
+        else
+        {
+            child = list->data;
+            list = list->next;
+        }
 
         if ((child->flags & EEL_CANVAS_ITEM_MAPPED) &&
             (EEL_CANVAS_ITEM_GET_CLASS (child)->draw))
@@ -1654,10 +2043,12 @@ eel_canvas_group_point (EelCanvasItem  *item,
     EelCanvasGroup *group;
     GList *list;
     EelCanvasItem *child, *point_item;
+    g_autoptr (GPtrArray) children = NULL;
     int x1, y1, x2, y2;
     double gx, gy;
     double dist, best;
     int has_point;
+    guint i;
 
     group = EEL_CANVAS_GROUP (item);
 
@@ -1674,9 +2065,24 @@ eel_canvas_group_point (EelCanvasItem  *item,
 
     dist = 0.0;     /* keep gcc happy */
 
-    for (list = group->item_list; list; list = list->next)
+    if (group_index_check (group))
     {
-        child = list->data;
+        children = group_index_query (group, x1, y1, x2, y2);
+    }
+
+    list = group->item_list;
+    i = 0;
+    while (children != NULL ? i < children->len : list != NULL)
+    {
+        if (children != NULL)
+        {
+            child = ((GroupIndexEntry *) g_ptr_array_index (children, i++))->item;
+        }
+        else
+        {
+            child = list->data;
+            list = list->next;
+        }
 
         if ((child->x1 > x2) || (child->y1 > y2) || (child->x2 < x1) || (child->y2 < y1))
         {
@@ -1834,6 +2240,12 @@ group_add (EelCanvasGroup *group,
         group->item_list_end = g_list_append (group->item_list_end, item)->next;
     }
 
+    group->n_items++;
+    if (group->index != NULL)
+    {
+        group_index_add (group->index, item);
+    }
+
     if (item->flags & EEL_CANVAS_ITEM_VISIBLE &&
         group->item.flags & EEL_CANVAS_ITEM_MAPPED)
     {
@@ -1898,6 +2310,12 @@ group_remove (EelCanvasGroup *group,
 
             group->item_list = g_list_remove_link (group->item_list, children);
             g_list_free (children);
+
+            group->n_items--;
+            if (group->index != NULL)
+            {
+                group_index_remove (group->index, item);
+            }
             break;
         }
     }
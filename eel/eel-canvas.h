@@ -67,6 +67,7 @@ typedef struct _EelCanvasItem       EelCanvasItem;
 typedef struct _EelCanvasItemClass  EelCanvasItemClass;
 typedef struct _EelCanvasGroup      EelCanvasGroup;
 typedef struct _EelCanvasGroupClass EelCanvasGroupClass;
+typedef struct _EelCanvasGroupIndex EelCanvasGroupIndex;
 
 
 /* EelCanvasItem - base item class for canvas items
@@ -301,6 +302,11 @@ struct _EelCanvasGroup {
 	/* Children of the group */
 	GList *item_list;
 	GList *item_list_end;
+	guint n_items;
+
+	/* Spatial index of the children bounds, only kept once the group has
+	 * enough children for it to pay off */
+	EelCanvasGroupIndex *index;
 };
 
 struct _EelCanvasGroupClass {
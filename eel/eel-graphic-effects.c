@@ -29,6 +29,10 @@
 #include <math.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 /* shared utility to create a new pixbuf from the passed-in one */
 
 static GdkPixbuf *
@@ -47,7 +51,9 @@ create_new_pixbuf (GdkPixbuf *src)
                            gdk_pixbuf_get_height (src));
 }
 
-/* utility routine to bump the level of a color component with pinning */
+/* Pixels are processed a row at a time. When SSE2 is available, which is
+ * always the case on x86_64, 16 bytes are processed at once, and the bytes
+ * left at the end of the row go through the plain C version. */
 
 const int HOVER_COMPONENT_ADDITION = 15;
 
@@ -63,14 +69,178 @@ lighten_component (guchar cur_value)
     return (guchar) new_value;
 }
 
+static void
+lighten_row (const guchar *src,
+             guchar       *dest,
+             int           width,
+             int           n_channels)
+{
+    int n_bytes;
+    int i;
+
+    n_bytes = width * n_channels;
+    i = 0;
+
+#ifdef __SSE2__
+    {
+        __m128i addition;
+
+        if (n_channels == 4)
+        {
+            addition = _mm_set1_epi32 (HOVER_COMPONENT_ADDITION |
+                                       HOVER_COMPONENT_ADDITION << 8 |
+                                       HOVER_COMPONENT_ADDITION << 16);
+        }
+        else
+        {
+            addition = _mm_set1_epi8 (HOVER_COMPONENT_ADDITION);
+        }
+
+        for (; i + 16 <= n_bytes; i += 16)
+        {
+            __m128i pixels;
+
+            pixels = _mm_loadu_si128 ((const __m128i *) (src + i));
+            _mm_storeu_si128 ((__m128i *) (dest + i), _mm_adds_epu8 (pixels, addition));
+        }
+    }
+#endif
+
+    for (; i < n_bytes; i++)
+    {
+        if (n_channels == 4 && i % 4 == 3)
+        {
+            dest[i] = src[i];
+        }
+        else
+        {
+            dest[i] = lighten_component (src[i]);
+        }
+    }
+}
+
+static void
+colorize_row (const guchar *src,
+              guchar       *dest,
+              int           width,
+              int           n_channels)
+{
+    int n_bytes;
+    int i;
+
+    n_bytes = width * n_channels;
+    i = 0;
+
+#ifdef __SSE2__
+    {
+        __m128i zero;
+        __m128i alpha_mask;
+
+        zero = _mm_setzero_si128 ();
+        alpha_mask = n_channels == 4 ? _mm_set1_epi32 (0xff000000) : zero;
+
+        for (; i + 16 <= n_bytes; i += 16)
+        {
+            __m128i src_pixels, dest_pixels;
+            __m128i low, high;
+            __m128i result;
+
+            src_pixels = _mm_loadu_si128 ((const __m128i *) (src + i));
+            dest_pixels = _mm_loadu_si128 ((const __m128i *) (dest + i));
+
+            low = _mm_mullo_epi16 (_mm_unpacklo_epi8 (src_pixels, zero),
+                                   _mm_unpacklo_epi8 (dest_pixels, zero));
+            high = _mm_mullo_epi16 (_mm_unpackhi_epi8 (src_pixels, zero),
+                                    _mm_unpackhi_epi8 (dest_pixels, zero));
+            result = _mm_packus_epi16 (_mm_srli_epi16 (low, 8),
+                                       _mm_srli_epi16 (high, 8));
+
+            /* The alpha comes from the source */
+            result = _mm_or_si128 (_mm_andnot_si128 (alpha_mask, result),
+                                   _mm_and_si128 (alpha_mask, src_pixels));
+
+            _mm_storeu_si128 ((__m128i *) (dest + i), result);
+        }
+    }
+#endif
+
+    for (; i < n_bytes; i++)
+    {
+        if (n_channels == 4 && i % 4 == 3)
+        {
+            dest[i] = src[i];
+        }
+        else
+        {
+            dest[i] = (src[i] * dest[i]) >> 8;
+        }
+    }
+}
+
+/* Cairo pixels are premultiplied, so the addition is scaled by the alpha,
+ * and the components are kept below it. Opaque pixels get the same result as
+ * lighten_row(). */
+static void
+lighten_premultiplied_row (guint32 *pixels,
+                           int      width)
+{
+    guint32 alpha, addition;
+    guint32 pixel, result;
+    int shift;
+    int i;
+
+    i = 0;
+
+#ifdef __SSE2__
+    {
+        __m128i low_nibbles;
+
+        low_nibbles = _mm_set1_epi8 (0x0f);
+
+        for (; i + 4 <= width; i += 4)
+        {
+            __m128i vector;
+            __m128i alphas;
+            __m128i additions;
+
+            vector = _mm_loadu_si128 ((const __m128i *) (pixels + i));
+
+            /* Each byte of a pixel set to its alpha */
+            alphas = _mm_srli_epi32 (vector, 24);
+            alphas = _mm_or_si128 (alphas, _mm_slli_epi32 (alphas, 8));
+            alphas = _mm_or_si128 (alphas, _mm_slli_epi32 (alphas, 16));
+
+            additions = _mm_and_si128 (_mm_srli_epi16 (alphas, 4), low_nibbles);
+
+            vector = _mm_min_epu8 (_mm_adds_epu8 (vector, additions), alphas);
+            _mm_storeu_si128 ((__m128i *) (pixels + i), vector);
+        }
+    }
+#endif
+
+    for (; i < width; i++)
+    {
+        pixel = pixels[i];
+        alpha = pixel >> 24;
+        addition = alpha >> 4;
+        result = pixel & 0xff000000;
+
+        for (shift = 0; shift < 24; shift += 8)
+        {
+            result |= MIN (((pixel >> shift) & 0xff) + addition, alpha) << shift;
+        }
+
+        pixels[i] = result;
+    }
+}
+
 GdkPixbuf *
 eel_create_spotlight_pixbuf (GdkPixbuf *src)
 {
     GdkPixbuf *dest;
-    int i, j;
-    int width, height, has_alpha, src_row_stride, dst_row_stride;
+    int i;
+    int width, height, n_channels, src_row_stride, dst_row_stride;
     guchar *target_pixels, *original_pixels;
-    guchar *pixsrc, *pixdest;
 
     g_return_val_if_fail (gdk_pixbuf_get_colorspace (src) == GDK_COLORSPACE_RGB, NULL);
     g_return_val_if_fail ((!gdk_pixbuf_get_has_alpha (src)
@@ -81,7 +251,7 @@ eel_create_spotlight_pixbuf (GdkPixbuf *src)
 
     dest = create_new_pixbuf (src);
 
-    has_alpha = gdk_pixbuf_get_has_alpha (src);
+    n_channels = gdk_pixbuf_get_n_channels (src);
     width = gdk_pixbuf_get_width (src);
     height = gdk_pixbuf_get_height (src);
     dst_row_stride = gdk_pixbuf_get_rowstride (dest);
@@ -91,20 +261,83 @@ eel_create_spotlight_pixbuf (GdkPixbuf *src)
 
     for (i = 0; i < height; i++)
     {
-        pixdest = target_pixels + i * dst_row_stride;
-        pixsrc = original_pixels + i * src_row_stride;
-        for (j = 0; j < width; j++)
+        lighten_row (original_pixels + i * src_row_stride,
+                     target_pixels + i * dst_row_stride,
+                     width, n_channels);
+    }
+    return dest;
+}
+
+/* The lightened pixbuf is kept with the source one, so that hovering the
+ * same icon again doesn't make a new one. This relies on the source not
+ * being modified afterwards, which is the case of the icons and thumbnails
+ * that come from the caches. */
+GdkPixbuf *
+eel_get_spotlight_pixbuf (GdkPixbuf *src)
+{
+    static GQuark spotlight_quark;
+    GdkPixbuf *spotlight;
+
+    if (spotlight_quark == 0)
+    {
+        spotlight_quark = g_quark_from_static_string ("eel-spotlight-pixbuf");
+    }
+
+    spotlight = g_object_get_qdata (G_OBJECT (src), spotlight_quark);
+    if (spotlight == NULL)
+    {
+        spotlight = eel_create_spotlight_pixbuf (src);
+        if (spotlight == NULL)
         {
-            *pixdest++ = lighten_component (*pixsrc++);
-            *pixdest++ = lighten_component (*pixsrc++);
-            *pixdest++ = lighten_component (*pixsrc++);
-            if (has_alpha)
+            return NULL;
+        }
+
+        g_object_set_qdata_full (G_OBJECT (src), spotlight_quark,
+                                 spotlight, g_object_unref);
+    }
+
+    return g_object_ref (spotlight);
+}
+
+void
+eel_spotlight_surface (cairo_surface_t *surface)
+{
+    cairo_format_t format;
+    guchar *data;
+    int width, height, stride;
+    int i;
+
+    g_return_if_fail (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE);
+
+    format = cairo_image_surface_get_format (surface);
+    g_return_if_fail (format == CAIRO_FORMAT_ARGB32 || format == CAIRO_FORMAT_RGB24);
+
+    cairo_surface_flush (surface);
+
+    data = cairo_image_surface_get_data (surface);
+    width = cairo_image_surface_get_width (surface);
+    height = cairo_image_surface_get_height (surface);
+    stride = cairo_image_surface_get_stride (surface);
+
+    for (i = 0; i < height; i++)
+    {
+        if (format == CAIRO_FORMAT_RGB24)
+        {
+            guint32 *row;
+            int j;
+
+            /* The unused byte is set as if the pixel was opaque */
+            row = (guint32 *) (data + i * stride);
+            for (j = 0; j < width; j++)
             {
-                *pixdest++ = *pixsrc++;
+                row[j] |= 0xff000000;
             }
         }
+
+        lighten_premultiplied_row ((guint32 *) (data + i * stride), width);
     }
-    return dest;
+
+    cairo_surface_mark_dirty (surface);
 }
 
 /* This routine colorizes %src by multiplying each pixel with colors in %dest. */
@@ -113,12 +346,10 @@ GdkPixbuf *
 eel_create_colorized_pixbuf (GdkPixbuf *src,
                              GdkPixbuf *dest)
 {
-    int i, j;
-    int width, height, has_alpha, src_row_stride, dst_row_stride;
+    int i;
+    int width, height, n_channels, src_row_stride, dst_row_stride;
     guchar *target_pixels;
     guchar *original_pixels;
-    guchar *pixsrc;
-    guchar *pixdest;
 
     g_return_val_if_fail (gdk_pixbuf_get_colorspace (src) == GDK_COLORSPACE_RGB, NULL);
     g_return_val_if_fail (gdk_pixbuf_get_colorspace (dest) == GDK_COLORSPACE_RGB, NULL);
@@ -135,7 +366,7 @@ eel_create_colorized_pixbuf (GdkPixbuf *src,
     g_return_val_if_fail (gdk_pixbuf_get_bits_per_sample (src) == 8, NULL);
     g_return_val_if_fail (gdk_pixbuf_get_bits_per_sample (dest) == 8, NULL);
 
-    has_alpha = gdk_pixbuf_get_has_alpha (src);
+    n_channels = gdk_pixbuf_get_n_channels (src);
     width = gdk_pixbuf_get_width (src);
     height = gdk_pixbuf_get_height (src);
     src_row_stride = gdk_pixbuf_get_rowstride (src);
@@ -145,21 +376,9 @@ eel_create_colorized_pixbuf (GdkPixbuf *src,
 
     for (i = 0; i < height; i++)
     {
-        pixdest = target_pixels + i * dst_row_stride;
-        pixsrc = original_pixels + i * src_row_stride;
-        for (j = 0; j < width; j++)
-        {
-            *pixdest = ((*pixsrc++) * (*pixdest)) >> 8;
-            pixdest++;
-            *pixdest = ((*pixsrc++) * (*pixdest)) >> 8;
-            pixdest++;
-            *pixdest = ((*pixsrc++) * (*pixdest)) >> 8;
-            pixdest++;
-            if (has_alpha)
-            {
-                *pixdest++ = *pixsrc++;
-            }
-        }
+        colorize_row (original_pixels + i * src_row_stride,
+                      target_pixels + i * dst_row_stride,
+                      width, n_channels);
     }
     return dest;
 }
@@ -27,6 +27,12 @@
 /* return a lightened pixbuf for pre-lighting */
 GdkPixbuf *eel_create_spotlight_pixbuf (GdkPixbuf *source_pixbuf);
 
+/* same, but made only once per source pixbuf, which must not change */
+GdkPixbuf *eel_get_spotlight_pixbuf (GdkPixbuf *source_pixbuf);
+
+/* lighten an image surface in place */
+void eel_spotlight_surface (cairo_surface_t *surface);
+
 /* return a pixbuf colorized with the color specified by the parameters */
 GdkPixbuf* eel_create_colorized_pixbuf (GdkPixbuf *source_pixbuf,
                                         GdkPixbuf *dest);
@@ -70,6 +70,91 @@ nautilus_info_provider_cancel_update (NautilusInfoProvider    *self,
     iface->cancel_update (self, handle);
 }
 
+/**
+ * nautilus_info_provider_supports_batch:
+ * @provider: a #NautilusInfoProvider
+ *
+ * Returns: %TRUE if @provider implements the batch interface, in which case
+ *  nautilus_info_provider_update_file_info_batch_async() is used instead of
+ *  nautilus_info_provider_update_file_info().
+ */
+gboolean
+nautilus_info_provider_supports_batch (NautilusInfoProvider *self)
+{
+    NautilusInfoProviderInterface *iface;
+
+    g_return_val_if_fail (NAUTILUS_IS_INFO_PROVIDER (self), FALSE);
+
+    iface = NAUTILUS_INFO_PROVIDER_GET_IFACE (self);
+
+    return iface->update_file_info_batch_async != NULL &&
+           iface->update_file_info_batch_finish != NULL;
+}
+
+/**
+ * nautilus_info_provider_update_file_info_batch_async:
+ * @provider: a #NautilusInfoProvider
+ * @files: (element-type NautilusFileInfo): the files to update
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: called when the files are updated
+ * @user_data: data for @callback
+ *
+ * Asks @provider to add its information to all of @files.
+ *
+ * The work may be done in a worker thread, for instance with
+ * g_task_run_in_thread(). The files must only be read and modified from the
+ * main thread though: implementations using a thread should collect what they
+ * need, such as the locations of the files, before starting it, and add the
+ * emblems and attributes when the operation is finished, in
+ * nautilus_info_provider_update_file_info_batch_finish(), which is always
+ * called from the main thread.
+ */
+void
+nautilus_info_provider_update_file_info_batch_async (NautilusInfoProvider *self,
+                                                     GList                *files,
+                                                     GCancellable         *cancellable,
+                                                     GAsyncReadyCallback   callback,
+                                                     gpointer              user_data)
+{
+    NautilusInfoProviderInterface *iface;
+
+    g_return_if_fail (NAUTILUS_IS_INFO_PROVIDER (self));
+
+    iface = NAUTILUS_INFO_PROVIDER_GET_IFACE (self);
+
+    g_return_if_fail (iface->update_file_info_batch_async != NULL);
+
+    iface->update_file_info_batch_async (self, files, cancellable,
+                                         callback, user_data);
+}
+
+/**
+ * nautilus_info_provider_update_file_info_batch_finish:
+ * @provider: a #NautilusInfoProvider
+ * @result: the #GAsyncResult given to the callback
+ * @error: return location for a #GError
+ *
+ * Finishes an operation started with
+ * nautilus_info_provider_update_file_info_batch_async().
+ *
+ * Returns: %TRUE if the files were updated, %FALSE if @error is set.
+ */
+gboolean
+nautilus_info_provider_update_file_info_batch_finish (NautilusInfoProvider  *self,
+                                                      GAsyncResult          *result,
+                                                      GError               **error)
+{
+    NautilusInfoProviderInterface *iface;
+
+    g_return_val_if_fail (NAUTILUS_IS_INFO_PROVIDER (self), FALSE);
+
+    iface = NAUTILUS_INFO_PROVIDER_GET_IFACE (self);
+
+    g_return_val_if_fail (iface->update_file_info_batch_finish != NULL, FALSE);
+
+    return iface->update_file_info_batch_finish (self, result, error);
+}
+
 void
 nautilus_info_provider_update_complete_invoke (GClosure                *update_complete,
                                                NautilusInfoProvider    *provider,
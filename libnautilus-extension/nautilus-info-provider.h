@@ -32,7 +32,7 @@
 #warning "Only <nautilus-extension.h> should be included directly."
 #endif
 
-#include <glib-object.h>
+#include <gio/gio.h>
 #include "nautilus-file-info.h"
 /* This should be removed at some point. */
 #include "nautilus-extension-types.h"
@@ -106,8 +106,17 @@ typedef enum
  *                    See nautilus_info_provider_update_file_info() for details.
  * @cancel_update: Cancels a previous call to nautilus_info_provider_update_file_info().
  *                 See nautilus_info_provider_cancel_update() for details.
+ * @update_file_info_batch_async: Starts updating several files at once.
+ *                                See nautilus_info_provider_update_file_info_batch_async()
+ *                                for details.
+ * @update_file_info_batch_finish: Finishes an operation started with
+ *                                 @update_file_info_batch_async.
  *
  * Interface for extensions to provide additional information about files.
+ *
+ * Extensions that implement @update_file_info_batch_async and
+ * @update_file_info_batch_finish are given many files at once, instead of one
+ * file at a time through @update_file_info.
  */
 struct _NautilusInfoProviderInterface
 {
@@ -119,6 +128,15 @@ struct _NautilusInfoProviderInterface
                                                  NautilusOperationHandle **handle);
     void                    (*cancel_update)    (NautilusInfoProvider     *provider,
                                                  NautilusOperationHandle  *handle);
+
+    void                    (*update_file_info_batch_async)  (NautilusInfoProvider  *provider,
+                                                              GList                 *files,
+                                                              GCancellable          *cancellable,
+                                                              GAsyncReadyCallback    callback,
+                                                              gpointer               user_data);
+    gboolean                (*update_file_info_batch_finish) (NautilusInfoProvider  *provider,
+                                                              GAsyncResult          *result,
+                                                              GError               **error);
 };
 
 /* Interface Functions */
@@ -129,6 +147,18 @@ NautilusOperationResult nautilus_info_provider_update_file_info       (NautilusI
 void                    nautilus_info_provider_cancel_update          (NautilusInfoProvider     *provider,
                                                                        NautilusOperationHandle  *handle);
 
+gboolean                nautilus_info_provider_supports_batch         (NautilusInfoProvider     *provider);
+void                    nautilus_info_provider_update_file_info_batch_async
+                                                                      (NautilusInfoProvider     *provider,
+                                                                       GList                    *files,
+                                                                       GCancellable             *cancellable,
+                                                                       GAsyncReadyCallback       callback,
+                                                                       gpointer                  user_data);
+gboolean                nautilus_info_provider_update_file_info_batch_finish
+                                                                      (NautilusInfoProvider     *provider,
+                                                                       GAsyncResult             *result,
+                                                                       GError                  **error);
+
 
 
 /* Helper functions for implementations */
@@ -30,6 +30,11 @@
 
 #define ROW_MARGIN_START 6
 #define ROW_MARGIN_TOP_BOTTOM 4
+#define ARROW_COLUMN_WIDTH 32
+
+/* The preview model only stores the row index; the labels are computed by the
+ * cell data functions, so only the rows on screen are ever rendered. */
+enum { PREVIEW_COLUMN_INDEX, PREVIEW_NUM_COLUMNS };
 
 struct _NautilusBatchRenameDialog {
   GtkDialog parent;
@@ -38,9 +43,7 @@ struct _NautilusBatchRenameDialog {
   NautilusWindow *window;
 
   GtkWidget *cancel_button;
-  GtkWidget *original_name_listbox;
-  GtkWidget *arrow_listbox;
-  GtkWidget *result_listbox;
+  GtkWidget *preview_view;
   GtkWidget *name_entry;
   GtkWidget *rename_button;
   GtkWidget *find_entry;
@@ -61,15 +64,21 @@ struct _NautilusBatchRenameDialog {
   GtkWidget *conflict_down;
   GtkWidget *conflict_up;
 
-  GList *listbox_labels_new;
-  GList *listbox_labels_old;
-  GList *listbox_icons;
-  GtkSizeGroup *size_group;
-
-  GList *motion_controllers;
+  GtkListStore *preview_model;
+  GtkTreeViewColumn *original_name_column;
+  GtkTreeViewColumn *arrow_column;
+  GtkTreeViewColumn *result_column;
 
   GList *selection;
   GList *new_names;
+  /* index based views of selection and new_names, for random access from the
+   * preview cell data functions */
+  GPtrArray *selection_index;
+  GPtrArray *new_names_index;
+  /* set of the row indexes that have a conflict */
+  GHashTable *conflict_rows;
+  GdkRGBA conflict_bg;
+  GdkRGBA conflict_fg;
   NautilusBatchRenameDialogMode mode;
   NautilusDirectory *directory;
 
@@ -95,10 +104,6 @@ struct _NautilusBatchRenameDialog {
    * and position */
   GHashTable *tag_info_table;
 
-  GtkWidget *preselected_row1;
-  GtkWidget *preselected_row2;
-
-  gint row_height;
   gboolean rename_clicked;
 
   GCancellable *metadata_cancellable;
@@ -250,47 +255,6 @@ const GActionEntry dialog_entries[] = {
     {"add-album-name-tag", add_metadata_tag},
 };
 
-static void row_selected(GtkListBox *box, GtkListBoxRow *listbox_row,
-                         gpointer user_data) {
-  NautilusBatchRenameDialog *dialog;
-  GtkListBoxRow *row;
-  gint index;
-
-  if (!GTK_IS_LIST_BOX_ROW(listbox_row)) {
-    return;
-  }
-
-  dialog = NAUTILUS_BATCH_RENAME_DIALOG(user_data);
-  index = gtk_list_box_row_get_index(listbox_row);
-
-  if (GTK_WIDGET(box) == dialog->original_name_listbox) {
-    row = gtk_list_box_get_row_at_index(GTK_LIST_BOX(dialog->arrow_listbox),
-                                        index);
-    gtk_list_box_select_row(GTK_LIST_BOX(dialog->arrow_listbox), row);
-    row = gtk_list_box_get_row_at_index(GTK_LIST_BOX(dialog->result_listbox),
-                                        index);
-    gtk_list_box_select_row(GTK_LIST_BOX(dialog->result_listbox), row);
-  }
-
-  if (GTK_WIDGET(box) == dialog->arrow_listbox) {
-    row = gtk_list_box_get_row_at_index(
-        GTK_LIST_BOX(dialog->original_name_listbox), index);
-    gtk_list_box_select_row(GTK_LIST_BOX(dialog->original_name_listbox), row);
-    row = gtk_list_box_get_row_at_index(GTK_LIST_BOX(dialog->result_listbox),
-                                        index);
-    gtk_list_box_select_row(GTK_LIST_BOX(dialog->result_listbox), row);
-  }
-
-  if (GTK_WIDGET(box) == dialog->result_listbox) {
-    row = gtk_list_box_get_row_at_index(GTK_LIST_BOX(dialog->arrow_listbox),
-                                        index);
-    gtk_list_box_select_row(GTK_LIST_BOX(dialog->arrow_listbox), row);
-    row = gtk_list_box_get_row_at_index(
-        GTK_LIST_BOX(dialog->original_name_listbox), index);
-    gtk_list_box_select_row(GTK_LIST_BOX(dialog->original_name_listbox), row);
-  }
-}
-
 static gint compare_int(gconstpointer a, gconstpointer b) {
   int *number1 = (int *)a;
   int *number2 = (int *)b;
@@ -427,221 +391,231 @@ static void begin_batch_rename(NautilusBatchRenameDialog *dialog,
                         NULL);
 }
 
-static void listbox_header_func(GtkListBoxRow *row, GtkListBoxRow *before,
-                                NautilusBatchRenameDialog *dialog) {
-  GtkWidget *separator;
+static void prepare_batch_rename(NautilusBatchRenameDialog *dialog) {
+  GdkCursor *cursor;
+  GdkDisplay *display;
 
-  if (before == NULL) {
-    /* First row needs no separator */
-    gtk_list_box_row_set_header(row, NULL);
+  /* wait for checking conflicts to finish, to be sure that
+   * the rename can actually take place */
+  if (dialog->directories_pending_conflict_check != NULL) {
+    dialog->rename_clicked = TRUE;
     return;
   }
 
-  separator = gtk_list_box_row_get_header(row);
-  if (separator == NULL) {
-    separator = gtk_separator_new(GTK_ORIENTATION_HORIZONTAL);
-    gtk_widget_show(separator);
-
-    gtk_list_box_row_set_header(row, separator);
+  if (!gtk_widget_is_sensitive(dialog->rename_button)) {
+    return;
   }
-}
-
-/* This is manually done instead of using GtkSizeGroup because of the
- * computational complexity of the later.*/
-static void update_rows_height(NautilusBatchRenameDialog *dialog) {
-  GList *l;
-  GtkRequisition current_row_natural_size;
-  gint maximum_height;
 
-  maximum_height = -1;
+  display = gtk_widget_get_display(GTK_WIDGET(dialog->window));
+  cursor = gdk_cursor_new_from_name(display, "progress");
+  gdk_window_set_cursor(gtk_widget_get_window(GTK_WIDGET(dialog->window)),
+                        cursor);
+  g_object_unref(cursor);
 
-  /* check if maximum height has changed */
-  for (l = dialog->listbox_labels_new; l != NULL; l = l->next) {
-    gtk_widget_get_preferred_size(GTK_WIDGET(l->data), NULL,
-                                  &current_row_natural_size);
+  display = gtk_widget_get_display(GTK_WIDGET(dialog));
+  cursor = gdk_cursor_new_from_name(display, "progress");
+  gdk_window_set_cursor(gtk_widget_get_window(GTK_WIDGET(dialog)), cursor);
+  g_object_unref(cursor);
 
-    if (current_row_natural_size.height > maximum_height) {
-      maximum_height = current_row_natural_size.height;
-    }
-  }
+  gtk_widget_hide(GTK_WIDGET(dialog));
+  begin_batch_rename(dialog, dialog->new_names);
 
-  for (l = dialog->listbox_labels_old; l != NULL; l = l->next) {
-    gtk_widget_get_preferred_size(GTK_WIDGET(l->data), NULL,
-                                  &current_row_natural_size);
+  gtk_widget_destroy(GTK_WIDGET(dialog));
+}
 
-    if (current_row_natural_size.height > maximum_height) {
-      maximum_height = current_row_natural_size.height;
+static void batch_rename_dialog_on_response(NautilusBatchRenameDialog *dialog,
+                                            gint response_id,
+                                            gpointer user_data) {
+  if (response_id == GTK_RESPONSE_OK) {
+    prepare_batch_rename(dialog);
+  } else {
+    if (dialog->directories_pending_conflict_check != NULL) {
+      cancel_conflict_check(dialog);
     }
+
+    gtk_widget_destroy(GTK_WIDGET(dialog));
   }
+}
 
-  for (l = dialog->listbox_icons; l != NULL; l = l->next) {
-    gtk_widget_get_preferred_size(GTK_WIDGET(l->data), NULL,
-                                  &current_row_natural_size);
+static guint preview_get_row_index(GtkTreeModel *model, GtkTreeIter *iter) {
+  guint index;
 
-    if (current_row_natural_size.height > maximum_height) {
-      maximum_height = current_row_natural_size.height;
-    }
-  }
+  gtk_tree_model_get(model, iter, PREVIEW_COLUMN_INDEX, &index, -1);
 
-  if (maximum_height != dialog->row_height) {
-    dialog->row_height = maximum_height + ROW_MARGIN_TOP_BOTTOM * 2;
+  return index;
+}
 
-    for (l = dialog->listbox_icons; l != NULL; l = l->next) {
-      g_object_set(G_OBJECT(l->data), "height-request", dialog->row_height,
-                   NULL);
-    }
+static void preview_cell_set_conflict_style(NautilusBatchRenameDialog *dialog,
+                                            GtkCellRenderer *cell,
+                                            GtkTreeModel *model,
+                                            GtkTreeIter *iter, guint index) {
+  GtkTreeSelection *selection;
 
-    for (l = dialog->listbox_labels_new; l != NULL; l = l->next) {
-      g_object_set(G_OBJECT(l->data), "height-request", dialog->row_height,
-                   NULL);
-    }
+  if (!g_hash_table_contains(dialog->conflict_rows, GUINT_TO_POINTER(index))) {
+    g_object_set(cell, "cell-background-set", FALSE, "foreground-set", FALSE,
+                 NULL);
+    return;
+  }
 
-    for (l = dialog->listbox_labels_old; l != NULL; l = l->next) {
-      g_object_set(G_OBJECT(l->data), "height-request", dialog->row_height,
-                   NULL);
-    }
+  /* selected rows keep the theme colors, like .conflict-row:selected */
+  selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(dialog->preview_view));
+  g_object_set(cell, "cell-background-rgba", &dialog->conflict_bg, NULL);
+  if (gtk_tree_selection_iter_is_selected(selection, iter)) {
+    g_object_set(cell, "foreground-set", FALSE, NULL);
+  } else {
+    g_object_set(cell, "foreground-rgba", &dialog->conflict_fg, NULL);
   }
 }
 
-static GtkWidget *create_original_name_label(NautilusBatchRenameDialog *dialog,
-                                             const gchar *old_text) {
-  GtkWidget *label_old;
+static void original_name_cell_data_func(GtkTreeViewColumn *column,
+                                         GtkCellRenderer *cell,
+                                         GtkTreeModel *model,
+                                         GtkTreeIter *iter,
+                                         gpointer user_data) {
+  NautilusBatchRenameDialog *dialog;
+  g_autofree gchar *old_name = NULL;
+  GString *markup;
+  guint index;
 
-  label_old = gtk_label_new(old_text);
-  gtk_label_set_xalign(GTK_LABEL(label_old), 0.0);
-  gtk_widget_set_hexpand(label_old, TRUE);
-  gtk_widget_set_margin_start(label_old, ROW_MARGIN_START);
-  gtk_label_set_ellipsize(GTK_LABEL(label_old), PANGO_ELLIPSIZE_END);
+  dialog = NAUTILUS_BATCH_RENAME_DIALOG(user_data);
+  index = preview_get_row_index(model, iter);
+  if (index >= dialog->selection_index->len) {
+    return;
+  }
 
-  dialog->listbox_labels_old =
-      g_list_prepend(dialog->listbox_labels_old, label_old);
+  old_name = nautilus_file_get_name(
+      NAUTILUS_FILE(g_ptr_array_index(dialog->selection_index, index)));
 
-  gtk_widget_show_all(label_old);
+  if (dialog->mode == NAUTILUS_BATCH_RENAME_DIALOG_FORMAT) {
+    g_object_set(cell, "text", old_name, NULL);
+  } else {
+    markup = batch_rename_replace_label_text(
+        old_name, gtk_entry_get_text(GTK_ENTRY(dialog->find_entry)));
+    g_object_set(cell, "markup", markup->str, NULL);
+    g_string_free(markup, TRUE);
+  }
 
-  return label_old;
+  preview_cell_set_conflict_style(dialog, cell, model, iter, index);
 }
 
-static GtkWidget *create_result_label(NautilusBatchRenameDialog *dialog,
-                                      const gchar *new_text) {
-  GtkWidget *label_new;
-
-  label_new = gtk_label_new(new_text);
-  gtk_label_set_xalign(GTK_LABEL(label_new), 0.0);
-  gtk_widget_set_hexpand(label_new, TRUE);
-  gtk_widget_set_margin_start(label_new, ROW_MARGIN_START);
-  gtk_label_set_ellipsize(GTK_LABEL(label_new), PANGO_ELLIPSIZE_END);
+static void arrow_cell_data_func(GtkTreeViewColumn *column,
+                                 GtkCellRenderer *cell, GtkTreeModel *model,
+                                 GtkTreeIter *iter, gpointer user_data) {
+  NautilusBatchRenameDialog *dialog;
 
-  dialog->listbox_labels_new =
-      g_list_prepend(dialog->listbox_labels_new, label_new);
+  dialog = NAUTILUS_BATCH_RENAME_DIALOG(user_data);
 
-  gtk_widget_show_all(label_new);
+  if (gtk_widget_get_direction(dialog->preview_view) == GTK_TEXT_DIR_RTL) {
+    g_object_set(cell, "text", "←", NULL);
+  } else {
+    g_object_set(cell, "text", "→", NULL);
+  }
 
-  return label_new;
+  preview_cell_set_conflict_style(dialog, cell, model, iter,
+                                  preview_get_row_index(model, iter));
 }
 
-static GtkWidget *create_arrow(NautilusBatchRenameDialog *dialog,
-                               GtkTextDirection text_direction) {
-  GtkWidget *icon;
+static void result_cell_data_func(GtkTreeViewColumn *column,
+                                  GtkCellRenderer *cell, GtkTreeModel *model,
+                                  GtkTreeIter *iter, gpointer user_data) {
+  NautilusBatchRenameDialog *dialog;
+  GString *new_name;
+  guint index;
 
-  if (text_direction == GTK_TEXT_DIR_RTL) {
-    icon = gtk_label_new("←");
-  } else {
-    icon = gtk_label_new("→");
+  dialog = NAUTILUS_BATCH_RENAME_DIALOG(user_data);
+  index = preview_get_row_index(model, iter);
+  if (index >= dialog->new_names_index->len) {
+    g_object_set(cell, "text", "", NULL);
+    return;
   }
 
-  gtk_label_set_xalign(GTK_LABEL(icon), 1.0);
-  gtk_widget_set_hexpand(icon, FALSE);
-  gtk_widget_set_margin_start(icon, ROW_MARGIN_START);
-
-  dialog->listbox_icons = g_list_prepend(dialog->listbox_icons, icon);
+  new_name = g_ptr_array_index(dialog->new_names_index, index);
+  g_object_set(cell, "text", new_name->str, NULL);
 
-  gtk_widget_show_all(icon);
-
-  return icon;
+  preview_cell_set_conflict_style(dialog, cell, model, iter, index);
 }
 
-static void prepare_batch_rename(NautilusBatchRenameDialog *dialog) {
-  GdkCursor *cursor;
-  GdkDisplay *display;
+static gboolean on_preview_query_tooltip(GtkWidget *widget, gint x, gint y,
+                                         gboolean keyboard_mode,
+                                         GtkTooltip *tooltip,
+                                         gpointer user_data) {
+  NautilusBatchRenameDialog *dialog;
+  g_autoptr(GtkTreePath) path = NULL;
+  g_autofree gchar *old_name = NULL;
+  GtkTreeViewColumn *column;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+  GString *new_name;
+  guint index;
 
-  /* wait for checking conflicts to finish, to be sure that
-   * the rename can actually take place */
-  if (dialog->directories_pending_conflict_check != NULL) {
-    dialog->rename_clicked = TRUE;
-    return;
+  dialog = NAUTILUS_BATCH_RENAME_DIALOG(user_data);
+
+  if (!gtk_tree_view_get_tooltip_context(GTK_TREE_VIEW(widget), &x, &y,
+                                         keyboard_mode, &model, &path, &iter)) {
+    return FALSE;
   }
 
-  if (!gtk_widget_is_sensitive(dialog->rename_button)) {
-    return;
+  if (keyboard_mode ||
+      !gtk_tree_view_get_path_at_pos(GTK_TREE_VIEW(widget), x, y, NULL,
+                                     &column, NULL, NULL)) {
+    column = dialog->result_column;
   }
 
-  display = gtk_widget_get_display(GTK_WIDGET(dialog->window));
-  cursor = gdk_cursor_new_from_name(display, "progress");
-  gdk_window_set_cursor(gtk_widget_get_window(GTK_WIDGET(dialog->window)),
-                        cursor);
-  g_object_unref(cursor);
+  index = preview_get_row_index(model, &iter);
 
-  display = gtk_widget_get_display(GTK_WIDGET(dialog));
-  cursor = gdk_cursor_new_from_name(display, "progress");
-  gdk_window_set_cursor(gtk_widget_get_window(GTK_WIDGET(dialog)), cursor);
-  g_object_unref(cursor);
+  if (column == dialog->original_name_column &&
+      index < dialog->selection_index->len) {
+    old_name = nautilus_file_get_name(
+        NAUTILUS_FILE(g_ptr_array_index(dialog->selection_index, index)));
+    gtk_tooltip_set_text(tooltip, old_name);
+  } else if (column == dialog->result_column &&
+             index < dialog->new_names_index->len) {
+    new_name = g_ptr_array_index(dialog->new_names_index, index);
+    gtk_tooltip_set_text(tooltip, new_name->str);
+  } else {
+    return FALSE;
+  }
 
-  gtk_widget_hide(GTK_WIDGET(dialog));
-  begin_batch_rename(dialog, dialog->new_names);
+  gtk_tree_view_set_tooltip_cell(GTK_TREE_VIEW(widget), tooltip, path, column,
+                                 NULL);
 
-  gtk_widget_destroy(GTK_WIDGET(dialog));
+  return TRUE;
 }
 
-static void batch_rename_dialog_on_response(NautilusBatchRenameDialog *dialog,
-                                            gint response_id,
-                                            gpointer user_data) {
-  if (response_id == GTK_RESPONSE_OK) {
-    prepare_batch_rename(dialog);
-  } else {
-    if (dialog->directories_pending_conflict_check != NULL) {
-      cancel_conflict_check(dialog);
-    }
+static void update_preview_index(NautilusBatchRenameDialog *dialog) {
+  GList *l;
 
-    gtk_widget_destroy(GTK_WIDGET(dialog));
+  g_ptr_array_set_size(dialog->selection_index, 0);
+  for (l = dialog->selection; l != NULL; l = l->next) {
+    g_ptr_array_add(dialog->selection_index, l->data);
   }
-}
 
-static void fill_display_listbox(NautilusBatchRenameDialog *dialog) {
-  GtkWidget *row_child;
-  GList *l1;
-  GList *l2;
-  NautilusFile *file;
-  GString *new_name;
-  gchar *name;
-  GtkTextDirection text_direction;
-
-  gtk_size_group_add_widget(dialog->size_group, dialog->result_listbox);
-  gtk_size_group_add_widget(dialog->size_group, dialog->original_name_listbox);
-
-  text_direction = gtk_widget_get_direction(GTK_WIDGET(dialog));
+  g_ptr_array_set_size(dialog->new_names_index, 0);
+  for (l = dialog->new_names; l != NULL; l = l->next) {
+    g_ptr_array_add(dialog->new_names_index, l->data);
+  }
 
-  for (l1 = dialog->new_names, l2 = dialog->selection; l1 != NULL && l2 != NULL;
-       l1 = l1->next, l2 = l2->next) {
-    file = NAUTILUS_FILE(l2->data);
-    new_name = l1->data;
+  g_hash_table_remove_all(dialog->conflict_rows);
 
-    name = nautilus_file_get_name(file);
-    row_child = create_original_name_label(dialog, name);
-    gtk_list_box_insert(GTK_LIST_BOX(dialog->original_name_listbox), row_child,
-                        -1);
+  /* only the visible rows are redrawn */
+  gtk_widget_queue_draw(dialog->preview_view);
+}
 
-    row_child = create_arrow(dialog, text_direction);
-    gtk_list_box_insert(GTK_LIST_BOX(dialog->arrow_listbox), row_child, -1);
+static void fill_display_listbox(NautilusBatchRenameDialog *dialog) {
+  guint n_rows;
+  guint i;
 
-    row_child = create_result_label(dialog, new_name->str);
-    gtk_list_box_insert(GTK_LIST_BOX(dialog->result_listbox), row_child, -1);
+  n_rows = g_list_length(dialog->selection);
 
-    g_free(name);
+  /* The rows are inserted detached from the view, so that the tree view
+   * doesn't process each insertion. */
+  gtk_tree_view_set_model(GTK_TREE_VIEW(dialog->preview_view), NULL);
+  for (i = 0; i < n_rows; i++) {
+    gtk_list_store_insert_with_values(dialog->preview_model, NULL, -1,
+                                      PREVIEW_COLUMN_INDEX, i, -1);
   }
-
-  dialog->listbox_labels_old = g_list_reverse(dialog->listbox_labels_old);
-  dialog->listbox_labels_new = g_list_reverse(dialog->listbox_labels_new);
-  dialog->listbox_icons = g_list_reverse(dialog->listbox_icons);
+  gtk_tree_view_set_model(GTK_TREE_VIEW(dialog->preview_view),
+                          GTK_TREE_MODEL(dialog->preview_model));
 }
 
 static void select_nth_conflict(NautilusBatchRenameDialog *dialog) {
@@ -652,10 +626,8 @@ static void select_nth_conflict(NautilusBatchRenameDialog *dialog) {
   gint nth_conflict_index;
   gint nth_conflict;
   gint name_occurences;
-  GtkAdjustment *adjustment;
-  GtkAllocation allocation;
   ConflictData *conflict_data;
-  GtkListBoxRow *list_box_row;
+  GtkTreePath *path;
 
   nth_conflict = dialog->selected_conflict;
   l = g_list_nth(dialog->duplicates, nth_conflict);
@@ -667,25 +639,13 @@ static void select_nth_conflict(NautilusBatchRenameDialog *dialog) {
 
   nth_conflict_index = conflict_data->index;
 
-  l = g_list_nth(dialog->listbox_labels_new, nth_conflict_index);
-  list_box_row = GTK_LIST_BOX_ROW(gtk_widget_get_parent(l->data));
-  gtk_list_box_select_row(GTK_LIST_BOX(dialog->original_name_listbox),
-                          list_box_row);
-
-  l = g_list_nth(dialog->listbox_labels_old, nth_conflict_index);
-  list_box_row = GTK_LIST_BOX_ROW(gtk_widget_get_parent(l->data));
-  gtk_list_box_select_row(GTK_LIST_BOX(dialog->arrow_listbox), list_box_row);
-
-  l = g_list_nth(dialog->listbox_icons, nth_conflict_index);
-  list_box_row = GTK_LIST_BOX_ROW(gtk_widget_get_parent(l->data));
-  gtk_list_box_select_row(GTK_LIST_BOX(dialog->result_listbox), list_box_row);
-
-  /* scroll to the selected row */
-  adjustment = gtk_scrolled_window_get_vadjustment(
-      GTK_SCROLLED_WINDOW(dialog->scrolled_window));
-  gtk_widget_get_allocation(GTK_WIDGET(l->data), &allocation);
-  gtk_adjustment_set_value(adjustment,
-                           (allocation.height + 1) * nth_conflict_index);
+  /* select and scroll to the row, without needing it to be realized */
+  path = gtk_tree_path_new_from_indices(nth_conflict_index, -1);
+  gtk_tree_selection_select_path(
+      gtk_tree_view_get_selection(GTK_TREE_VIEW(dialog->preview_view)), path);
+  gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(dialog->preview_view), path, NULL,
+                               TRUE, 0.5, 0.0);
+  gtk_tree_path_free(path);
 
   name_occurences = 0;
   for (l = dialog->new_names; l != NULL; l = l->next) {
@@ -738,102 +698,29 @@ static void select_next_conflict_up(NautilusBatchRenameDialog *dialog) {
   select_nth_conflict(dialog);
 }
 
-static void update_conflict_row_background(NautilusBatchRenameDialog *dialog) {
-  GList *l1;
-  GList *l2;
-  GList *l3;
-  GList *duplicates;
-  gint index;
-  GtkStyleContext *context;
-  ConflictData *conflict_data;
-
-  index = 0;
-
-  duplicates = dialog->duplicates;
-
-  for (l1 = dialog->listbox_labels_new, l2 = dialog->listbox_labels_old,
-      l3 = dialog->listbox_icons;
-       l1 != NULL && l2 != NULL && l3 != NULL;
-       l1 = l1->next, l2 = l2->next, l3 = l3->next) {
-    GtkWidget *row1 = gtk_widget_get_parent(l1->data);
-    GtkWidget *row2 = gtk_widget_get_parent(l2->data);
-    GtkWidget *row3 = gtk_widget_get_parent(l3->data);
-
-    context = gtk_widget_get_style_context(row1);
-
-    if (gtk_style_context_has_class(context, "conflict-row")) {
-      gtk_style_context_remove_class(context, "conflict-row");
-
-      context = gtk_widget_get_style_context(row2);
-      gtk_style_context_remove_class(context, "conflict-row");
-
-      context = gtk_widget_get_style_context(row3);
-      gtk_style_context_remove_class(context, "conflict-row");
-    }
-
-    if (duplicates != NULL) {
-      conflict_data = duplicates->data;
-      if (conflict_data->index == index) {
-        context = gtk_widget_get_style_context(row1);
-        gtk_style_context_add_class(context, "conflict-row");
-
-        context = gtk_widget_get_style_context(row2);
-        gtk_style_context_add_class(context, "conflict-row");
-
-        context = gtk_widget_get_style_context(row3);
-        gtk_style_context_add_class(context, "conflict-row");
-
-        duplicates = duplicates->next;
-      }
-    }
-    index++;
-  }
-}
-
 static void update_listbox(NautilusBatchRenameDialog *dialog) {
-  GList *l1;
-  GList *l2;
-  NautilusFile *file;
-  gchar *old_name;
-  GtkLabel *label;
+  GList *l;
   GString *new_name;
+  ConflictData *conflict_data;
   gboolean empty_name = FALSE;
 
-  for (l1 = dialog->new_names, l2 = dialog->listbox_labels_new;
-       l1 != NULL && l2 != NULL; l1 = l1->next, l2 = l2->next) {
-    label = GTK_LABEL(l2->data);
-    new_name = l1->data;
-
-    gtk_label_set_label(label, new_name->str);
-    gtk_widget_set_tooltip_text(GTK_WIDGET(label), new_name->str);
+  for (l = dialog->new_names; l != NULL; l = l->next) {
+    new_name = l->data;
 
     if (g_strcmp0(new_name->str, "") == 0) {
       empty_name = TRUE;
+      break;
     }
   }
 
-  for (l1 = dialog->selection, l2 = dialog->listbox_labels_old;
-       l1 != NULL && l2 != NULL; l1 = l1->next, l2 = l2->next) {
-    label = GTK_LABEL(l2->data);
-    file = NAUTILUS_FILE(l1->data);
-
-    old_name = nautilus_file_get_name(file);
-    gtk_widget_set_tooltip_text(GTK_WIDGET(label), old_name);
-
-    if (dialog->mode == NAUTILUS_BATCH_RENAME_DIALOG_FORMAT) {
-      gtk_label_set_label(label, old_name);
-    } else {
-      new_name = batch_rename_replace_label_text(
-          old_name, gtk_entry_get_text(GTK_ENTRY(dialog->find_entry)));
-      gtk_label_set_markup(GTK_LABEL(label), new_name->str);
-
-      g_string_free(new_name, TRUE);
-    }
-
-    g_free(old_name);
+  g_hash_table_remove_all(dialog->conflict_rows);
+  for (l = dialog->duplicates; l != NULL; l = l->next) {
+    conflict_data = l->data;
+    g_hash_table_add(dialog->conflict_rows,
+                     GUINT_TO_POINTER(conflict_data->index));
   }
 
-  update_rows_height(dialog);
+  gtk_widget_queue_draw(dialog->preview_view);
 
   if (empty_name) {
     gtk_widget_set_sensitive(dialog->rename_button, FALSE);
@@ -843,8 +730,6 @@ static void update_listbox(NautilusBatchRenameDialog *dialog) {
 
   /* check if there are name conflicts and display them if they exist */
   if (dialog->duplicates != NULL) {
-    update_conflict_row_background(dialog);
-
     gtk_widget_set_sensitive(dialog->rename_button, FALSE);
 
     gtk_widget_show(dialog->conflict_box);
@@ -867,7 +752,6 @@ static void update_listbox(NautilusBatchRenameDialog *dialog) {
     /* re-enable the rename button if there are no more name conflicts */
     if (dialog->duplicates == NULL &&
         !gtk_widget_is_sensitive(dialog->rename_button)) {
-      update_conflict_row_background(dialog);
       gtk_widget_set_sensitive(dialog->rename_button, TRUE);
     }
   }
@@ -901,6 +785,7 @@ static void check_conflict_for_files(NautilusBatchRenameDialog *dialog,
   gboolean tag_present;
   gboolean same_parent_directory;
   ConflictData *conflict_data;
+  gint index;
 
   current_directory = nautilus_directory_get_uri(directory);
 
@@ -941,8 +826,8 @@ static void check_conflict_for_files(NautilusBatchRenameDialog *dialog,
                         GINT_TO_POINTER(TRUE));
   }
 
-  for (l1 = dialog->selection, l2 = dialog->new_names; l1 != NULL && l2 != NULL;
-       l1 = l1->next, l2 = l2->next) {
+  for (l1 = dialog->selection, l2 = dialog->new_names, index = 0;
+       l1 != NULL && l2 != NULL; l1 = l1->next, l2 = l2->next, index++) {
     file = NAUTILUS_FILE(l1->data);
 
     name = nautilus_file_get_name(file);
@@ -967,7 +852,7 @@ static void check_conflict_for_files(NautilusBatchRenameDialog *dialog,
               dialog->selection, dialog->new_names, new_name, parent_uri)) {
         conflict_data = g_new(ConflictData, 1);
         conflict_data->name = g_strdup(new_name->str);
-        conflict_data->index = g_list_index(dialog->selection, l1->data);
+        conflict_data->index = index;
         dialog->duplicates = g_list_prepend(dialog->duplicates, conflict_data);
 
         have_conflict = TRUE;
@@ -982,7 +867,7 @@ static void check_conflict_for_files(NautilusBatchRenameDialog *dialog,
       if (tag_present && same_parent_directory) {
         conflict_data = g_new(ConflictData, 1);
         conflict_data->name = g_strdup(new_name->str);
-        conflict_data->index = g_list_index(dialog->selection, l1->data);
+        conflict_data->index = index;
         dialog->duplicates = g_list_prepend(dialog->duplicates, conflict_data);
 
         have_conflict = TRUE;
@@ -1191,6 +1076,7 @@ static void update_display_text(NautilusBatchRenameDialog *dialog) {
   }
 
   dialog->new_names = batch_rename_dialog_get_new_names(dialog);
+  update_preview_index(dialog);
 
   if (have_unallowed_character(dialog)) {
     return;
@@ -1301,88 +1187,6 @@ void nautilus_batch_rename_dialog_query_finished(
   }
 }
 
-static void update_row_shadowing(GtkWidget *row, gboolean shown) {
-  GtkStyleContext *context;
-  GtkStateFlags flags;
-
-  if (!GTK_IS_LIST_BOX_ROW(row)) {
-    return;
-  }
-
-  context = gtk_widget_get_style_context(row);
-  flags = gtk_style_context_get_state(context);
-
-  if (shown) {
-    flags |= GTK_STATE_FLAG_PRELIGHT;
-  } else {
-    flags &= ~GTK_STATE_FLAG_PRELIGHT;
-  }
-
-  gtk_style_context_set_state(context, flags);
-}
-
-static void
-on_event_controller_motion_motion(GtkEventControllerMotion *controller,
-                                  double x, double y, gpointer user_data) {
-  GtkWidget *widget;
-  NautilusBatchRenameDialog *dialog;
-  GtkListBoxRow *row;
-
-  widget = gtk_event_controller_get_widget(GTK_EVENT_CONTROLLER(controller));
-  dialog = NAUTILUS_BATCH_RENAME_DIALOG(user_data);
-
-  if (dialog->preselected_row1 && dialog->preselected_row2) {
-    update_row_shadowing(dialog->preselected_row1, FALSE);
-    update_row_shadowing(dialog->preselected_row2, FALSE);
-  }
-
-  if (widget == dialog->result_listbox) {
-    row = gtk_list_box_get_row_at_y(GTK_LIST_BOX(dialog->original_name_listbox),
-                                    y);
-    update_row_shadowing(GTK_WIDGET(row), TRUE);
-    dialog->preselected_row1 = GTK_WIDGET(row);
-
-    row = gtk_list_box_get_row_at_y(GTK_LIST_BOX(dialog->arrow_listbox), y);
-    update_row_shadowing(GTK_WIDGET(row), TRUE);
-    dialog->preselected_row2 = GTK_WIDGET(row);
-  }
-
-  if (widget == dialog->arrow_listbox) {
-    row = gtk_list_box_get_row_at_y(GTK_LIST_BOX(dialog->original_name_listbox),
-                                    y);
-    update_row_shadowing(GTK_WIDGET(row), TRUE);
-    dialog->preselected_row1 = GTK_WIDGET(row);
-
-    row = gtk_list_box_get_row_at_y(GTK_LIST_BOX(dialog->result_listbox), y);
-    update_row_shadowing(GTK_WIDGET(row), TRUE);
-    dialog->preselected_row2 = GTK_WIDGET(row);
-  }
-
-  if (widget == dialog->original_name_listbox) {
-    row = gtk_list_box_get_row_at_y(GTK_LIST_BOX(dialog->result_listbox), y);
-    update_row_shadowing(GTK_WIDGET(row), TRUE);
-    dialog->preselected_row1 = GTK_WIDGET(row);
-
-    row = gtk_list_box_get_row_at_y(GTK_LIST_BOX(dialog->arrow_listbox), y);
-    update_row_shadowing(GTK_WIDGET(row), TRUE);
-    dialog->preselected_row2 = GTK_WIDGET(row);
-  }
-}
-
-static void
-on_event_controller_motion_leave(GtkEventControllerMotion *controller,
-                                 gpointer user_data) {
-  NautilusBatchRenameDialog *dialog;
-
-  dialog = NAUTILUS_BATCH_RENAME_DIALOG(user_data);
-
-  update_row_shadowing(dialog->preselected_row1, FALSE);
-  update_row_shadowing(dialog->preselected_row2, FALSE);
-
-  dialog->preselected_row1 = NULL;
-  dialog->preselected_row2 = NULL;
-}
-
 static void nautilus_batch_rename_dialog_initialize_actions(
     NautilusBatchRenameDialog *dialog) {
   GAction *action;
@@ -1602,9 +1406,7 @@ static void nautilus_batch_rename_dialog_finalize(GObject *object) {
 
   g_clear_object(&dialog->numbering_order_menu);
   g_clear_object(&dialog->add_tag_menu);
-  g_list_free(dialog->listbox_labels_new);
-  g_list_free(dialog->listbox_labels_old);
-  g_list_free(dialog->listbox_icons);
+  g_clear_object(&dialog->preview_model);
 
   for (l = dialog->selection_metadata; l != NULL; l = l->next) {
     FileMetadata *file_metadata;
@@ -1626,14 +1428,14 @@ static void nautilus_batch_rename_dialog_finalize(GObject *object) {
 
   g_list_free_full(dialog->new_names, string_free);
   g_list_free_full(dialog->duplicates, conflict_data_free);
+  g_ptr_array_unref(dialog->selection_index);
+  g_ptr_array_unref(dialog->new_names_index);
+  g_hash_table_destroy(dialog->conflict_rows);
 
   nautilus_file_list_free(dialog->selection);
   nautilus_directory_unref(dialog->directory);
   nautilus_directory_list_free(dialog->distinct_parent_directories);
 
-  g_object_unref(dialog->size_group);
-  g_clear_list(&dialog->motion_controllers, g_object_unref);
-
   g_hash_table_destroy(dialog->tag_info_table);
 
   g_cancellable_cancel(dialog->metadata_cancellable);
@@ -1660,11 +1462,7 @@ nautilus_batch_rename_dialog_class_init(NautilusBatchRenameDialogClass *klass) {
   gtk_widget_class_bind_template_child(widget_class, NautilusBatchRenameDialog,
                                        cancel_button);
   gtk_widget_class_bind_template_child(widget_class, NautilusBatchRenameDialog,
-                                       original_name_listbox);
-  gtk_widget_class_bind_template_child(widget_class, NautilusBatchRenameDialog,
-                                       arrow_listbox);
-  gtk_widget_class_bind_template_child(widget_class, NautilusBatchRenameDialog,
-                                       result_listbox);
+                                       preview_view);
   gtk_widget_class_bind_template_child(widget_class, NautilusBatchRenameDialog,
                                        name_entry);
   gtk_widget_class_bind_template_child(widget_class, NautilusBatchRenameDialog,
@@ -1801,19 +1599,65 @@ GtkWidget *nautilus_batch_rename_dialog_new(GList *selection,
   return GTK_WIDGET(dialog);
 }
 
-static void connect_to_pointer_motion_events(NautilusBatchRenameDialog *self,
-                                             GtkWidget *listbox) {
-  GtkEventController *controller;
+static GtkTreeViewColumn *
+append_preview_column(NautilusBatchRenameDialog *self, gboolean expand,
+                      gfloat xalign, GtkTreeCellDataFunc cell_data_func) {
+  GtkTreeViewColumn *column;
+  GtkCellRenderer *cell;
+
+  cell = gtk_cell_renderer_text_new();
+  g_object_set(cell, "xalign", xalign, "xpad", ROW_MARGIN_START, "ypad",
+               ROW_MARGIN_TOP_BOTTOM, NULL);
+  if (expand) {
+    g_object_set(cell, "ellipsize", PANGO_ELLIPSIZE_END, NULL);
+  }
+
+  column = gtk_tree_view_column_new();
+  /* fixed sizing is required by the fixed height mode of the view */
+  gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
+  gtk_tree_view_column_set_expand(column, expand);
+  if (expand) {
+    /* the name columns share the width left by the arrow column */
+    gtk_tree_view_column_set_fixed_width(column, 1);
+  }
+  gtk_tree_view_column_pack_start(column, cell, TRUE);
+  gtk_tree_view_column_set_cell_data_func(column, cell, cell_data_func, self,
+                                          NULL);
+  gtk_tree_view_append_column(GTK_TREE_VIEW(self->preview_view), column);
+
+  return column;
+}
 
-  controller = gtk_event_controller_motion_new(listbox);
-  gtk_event_controller_set_propagation_phase(controller, GTK_PHASE_CAPTURE);
-  g_signal_connect(controller, "leave",
-                   G_CALLBACK(on_event_controller_motion_leave), self);
-  g_signal_connect(controller, "motion",
-                   G_CALLBACK(on_event_controller_motion_motion), self);
+static void setup_preview_view(NautilusBatchRenameDialog *self) {
+  GtkStyleContext *context;
 
-  self->motion_controllers =
-      g_list_prepend(self->motion_controllers, controller);
+  self->preview_model = gtk_list_store_new(PREVIEW_NUM_COLUMNS, G_TYPE_UINT);
+  gtk_tree_view_set_model(GTK_TREE_VIEW(self->preview_view),
+                          GTK_TREE_MODEL(self->preview_model));
+
+  self->original_name_column = append_preview_column(
+      self, TRUE, 0.0, original_name_cell_data_func);
+  self->arrow_column =
+      append_preview_column(self, FALSE, 1.0, arrow_cell_data_func);
+  gtk_tree_view_column_set_fixed_width(self->arrow_column, ARROW_COLUMN_WIDTH);
+  self->result_column =
+      append_preview_column(self, TRUE, 0.0, result_cell_data_func);
+
+  gtk_widget_set_has_tooltip(self->preview_view, TRUE);
+  g_signal_connect(self->preview_view, "query-tooltip",
+                   G_CALLBACK(on_preview_query_tooltip), self);
+
+  /* conflict rows use the same colors as the .conflict-row style class */
+  context = gtk_widget_get_style_context(self->preview_view);
+  if (!gtk_style_context_lookup_color(context, "conflict_bg",
+                                      &self->conflict_bg)) {
+    gdk_rgba_parse(&self->conflict_bg, "#fef6b6");
+  }
+  gdk_rgba_parse(&self->conflict_fg, "black");
+
+  self->selection_index = g_ptr_array_new();
+  self->new_names_index = g_ptr_array_new();
+  self->conflict_rows = g_hash_table_new(g_direct_hash, g_direct_equal);
 }
 
 static void nautilus_batch_rename_dialog_init(NautilusBatchRenameDialog *self) {
@@ -1823,15 +1667,7 @@ static void nautilus_batch_rename_dialog_init(NautilusBatchRenameDialog *self) {
 
   gtk_widget_init_template(GTK_WIDGET(self));
 
-  gtk_list_box_set_header_func(GTK_LIST_BOX(self->original_name_listbox),
-                               (GtkListBoxUpdateHeaderFunc)listbox_header_func,
-                               self, NULL);
-  gtk_list_box_set_header_func(GTK_LIST_BOX(self->arrow_listbox),
-                               (GtkListBoxUpdateHeaderFunc)listbox_header_func,
-                               self, NULL);
-  gtk_list_box_set_header_func(GTK_LIST_BOX(self->result_listbox),
-                               (GtkListBoxUpdateHeaderFunc)listbox_header_func,
-                               self, NULL);
+  setup_preview_view(self);
 
   self->mode = NAUTILUS_BATCH_RENAME_DIALOG_FORMAT;
 
@@ -1889,20 +1725,5 @@ static void nautilus_batch_rename_dialog_init(NautilusBatchRenameDialog *self) {
                         tag_data);
   }
 
-  self->row_height = -1;
-
-  g_signal_connect(self->original_name_listbox, "row-selected",
-                   G_CALLBACK(row_selected), self);
-  g_signal_connect(self->arrow_listbox, "row-selected",
-                   G_CALLBACK(row_selected), self);
-  g_signal_connect(self->result_listbox, "row-selected",
-                   G_CALLBACK(row_selected), self);
-
-  self->size_group = gtk_size_group_new(GTK_SIZE_GROUP_HORIZONTAL);
-
-  connect_to_pointer_motion_events(self, self->original_name_listbox);
-  connect_to_pointer_motion_events(self, self->result_listbox);
-  connect_to_pointer_motion_events(self, self->arrow_listbox);
-
   self->metadata_cancellable = g_cancellable_new();
 }
@@ -105,6 +105,11 @@
 /* Copied from NautilusFile */
 #define UNDEFINED_TIME ((time_t) (-1))
 
+/* Measured label sizes kept, per icon, before the cache is emptied. A few
+ * per icon let zooming back and forth reuse the sizes of every level. */
+#define LABEL_SIZES_PER_ICON 4
+#define MIN_LABEL_SIZES 1024
+
 enum
 {
     ACTION_ACTIVATE,
@@ -1435,6 +1440,97 @@ button_event_modifies_selection (GdkEventButton *event)
     return (event->state & (GDK_CONTROL_MASK | GDK_SHIFT_MASK)) != 0;
 }
 
+/* The key covers everything the measured size depends on, so sizes measured
+ * for another zoom level or ellipsis limit stay valid for when they are used
+ * again. The serial of the Pango context changes with the font settings.
+ * Both texts may hold any character, so each one is preceded by its length
+ * for two different pairs of texts to never make the same key. */
+char *
+nautilus_canvas_container_get_label_size_key (NautilusCanvasContainer *container,
+                                              const char              *editable_text,
+                                              const char              *additional_text,
+                                              int                      max_text_width,
+                                              gboolean                 entire_text)
+{
+    PangoContext *context;
+
+    context = gtk_widget_get_pango_context (GTK_WIDGET (container));
+
+    if (editable_text == NULL)
+    {
+        editable_text = "";
+    }
+    if (additional_text == NULL)
+    {
+        additional_text = "";
+    }
+
+    return g_strdup_printf ("%u %d %d %d %" G_GSIZE_FORMAT ":%s%" G_GSIZE_FORMAT ":%s",
+                            pango_context_get_serial (context),
+                            max_text_width,
+                            entire_text ? G_MININT : nautilus_canvas_container_get_max_layout_lines_for_pango (container),
+                            nautilus_canvas_container_get_max_layout_lines (container),
+                            strlen (editable_text), editable_text,
+                            strlen (additional_text), additional_text);
+}
+
+gboolean
+nautilus_canvas_container_lookup_label_size (NautilusCanvasContainer *container,
+                                             const char              *key,
+                                             NautilusCanvasLabelSize *size)
+{
+    NautilusCanvasLabelSize *cached;
+
+    if (container->details->label_sizes == NULL)
+    {
+        return FALSE;
+    }
+
+    cached = g_hash_table_lookup (container->details->label_sizes, key);
+    if (cached == NULL)
+    {
+        return FALSE;
+    }
+
+    *size = *cached;
+
+    return TRUE;
+}
+
+void
+nautilus_canvas_container_store_label_size (NautilusCanvasContainer       *container,
+                                            const char                    *key,
+                                            const NautilusCanvasLabelSize *size)
+{
+    NautilusCanvasContainerDetails *details;
+    guint max_sizes;
+
+    details = container->details;
+
+    if (details->label_sizes == NULL)
+    {
+        details->label_sizes = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                      g_free, g_free);
+    }
+
+    max_sizes = MAX (MIN_LABEL_SIZES,
+                     LABEL_SIZES_PER_ICON * g_hash_table_size (details->icon_set));
+    if (g_hash_table_size (details->label_sizes) >= max_sizes)
+    {
+        g_hash_table_remove_all (details->label_sizes);
+    }
+
+    g_hash_table_insert (details->label_sizes,
+                         g_strdup (key),
+                         g_memdup (size, sizeof (NautilusCanvasLabelSize)));
+}
+
+static void
+clear_label_sizes (NautilusCanvasContainer *container)
+{
+    g_clear_pointer (&container->details->label_sizes, g_hash_table_destroy);
+}
+
 /* invalidate the cached label sizes for all the icons */
 static void
 invalidate_label_sizes (NautilusCanvasContainer *container)
@@ -3001,6 +3097,7 @@ finalize (GObject *object)
     details->icon_set = NULL;
 
     g_free (details->font);
+    g_clear_pointer (&details->label_sizes, g_hash_table_destroy);
 
     if (details->a11y_item_action_queue != NULL)
     {
@@ -3225,6 +3322,9 @@ style_updated (GtkWidget *widget)
 
     GTK_WIDGET_CLASS (nautilus_canvas_container_parent_class)->style_updated (widget);
 
+    /* Sizes measured with the old style won't be used again */
+    clear_label_sizes (container);
+
     if (gtk_widget_get_realized (widget))
     {
         nautilus_canvas_container_request_update_all_internal (container, TRUE);
@@ -5700,6 +5800,8 @@ nautilus_canvas_container_set_font (NautilusCanvasContainer *container,
     g_free (container->details->font);
     container->details->font = g_strdup (font);
 
+    clear_label_sizes (container);
+
     nautilus_canvas_container_request_update_all_internal (container, TRUE);
     gtk_widget_queue_draw (GTK_WIDGET (container));
 }
@@ -5739,16 +5841,23 @@ void
 nautilus_canvas_container_set_highlighted_for_clipboard (NautilusCanvasContainer *container,
                                                          GList                   *clipboard_canvas_data)
 {
+    g_autoptr (GHashTable) clipboard_data = NULL;
     GList *l;
     NautilusCanvasIcon *icon;
     gboolean highlighted_for_clipboard;
 
     g_return_if_fail (NAUTILUS_IS_CANVAS_CONTAINER (container));
 
+    clipboard_data = g_hash_table_new (NULL, NULL);
+    for (l = clipboard_canvas_data; l != NULL; l = l->next)
+    {
+        g_hash_table_add (clipboard_data, l->data);
+    }
+
     for (l = container->details->icons; l != NULL; l = l->next)
     {
         icon = l->data;
-        highlighted_for_clipboard = (g_list_find (clipboard_canvas_data, icon->data) != NULL);
+        highlighted_for_clipboard = g_hash_table_contains (clipboard_data, icon->data);
 
         eel_canvas_item_set (EEL_CANVAS_ITEM (icon->item),
                              "highlighted-for-clipboard", highlighted_for_clipboard,
@@ -799,24 +799,33 @@ prepare_pango_layout_for_measure_entire_text (NautilusCanvasItem *item,
     pango_layout_set_height (layout, G_MININT);
 }
 
+/* Whether the whole label is shown, instead of the first lines only */
+static gboolean
+label_shows_entire_text (NautilusCanvasItem *item)
+{
+    NautilusCanvasItemDetails *details;
+    gboolean needs_highlight;
+
+    details = item->details;
+
+    needs_highlight = details->is_highlighted_for_selection || details->is_highlighted_for_drop;
+
+    return needs_highlight ||
+           details->is_highlighted_as_keyboard_focus ||
+           details->entire_text;
+}
+
 static void
 prepare_pango_layout_for_draw (NautilusCanvasItem *item,
                                PangoLayout        *layout)
 {
-    NautilusCanvasItemDetails *details;
     NautilusCanvasContainer *container;
-    gboolean needs_highlight;
 
     prepare_pango_layout_width (item, layout);
 
     container = NAUTILUS_CANVAS_CONTAINER (EEL_CANVAS_ITEM (item)->canvas);
-    details = item->details;
-
-    needs_highlight = details->is_highlighted_for_selection || details->is_highlighted_for_drop;
 
-    if (needs_highlight ||
-        details->is_highlighted_as_keyboard_focus ||
-        details->entire_text)
+    if (label_shows_entire_text (item))
     {
         /* VOODOO-TODO, cf. compute_text_rectangle() */
         pango_layout_set_height (layout, G_MININT);
@@ -842,6 +851,8 @@ measure_label_text (NautilusCanvasItem *item)
     PangoLayout *editable_layout;
     PangoLayout *additional_layout;
     gboolean have_editable, have_additional;
+    g_autofree char *size_key = NULL;
+    NautilusCanvasLabelSize size;
 
     /* check to see if the cached values are still valid; if so, there's
      * no work necessary
@@ -876,6 +887,26 @@ measure_label_text (NautilusCanvasItem *item)
     return;
 #endif
 
+    container = NAUTILUS_CANVAS_CONTAINER (EEL_CANVAS_ITEM (item)->canvas);
+
+    /* Labels with the same text are laid out the same, so they are only
+     * shaped once per container, zoom level and ellipsis limit */
+    size_key = nautilus_canvas_container_get_label_size_key (container,
+                                                             have_editable ? details->editable_text : NULL,
+                                                             have_additional ? details->additional_text : NULL,
+                                                             floor (nautilus_canvas_item_get_max_text_width (item)),
+                                                             label_shows_entire_text (item));
+    if (nautilus_canvas_container_lookup_label_size (container, size_key, &size))
+    {
+        details->text_width = size.text_width;
+        details->text_dx = size.text_dx;
+        details->text_height = size.text_height;
+        details->text_height_for_layout = size.text_height_for_layout;
+        details->text_height_for_entire_text = size.text_height_for_entire_text;
+        details->editable_text_height = size.editable_text_height;
+        return;
+    }
+
     editable_width = 0;
     editable_height = 0;
     editable_height_for_layout = 0;
@@ -885,7 +916,6 @@ measure_label_text (NautilusCanvasItem *item)
     additional_height = 0;
     additional_dx = 0;
 
-    container = NAUTILUS_CANVAS_CONTAINER (EEL_CANVAS_ITEM (item)->canvas);
     editable_layout = NULL;
     additional_layout = NULL;
 
@@ -959,6 +989,14 @@ measure_label_text (NautilusCanvasItem *item)
     /* extra to make it look nicer */
     details->text_width += TEXT_BACK_PADDING_X * 2;
 
+    size.text_width = details->text_width;
+    size.text_dx = details->text_dx;
+    size.text_height = details->text_height;
+    size.text_height_for_layout = details->text_height_for_layout;
+    size.text_height_for_entire_text = details->text_height_for_entire_text;
+    size.editable_text_height = details->editable_text_height;
+    nautilus_canvas_container_store_label_size (container, size_key, &size);
+
     if (editable_layout)
     {
         g_object_unref (editable_layout);
@@ -1186,7 +1224,7 @@ real_map_surface (NautilusCanvasItem *canvas_item)
         g_autoptr (GdkPixbuf) old_pixbuf = NULL;
 
         old_pixbuf = temp_pixbuf;
-        temp_pixbuf = eel_create_spotlight_pixbuf (temp_pixbuf);
+        temp_pixbuf = eel_get_spotlight_pixbuf (temp_pixbuf);
     }
 
     if (canvas_item->details->is_highlighted_for_selection
@@ -93,6 +93,18 @@ typedef struct {
 	guint icon_size;
 } StretchState;
 
+/* Measured size of an icon label, in pixels, as kept by the container so
+ * that labels with the same text and layout constraints are only shaped
+ * once. */
+typedef struct {
+	int text_width;
+	int text_dx;
+	int text_height;
+	int text_height_for_layout;
+	int text_height_for_entire_text;
+	int editable_text_height;
+} NautilusCanvasLabelSize;
+
 typedef enum {
 	AXIS_NONE,
 	AXIS_HORIZONTAL,
@@ -177,6 +189,9 @@ struct NautilusCanvasContainerDetails {
 
 	/* specific fonts used to draw labels */
 	char *font;
+
+	/* Label sizes measured so far, by text and layout constraints */
+	GHashTable *label_sizes;
 	
 	/* State used so arrow keys don't wander if icons aren't lined up.
 	 */
@@ -221,3 +236,14 @@ gboolean      nautilus_canvas_container_scroll                      (NautilusCan
 								     int                    delta_x,
 								     int                    delta_y);
 void          nautilus_canvas_container_update_scroll_region        (NautilusCanvasContainer *container);
+char *        nautilus_canvas_container_get_label_size_key          (NautilusCanvasContainer *container,
+								     const char            *editable_text,
+								     const char            *additional_text,
+								     int                    max_text_width,
+								     gboolean               entire_text);
+gboolean      nautilus_canvas_container_lookup_label_size           (NautilusCanvasContainer *container,
+								     const char            *key,
+								     NautilusCanvasLabelSize *size);
+void          nautilus_canvas_container_store_label_size            (NautilusCanvasContainer *container,
+								     const char            *key,
+								     const NautilusCanvasLabelSize *size);
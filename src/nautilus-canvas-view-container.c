@@ -29,7 +29,6 @@
 #include "nautilus-canvas-view.h"
 #include "nautilus-enums.h"
 #include "nautilus-global-preferences.h"
-#include "nautilus-thumbnails.h"
 
 struct _NautilusCanvasViewContainer
 {
@@ -103,18 +102,12 @@ nautilus_canvas_view_container_prioritize_thumbnailing (NautilusCanvasContainer
                                                         NautilusCanvasIconData  *data)
 {
     NautilusFile *file;
-    char *uri;
 
     file = (NautilusFile *) data;
 
     g_assert (NAUTILUS_IS_FILE (file));
 
-    if (nautilus_file_is_thumbnailing (file))
-    {
-        uri = nautilus_file_get_uri (file);
-        nautilus_thumbnail_prioritize (uri);
-        g_free (uri);
-    }
+    nautilus_file_prioritize_io (file);
 }
 
 static GQuark *
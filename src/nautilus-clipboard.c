@@ -67,8 +67,7 @@ convert_file_list_to_string (ClipboardInfo *info,
 {
     GString *uris;
     char *uri, *tmp;
-    GFile *f;
-    guint i;
+    GFile *location;
     GList *l;
 
     if (format_for_text)
@@ -80,15 +79,12 @@ convert_file_list_to_string (ClipboardInfo *info,
         uris = g_string_new (info->cut ? "cut" : "copy");
     }
 
-    for (i = 0, l = info->files; l != NULL; l = l->next, i++)
+    for (l = info->files; l != NULL; l = l->next)
     {
-        uri = nautilus_file_get_uri (l->data);
-
         if (format_for_text)
         {
-            f = g_file_new_for_uri (uri);
-            tmp = g_file_get_parse_name (f);
-            g_object_unref (f);
+            location = nautilus_file_get_location (l->data);
+            tmp = g_file_get_parse_name (location);
 
             if (tmp != NULL)
             {
@@ -97,22 +93,25 @@ convert_file_list_to_string (ClipboardInfo *info,
             }
             else
             {
+                uri = g_file_get_uri (location);
                 g_string_append (uris, uri);
+                g_free (uri);
             }
+            g_object_unref (location);
 
             /* skip newline for last element */
-            if (i + 1 < g_list_length (info->files))
+            if (l->next != NULL)
             {
                 g_string_append_c (uris, '\n');
             }
         }
         else
         {
+            uri = nautilus_file_get_uri (l->data);
             g_string_append_c (uris, '\n');
             g_string_append (uris, uri);
+            g_free (uri);
         }
-
-        g_free (uri);
     }
 
     *len = uris->len;
@@ -157,7 +156,8 @@ nautilus_clipboard_get_uri_list_from_selection_data (GtkSelectionData *selection
     if (items)
     {
         /* Line 0 is "cut" or "copy", so uris start at line 1. */
-        items = g_list_remove (items, items->data);
+        g_free (items->data);
+        items = g_list_delete_link (items, items);
     }
 
     return items;
@@ -170,28 +170,21 @@ nautilus_clipboard_get (GtkWidget *widget)
                                           GDK_SELECTION_CLIPBOARD);
 }
 
-void
-nautilus_clipboard_clear_if_colliding_uris (GtkWidget   *widget,
-                                            const GList *item_uris)
+static void
+on_clipboard_contents_for_collisions (GtkClipboard     *clipboard,
+                                      GtkSelectionData *selection_data,
+                                      gpointer          user_data)
 {
-    GtkSelectionData *data;
+    g_autoptr (GHashTable) item_uris = user_data;
     GList *clipboard_item_uris, *l;
     gboolean collision;
 
     collision = FALSE;
-    data = gtk_clipboard_wait_for_contents (nautilus_clipboard_get (widget),
-                                            copied_files_atom);
-    if (data == NULL)
-    {
-        return;
-    }
+    clipboard_item_uris = nautilus_clipboard_get_uri_list_from_selection_data (selection_data);
 
-    clipboard_item_uris = nautilus_clipboard_get_uri_list_from_selection_data (data);
-
-    for (l = (GList *) item_uris; l; l = l->next)
+    for (l = clipboard_item_uris; l != NULL; l = l->next)
     {
-        if (g_list_find_custom ((GList *) clipboard_item_uris, l->data,
-                                (GCompareFunc) g_strcmp0))
+        if (g_hash_table_contains (item_uris, l->data))
         {
             collision = TRUE;
             break;
@@ -200,13 +193,36 @@ nautilus_clipboard_clear_if_colliding_uris (GtkWidget   *widget,
 
     if (collision)
     {
-        gtk_clipboard_clear (nautilus_clipboard_get (widget));
+        gtk_clipboard_clear (clipboard);
+    }
+
+    g_list_free_full (clipboard_item_uris, g_free);
+}
+
+/* The clipboard contents are requested without waiting for them, which
+ * could block for as long as the owner of the clipboard takes to answer. */
+void
+nautilus_clipboard_clear_if_colliding_uris (GtkWidget   *widget,
+                                            const GList *item_uris)
+{
+    GHashTable *uris;
+    const GList *l;
+
+    if (item_uris == NULL)
+    {
+        return;
     }
 
-    if (clipboard_item_uris)
+    uris = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    for (l = item_uris; l != NULL; l = l->next)
     {
-        g_list_free_full (clipboard_item_uris, g_free);
+        g_hash_table_add (uris, g_strdup (l->data));
     }
+
+    gtk_clipboard_request_contents (nautilus_clipboard_get (widget),
+                                    copied_files_atom,
+                                    on_clipboard_contents_for_collisions,
+                                    uris);
 }
 
 gboolean
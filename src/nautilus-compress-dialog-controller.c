@@ -50,6 +50,7 @@ struct _NautilusCompressDialogController {
   GtkWidget *seven_zip_checkmark;
   GtkWidget *passphrase_label;
   GtkWidget *passphrase_entry;
+  GtkWidget *parallel_check_button;
 
   const char *extension;
   gchar *passphrase;
@@ -138,6 +139,7 @@ static void update_selected_format(NautilusCompressDialogController *self,
   GtkWidget *active_label;
   GtkWidget *active_checkmark;
   gboolean show_passphrase = FALSE;
+  gboolean show_parallel = FALSE;
 
   switch (format) {
   case NAUTILUS_COMPRESSION_ZIP: {
@@ -157,6 +159,9 @@ static void update_selected_format(NautilusCompressDialogController *self,
     extension = ".tar.xz";
     active_label = self->tar_xz_label;
     active_checkmark = self->tar_xz_checkmark;
+#ifdef HAVE_LIBARCHIVE
+    show_parallel = TRUE;
+#endif
   } break;
 
   case NAUTILUS_COMPRESSION_7ZIP: {
@@ -181,6 +186,9 @@ static void update_selected_format(NautilusCompressDialogController *self,
                                       GTK_ENTRY_ICON_SECONDARY, "view-conceal");
   }
 
+  /* Only the xz filter can compress on several threads */
+  gtk_widget_set_visible(self->parallel_check_button, show_parallel);
+
   gtk_stack_set_visible_child(GTK_STACK(self->extension_stack), active_label);
 
   gtk_image_set_from_icon_name(GTK_IMAGE(self->zip_checkmark), NULL,
@@ -350,6 +358,7 @@ NautilusCompressDialogController *nautilus_compress_dialog_controller_new(
   GtkWidget *seven_zip_checkmark;
   GtkWidget *passphrase_label;
   GtkWidget *passphrase_entry;
+  GtkWidget *parallel_check_button;
   NautilusCompressionFormat format;
 
   builder = gtk_builder_new_from_resource(
@@ -383,6 +392,8 @@ NautilusCompressDialogController *nautilus_compress_dialog_controller_new(
       GTK_WIDGET(gtk_builder_get_object(builder, "passphrase_label"));
   passphrase_entry =
       GTK_WIDGET(gtk_builder_get_object(builder, "passphrase_entry"));
+  parallel_check_button =
+      GTK_WIDGET(gtk_builder_get_object(builder, "parallel_check_button"));
   zip_row = GTK_WIDGET(gtk_builder_get_object(builder, "zip_row"));
   encrypted_zip_row =
       GTK_WIDGET(gtk_builder_get_object(builder, "encrypted_zip_row"));
@@ -414,6 +425,7 @@ NautilusCompressDialogController *nautilus_compress_dialog_controller_new(
   self->name_entry = name_entry;
   self->passphrase_label = passphrase_label;
   self->passphrase_entry = passphrase_entry;
+  self->parallel_check_button = parallel_check_button;
   self->zip_row = zip_row;
   self->encrypted_zip_row = encrypted_zip_row;
   self->tar_xz_row = tar_xz_row;
@@ -440,6 +452,11 @@ NautilusCompressDialogController *nautilus_compress_dialog_controller_new(
   g_signal_connect(self->extension_popover, "show", G_CALLBACK(popover_on_show),
                    self);
 
+  g_settings_bind(nautilus_compression_preferences,
+                  NAUTILUS_PREFERENCES_PARALLEL_COMPRESSION,
+                  self->parallel_check_button, "active",
+                  G_SETTINGS_BIND_DEFAULT);
+
   format = g_settings_get_enum(nautilus_compression_preferences,
                                NAUTILUS_PREFERENCES_DEFAULT_COMPRESSION_FORMAT);
 
@@ -29,6 +29,7 @@
 #include "nautilus-file-operations.h"
 #include "nautilus-file-undo-manager.h"
 #include "nautilus-file.h"
+#include "nautilus-statistics.h"
 
 #define DEBUG_FLAG NAUTILUS_DEBUG_DBUS
 #include "nautilus-debug.h"
@@ -39,6 +40,7 @@ struct _NautilusDBusManager
 
     NautilusDBusFileOperations *file_operations;
     NautilusDBusFileOperations2 *file_operations2;
+    NautilusDBusStatistics *statistics;
 };
 
 G_DEFINE_TYPE (NautilusDBusManager, nautilus_dbus_manager, G_TYPE_OBJECT);
@@ -60,6 +62,8 @@ nautilus_dbus_manager_dispose (GObject *object)
         self->file_operations2 = NULL;
     }
 
+    g_clear_object (&self->statistics);
+
     G_OBJECT_CLASS (nautilus_dbus_manager_parent_class)->dispose (object);
 }
 
@@ -505,6 +509,16 @@ handle_rename_uri2 (NautilusDBusFileOperations2 *object,
     return TRUE; /* invocation was handled */
 }
 
+static gboolean
+handle_get_statistics (NautilusDBusStatistics *object,
+                       GDBusMethodInvocation  *invocation)
+{
+    nautilus_dbus_statistics_complete_get_statistics (object, invocation,
+                                                      nautilus_statistics_get ());
+
+    return TRUE; /* invocation was handled */
+}
+
 static void
 undo_manager_changed (NautilusDBusManager *self)
 {
@@ -525,6 +539,7 @@ nautilus_dbus_manager_init (NautilusDBusManager *self)
     G_GNUC_END_IGNORE_DEPRECATIONS
 
     self->file_operations2 = nautilus_dbus_file_operations2_skeleton_new ();
+    self->statistics = nautilus_dbus_statistics_skeleton_new ();
 
     g_signal_connect (self->file_operations,
                       "handle-copy-uris",
@@ -594,6 +609,10 @@ nautilus_dbus_manager_init (NautilusDBusManager *self)
                       "handle-redo",
                       G_CALLBACK (handle_redo2),
                       self);
+    g_signal_connect (self->statistics,
+                      "handle-get-statistics",
+                      G_CALLBACK (handle_get_statistics),
+                      self);
 }
 
 static void
@@ -617,6 +636,7 @@ nautilus_dbus_manager_register (NautilusDBusManager  *self,
 {
     gboolean success1;
     gboolean success2;
+    gboolean success3;
     gboolean succes;
 
     success1 = g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (self->file_operations),
@@ -629,7 +649,12 @@ nautilus_dbus_manager_register (NautilusDBusManager  *self,
                                                  "/org/gnome/Nautilus" PROFILE "/FileOperations2",
                                                  error);
 
-    succes = success1 && success2;
+    success3 = g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (self->statistics),
+                                                 connection,
+                                                 "/org/gnome/Nautilus" PROFILE "/Statistics",
+                                                 error);
+
+    succes = success1 && success2 && success3;
 
     if (succes)
     {
@@ -650,6 +675,7 @@ nautilus_dbus_manager_unregister (NautilusDBusManager *self)
 {
     g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (self->file_operations));
     g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (self->file_operations2));
+    g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (self->statistics));
 
     g_signal_handlers_disconnect_by_data (nautilus_file_undo_manager_get (), self);
 }
@@ -19,9 +19,13 @@
  *  Author: Darin Adler <darin@bentspoon.com>
  */
 
+#include <dirent.h>
+#include <fcntl.h>
 #include <libxml/parser.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #define DEBUG_FLAG NAUTILUS_DEBUG_ASYNC_JOBS
 
@@ -32,9 +36,12 @@
 #include "nautilus-file-private.h"
 #include "nautilus-file-queue.h"
 #include "nautilus-global-preferences.h"
+#include "nautilus-listing-snapshot.h"
 #include "nautilus-metadata.h"
 #include "nautilus-profile.h"
 #include "nautilus-signaller.h"
+#include "nautilus-statistics.h"
+#include "nautilus-thumbnail-cache.h"
 
 /* turn this on to check if async. job calls are balanced */
 #if 0
@@ -46,10 +53,36 @@
 /* Keep async. jobs down to this number for all directories. */
 #define MAX_ASYNC_JOBS 10
 
+/* Thumbnails being read and decoded at once for a directory. All of them
+ * count as a single async job. */
+#define MAX_THUMBNAIL_LOADS 4
+/* Loaded thumbnails are handed to their files at most this often, in
+ * milliseconds */
+#define THUMBNAIL_BATCH_INTERVAL 50
+
+/* File info queries in flight at once for a directory. All of them count as
+ * a single async job. */
+#define MAX_FILE_INFO_QUERIES 8
+
+/* Subdirectories being counted at once for a directory. All of them count
+ * as a single async job. */
+#define MAX_DIRECTORY_COUNTS 4
+/* Item counts remembered by directory modification time. The cache is
+ * simply emptied when it gets full. */
+#define MAX_CACHED_DIRECTORY_COUNTS 10000
+
+/* Batches handed at once to the info providers that support them, for a
+ * directory, and the most files in each. All of them count as a single async
+ * job. */
+#define MAX_EXTENSION_INFO_BATCHES 4
+#define EXTENSION_INFO_BATCH_SIZE 200
+
 struct ThumbnailState {
   NautilusDirectory *directory;
   GCancellable *cancellable;
   NautilusFile *file;
+  char *path;
+  GdkPixbuf *pixbuf;
 };
 
 struct MountState {
@@ -71,6 +104,7 @@ struct DirectoryLoadState {
   GHashTable *load_mime_list_hash;
   NautilusFile *load_directory_file;
   int load_file_count;
+  gint64 start_time;
 };
 
 struct MimeListState {
@@ -84,6 +118,7 @@ struct MimeListState {
 struct GetInfoState {
   NautilusDirectory *directory;
   GCancellable *cancellable;
+  NautilusFile *file;
 };
 
 struct NewFilesState {
@@ -97,7 +132,27 @@ struct DirectoryCountState {
   NautilusFile *count_file;
   GCancellable *cancellable;
   GFileEnumerator *enumerator;
-  int file_count;
+  char *path; /* Set when counted natively */
+  time_t mtime;
+
+  /* Hidden and backup files are counted apart, so that the result can be
+   * cached whatever the show-hidden setting is. */
+  guint total_count;
+  guint visible_count;
+};
+
+typedef struct {
+  time_t mtime;
+  guint total_count;
+  guint visible_count;
+} CachedDirectoryCount;
+
+struct ExtensionInfoBatch {
+  NautilusDirectory *directory;
+  NautilusInfoProvider *provider;
+  GCancellable *cancellable;
+  GList *files;
+  GHashTable *file_set;
 };
 
 struct DeepCountState {
@@ -332,6 +387,7 @@ static gboolean async_job_start(NautilusDirectory *directory, const char *job) {
 #endif
 
   async_job_count += 1;
+  nautilus_trace_counter("async jobs", async_job_count);
   return TRUE;
 }
 
@@ -364,6 +420,7 @@ static void async_job_end(NautilusDirectory *directory, const char *job) {
 #endif
 
   async_job_count -= 1;
+  nautilus_trace_counter("async jobs", async_job_count);
 }
 
 /* Helper to get one value from a hash table. */
@@ -412,10 +469,29 @@ static void async_job_wake_up(void) {
   already_waking_up = FALSE;
 }
 
+void nautilus_directory_get_async_job_counts(guint *n_running,
+                                             guint *n_waiting) {
+  *n_running = async_job_count;
+  *n_waiting =
+      waiting_directories != NULL ? g_hash_table_size(waiting_directories) : 0;
+}
+
+static void directory_count_state_cancel(NautilusDirectory *directory,
+                                         DirectoryCountState *state) {
+  g_cancellable_cancel(state->cancellable);
+  state->directory = NULL;
+
+  directory->details->count_in_progress =
+      g_list_remove(directory->details->count_in_progress, state);
+  if (directory->details->count_in_progress == NULL) {
+    async_job_end(directory, "directory count");
+  }
+}
+
 static void directory_count_cancel(NautilusDirectory *directory) {
-  if (directory->details->count_in_progress != NULL) {
-    g_cancellable_cancel(directory->details->count_in_progress->cancellable);
-    directory->details->count_in_progress = NULL;
+  while (directory->details->count_in_progress != NULL) {
+    directory_count_state_cancel(directory,
+                                 directory->details->count_in_progress->data);
   }
 }
 
@@ -444,15 +520,31 @@ static void mime_list_cancel(NautilusDirectory *directory) {
   }
 }
 
-static void thumbnail_cancel(NautilusDirectory *directory) {
-  if (directory->details->thumbnail_state != NULL) {
-    g_cancellable_cancel(directory->details->thumbnail_state->cancellable);
-    directory->details->thumbnail_state->directory = NULL;
-    directory->details->thumbnail_state = NULL;
+static void thumbnail_state_free(ThumbnailState *state);
+
+static void thumbnail_load_cancel(NautilusDirectory *directory,
+                                  ThumbnailState *state) {
+  g_cancellable_cancel(state->cancellable);
+  state->directory = NULL;
+
+  directory->details->thumbnail_loads =
+      g_list_remove(directory->details->thumbnail_loads, state);
+  if (directory->details->thumbnail_loads == NULL) {
     async_job_end(directory, "thumbnail");
   }
 }
 
+static void thumbnail_cancel(NautilusDirectory *directory) {
+  while (directory->details->thumbnail_loads != NULL) {
+    thumbnail_load_cancel(directory,
+                          directory->details->thumbnail_loads->data);
+  }
+
+  g_list_free_full(g_steal_pointer(&directory->details->thumbnail_results),
+                   (GDestroyNotify)thumbnail_state_free);
+  g_clear_handle_id(&directory->details->thumbnail_batch_id, g_source_remove);
+}
+
 static void mount_cancel(NautilusDirectory *directory) {
   if (directory->details->mount_state != NULL) {
     g_cancellable_cancel(directory->details->mount_state->cancellable);
@@ -462,17 +554,25 @@ static void mount_cancel(NautilusDirectory *directory) {
   }
 }
 
-static void file_info_cancel(NautilusDirectory *directory) {
-  if (directory->details->get_info_in_progress != NULL) {
-    g_cancellable_cancel(directory->details->get_info_in_progress->cancellable);
-    directory->details->get_info_in_progress->directory = NULL;
-    directory->details->get_info_in_progress = NULL;
-    directory->details->get_info_file = NULL;
+static void file_info_query_cancel(NautilusDirectory *directory,
+                                   GetInfoState *state) {
+  g_cancellable_cancel(state->cancellable);
+  state->directory = NULL;
 
+  directory->details->get_info_in_progress =
+      g_list_remove(directory->details->get_info_in_progress, state);
+  if (directory->details->get_info_in_progress == NULL) {
     async_job_end(directory, "file info");
   }
 }
 
+static void file_info_cancel(NautilusDirectory *directory) {
+  while (directory->details->get_info_in_progress != NULL) {
+    file_info_query_cancel(directory,
+                           directory->details->get_info_in_progress->data);
+  }
+}
+
 static void new_files_cancel(NautilusDirectory *directory) {
   GList *l;
   NewFilesState *state;
@@ -747,8 +847,7 @@ static void show_hidden_files_changed_callback(gpointer callback_data) {
       gtk_filechooser_preferences, NAUTILUS_PREFERENCES_SHOW_HIDDEN_FILES);
 }
 
-static gboolean should_skip_file(NautilusDirectory *directory,
-                                 GFileInfo *info) {
+static gboolean should_show_hidden_files(void) {
   static gboolean show_hidden_files_changed_callback_installed = FALSE;
 
   /* Add the callback once for the life of our process */
@@ -764,7 +863,12 @@ static gboolean should_skip_file(NautilusDirectory *directory,
     show_hidden_files_changed_callback(NULL);
   }
 
-  if (!show_hidden_files &&
+  return show_hidden_files;
+}
+
+static gboolean should_skip_file(NautilusDirectory *directory,
+                                 GFileInfo *info) {
+  if (!should_show_hidden_files() &&
       (g_file_info_get_is_hidden(info) || g_file_info_get_is_backup(info))) {
     return TRUE;
   }
@@ -780,6 +884,7 @@ static gboolean dequeue_pending_idle_callback(gpointer callback_data) {
   GList *changed_files, *added_files;
   GFileInfo *file_info;
   const char *mimetype, *name;
+  gboolean from_snapshot;
   DirectoryLoadState *dir_load_state;
 
   directory = NAUTILUS_DIRECTORY(callback_data);
@@ -819,7 +924,11 @@ static gboolean dequeue_pending_idle_callback(gpointer callback_data) {
      * moving this into the actual callback instead of
      * waiting for the idle function.
      */
-    if (dir_load_state && !should_skip_file(directory, file_info)) {
+    from_snapshot = g_file_info_get_attribute_boolean(
+        file_info, NAUTILUS_LISTING_SNAPSHOT_ATTRIBUTE);
+
+    if (dir_load_state && !from_snapshot &&
+        !should_skip_file(directory, file_info)) {
       dir_load_state->load_file_count += 1;
 
       /* Add the MIME type to the set. */
@@ -855,6 +964,12 @@ static gboolean dequeue_pending_idle_callback(gpointer callback_data) {
       file->details->is_added = TRUE;
       added_files = g_list_prepend(added_files, file);
     }
+
+    /* Until the live listing has it too, a file from the snapshot may be
+     * gone already. */
+    if (from_snapshot && dir_load_state != NULL) {
+      set_file_unconfirmed(file, TRUE);
+    }
   }
 
   /* If we are done loading, then we assume that any unconfirmed
@@ -955,6 +1070,9 @@ static void directory_load_cancel(NautilusDirectory *directory) {
 
   state = directory->details->directory_load_in_progress;
   if (state != NULL) {
+    nautilus_trace_async_end("directory load", state, "%d files",
+                             state->load_file_count);
+
     file = state->load_directory_file;
     file->details->loading_directory = FALSE;
     if (file->details->directory != directory) {
@@ -1012,6 +1130,18 @@ static void directory_load_done(NautilusDirectory *directory, GError *error) {
   }
   dequeue_pending_idle_callback(directory);
 
+  if (error == NULL && directory->details->directory_load_in_progress != NULL) {
+    nautilus_statistics_add_directory_load(
+        g_get_monotonic_time() -
+        directory->details->directory_load_in_progress->start_time);
+  }
+
+  if (error == NULL &&
+      nautilus_listing_snapshot_is_enabled(directory->details->location)) {
+    nautilus_listing_snapshot_save(directory->details->location,
+                                   directory->details->file_list);
+  }
+
   directory_load_cancel(directory);
 
   g_object_unref(directory);
@@ -1422,10 +1552,14 @@ void nautilus_async_destroying_file(NautilusFile *file) {
   /* Check if it's a file that's currently being worked on.
    * If so, make that NULL so it gets canceled right away.
    */
-  if (directory->details->count_in_progress != NULL &&
-      directory->details->count_in_progress->count_file == file) {
-    directory->details->count_in_progress->count_file = NULL;
-    changed = TRUE;
+  for (node = directory->details->count_in_progress; node != NULL;
+       node = node->next) {
+    DirectoryCountState *state = node->data;
+
+    if (state->count_file == file) {
+      state->count_file = NULL;
+      changed = TRUE;
+    }
   }
   if (directory->details->deep_count_file == file) {
     directory->details->deep_count_file = NULL;
@@ -1436,19 +1570,37 @@ void nautilus_async_destroying_file(NautilusFile *file) {
     directory->details->mime_list_in_progress->mime_list_file = NULL;
     changed = TRUE;
   }
-  if (directory->details->get_info_file == file) {
-    directory->details->get_info_file = NULL;
-    changed = TRUE;
+  for (node = directory->details->get_info_in_progress; node != NULL;
+       node = node->next) {
+    GetInfoState *state = node->data;
+
+    if (state->file == file) {
+      state->file = NULL;
+      changed = TRUE;
+    }
   }
   if (directory->details->extension_info_file == file) {
     directory->details->extension_info_file = NULL;
     changed = TRUE;
   }
 
-  if (directory->details->thumbnail_state != NULL &&
-      directory->details->thumbnail_state->file == file) {
-    directory->details->thumbnail_state->file = NULL;
-    changed = TRUE;
+  for (node = directory->details->thumbnail_loads; node != NULL;
+       node = node->next) {
+    ThumbnailState *state = node->data;
+
+    if (state->file == file) {
+      state->file = NULL;
+      changed = TRUE;
+    }
+  }
+  for (node = directory->details->thumbnail_results; node != NULL;
+       node = node->next) {
+    ThumbnailState *state = node->data;
+
+    if (state->file == file) {
+      state->file = NULL;
+      changed = TRUE;
+    }
   }
 
   if (directory->details->mount_state != NULL &&
@@ -1738,6 +1890,22 @@ static void mark_all_files_unconfirmed(NautilusDirectory *directory) {
   }
 }
 
+/* Shows the saved listing of a remote directory while it is loaded again. */
+static void load_listing_snapshot(NautilusDirectory *directory) {
+  GList *infos, *l;
+
+  if (directory->details->file_list != NULL ||
+      !nautilus_listing_snapshot_is_enabled(directory->details->location)) {
+    return;
+  }
+
+  infos = nautilus_listing_snapshot_load(directory->details->location);
+  for (l = infos; l != NULL; l = l->next) {
+    directory_load_one(directory, l->data);
+  }
+  g_list_free_full(infos, g_object_unref);
+}
+
 static void directory_load_state_free(DirectoryLoadState *state) {
   if (state->enumerator) {
     if (!g_file_enumerator_is_closed(state->enumerator)) {
@@ -1859,6 +2027,7 @@ static void start_monitoring_file_list(NautilusDirectory *directory) {
   state->cancellable = g_cancellable_new();
   state->load_mime_list_hash = istr_set_new();
   state->load_file_count = 0;
+  state->start_time = g_get_monotonic_time();
 
   g_assert(directory->details->location != NULL);
   state->load_directory_file =
@@ -1869,6 +2038,9 @@ static void start_monitoring_file_list(NautilusDirectory *directory) {
         directory->details->location);
 
   directory->details->directory_load_in_progress = state;
+  nautilus_trace_async_begin("directory load", state, NULL);
+
+  load_listing_snapshot(directory);
 
   g_file_enumerate_children_async(
       directory->details->location, NAUTILUS_FILE_DEFAULT_ATTRIBUTES,
@@ -2038,43 +2210,92 @@ static gboolean is_needy(NautilusFile *file, FileCheck check_missing,
   return FALSE;
 }
 
+static DirectoryCountState *
+get_directory_count_state(NautilusDirectory *directory, NautilusFile *file) {
+  GList *node;
+
+  for (node = directory->details->count_in_progress; node != NULL;
+       node = node->next) {
+    if (((DirectoryCountState *)node->data)->count_file == file) {
+      return node->data;
+    }
+  }
+
+  return NULL;
+}
+
 static void directory_count_stop(NautilusDirectory *directory) {
+  DirectoryCountState *state;
   NautilusFile *file;
+  GList *node, *next;
+
+  for (node = directory->details->count_in_progress; node != NULL;
+       node = next) {
+    next = node->next;
+    state = node->data;
+    file = state->count_file;
 
-  if (directory->details->count_in_progress != NULL) {
-    file = directory->details->count_in_progress->count_file;
     if (file != NULL) {
       g_assert(NAUTILUS_IS_FILE(file));
       g_assert(file->details->directory == directory);
       if (is_needy(file, should_get_directory_count_now,
                    REQUEST_DIRECTORY_COUNT)) {
-        return;
+        continue;
       }
     }
 
     /* The count is not wanted, so stop it. */
-    directory_count_cancel(directory);
+    directory_count_state_cancel(directory, state);
   }
 }
 
-static guint count_non_skipped_files(GList *list) {
-  guint count;
-  GList *node;
-  GFileInfo *info;
+static GHashTable *cached_directory_counts;
 
-  count = 0;
-  for (node = list; node != NULL; node = node->next) {
-    info = node->data;
-    if (!should_skip_file(NULL, info)) {
-      count += 1;
-    }
+static CachedDirectoryCount *lookup_cached_directory_count(NautilusFile *file) {
+  CachedDirectoryCount *cached;
+  g_autofree char *uri = NULL;
+
+  if (cached_directory_counts == NULL || file->details->mtime == 0) {
+    return NULL;
+  }
+
+  uri = nautilus_file_get_uri(file);
+  cached = g_hash_table_lookup(cached_directory_counts, uri);
+  if (cached == NULL || cached->mtime != file->details->mtime) {
+    return NULL;
+  }
+
+  return cached;
+}
+
+static void cache_directory_count(NautilusFile *file, time_t mtime,
+                                  guint total_count, guint visible_count) {
+  CachedDirectoryCount *cached;
+
+  /* The count can't be trusted to match a later listing otherwise */
+  if (mtime == 0 || mtime != file->details->mtime) {
+    return;
+  }
+
+  if (cached_directory_counts == NULL) {
+    cached_directory_counts =
+        g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+  } else if (g_hash_table_size(cached_directory_counts) >=
+             MAX_CACHED_DIRECTORY_COUNTS) {
+    g_hash_table_remove_all(cached_directory_counts);
   }
-  return count;
+
+  cached = g_new(CachedDirectoryCount, 1);
+  cached->mtime = mtime;
+  cached->total_count = total_count;
+  cached->visible_count = visible_count;
+
+  g_hash_table_insert(cached_directory_counts, nautilus_file_get_uri(file),
+                      cached);
 }
 
-static void count_children_done(NautilusDirectory *directory,
-                                NautilusFile *count_file, gboolean succeeded,
-                                int count) {
+static void store_directory_count(NautilusFile *count_file, gboolean succeeded,
+                                  guint total_count, guint visible_count) {
   g_assert(NAUTILUS_IS_FILE(count_file));
 
   count_file->details->directory_count_is_up_to_date = TRUE;
@@ -2087,17 +2308,77 @@ static void count_children_done(NautilusDirectory *directory,
   } else {
     count_file->details->directory_count_failed = FALSE;
     count_file->details->got_directory_count = TRUE;
-    count_file->details->directory_count = count;
+    count_file->details->directory_count =
+        should_show_hidden_files() ? total_count : visible_count;
   }
-  directory->details->count_in_progress = NULL;
+}
+
+static void set_directory_count(NautilusFile *count_file, gboolean succeeded,
+                                guint total_count, guint visible_count) {
+  store_directory_count(count_file, succeeded, total_count, visible_count);
 
   /* Send file-changed even if count failed, so interested parties can
    * distinguish between unknowable and not-yet-known cases.
    */
   nautilus_file_changed(count_file);
+}
+
+static gboolean emit_cached_counts_changed_at_idle(gpointer callback_data) {
+  NautilusDirectory *directory;
+  GList *files;
+
+  directory = NAUTILUS_DIRECTORY(callback_data);
+  directory->details->cached_counts_changed_idle_id = 0;
+
+  files = g_list_reverse(directory->details->cached_counts_changed);
+  directory->details->cached_counts_changed = NULL;
+
+  nautilus_directory_ref(directory);
+  g_list_foreach(files, (GFunc)nautilus_file_changed, NULL);
+  nautilus_file_list_free(files);
+  nautilus_directory_unref(directory);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* A count found in the cache is set right away, but file-changed is sent at
+ * idle, as the work queue is being serviced and handlers may add to it. */
+static void set_cached_directory_count(NautilusDirectory *directory,
+                                       NautilusFile *count_file,
+                                       CachedDirectoryCount *cached) {
+  store_directory_count(count_file, TRUE, cached->total_count,
+                        cached->visible_count);
+
+  directory->details->cached_counts_changed = g_list_prepend(
+      directory->details->cached_counts_changed, nautilus_file_ref(count_file));
+  if (directory->details->cached_counts_changed_idle_id == 0) {
+    directory->details->cached_counts_changed_idle_id =
+        g_idle_add(emit_cached_counts_changed_at_idle, directory);
+  }
+}
+
+static void count_children_done(DirectoryCountState *state,
+                                gboolean succeeded) {
+  NautilusDirectory *directory;
+
+  directory = state->directory;
+
+  directory->details->count_in_progress =
+      g_list_remove(directory->details->count_in_progress, state);
+  if (directory->details->count_in_progress == NULL) {
+    async_job_end(directory, "directory count");
+  }
+
+  if (state->count_file != NULL) {
+    if (succeeded) {
+      cache_directory_count(state->count_file, state->mtime,
+                            state->total_count, state->visible_count);
+    }
+    set_directory_count(state->count_file, succeeded, state->total_count,
+                        state->visible_count);
+  }
 
   /* Start up the next one. */
-  async_job_end(directory, "directory count");
   nautilus_directory_async_state_changed(directory);
 }
 
@@ -2109,41 +2390,45 @@ static void directory_count_state_free(DirectoryCountState *state) {
     g_object_unref(state->enumerator);
   }
   g_object_unref(state->cancellable);
-  nautilus_directory_unref(state->directory);
+  g_free(state->path);
   g_free(state);
 }
 
+static void count_files(DirectoryCountState *state, GList *list) {
+  GList *node;
+  GFileInfo *info;
+
+  for (node = list; node != NULL; node = node->next) {
+    info = node->data;
+
+    state->total_count++;
+    if (!g_file_info_get_is_hidden(info) && !g_file_info_get_is_backup(info)) {
+      state->visible_count++;
+    }
+  }
+}
+
 static void count_more_files_callback(GObject *source_object, GAsyncResult *res,
                                       gpointer user_data) {
   DirectoryCountState *state;
-  NautilusDirectory *directory;
   GError *error;
   GList *files;
 
   state = user_data;
-  directory = state->directory;
 
-  if (g_cancellable_is_cancelled(state->cancellable)) {
+  if (state->directory == NULL) {
     /* Operation was cancelled. Bail out */
-
-    async_job_end(directory, "directory count");
-    nautilus_directory_async_state_changed(directory);
-
     directory_count_state_free(state);
-
     return;
   }
 
-  g_assert(directory->details->count_in_progress != NULL);
-  g_assert(directory->details->count_in_progress == state);
-
   error = NULL;
   files = g_file_enumerator_next_files_finish(state->enumerator, res, &error);
 
-  state->file_count += count_non_skipped_files(files);
+  count_files(state, files);
 
   if (files == NULL) {
-    count_children_done(directory, state->count_file, TRUE, state->file_count);
+    count_children_done(state, TRUE);
     directory_count_state_free(state);
   } else {
     g_file_enumerator_next_files_async(state->enumerator,
@@ -2163,20 +2448,13 @@ static void count_children_callback(GObject *source_object, GAsyncResult *res,
                                     gpointer user_data) {
   DirectoryCountState *state;
   GFileEnumerator *enumerator;
-  NautilusDirectory *directory;
   GError *error;
 
   state = user_data;
 
-  if (g_cancellable_is_cancelled(state->cancellable)) {
+  if (state->directory == NULL) {
     /* Operation was cancelled. Bail out */
-    directory = state->directory;
-
-    async_job_end(directory, "directory count");
-    nautilus_directory_async_state_changed(directory);
-
     directory_count_state_free(state);
-
     return;
   }
 
@@ -2185,7 +2463,7 @@ static void count_children_callback(GObject *source_object, GAsyncResult *res,
       g_file_enumerate_children_finish(G_FILE(source_object), res, &error);
 
   if (enumerator == NULL) {
-    count_children_done(state->directory, state->count_file, FALSE, 0);
+    count_children_done(state, FALSE);
     g_error_free(error);
     directory_count_state_free(state);
     return;
@@ -2198,42 +2476,163 @@ static void count_children_callback(GObject *source_object, GAsyncResult *res,
   }
 }
 
-static void directory_count_start(NautilusDirectory *directory,
-                                  NautilusFile *file, gboolean *doing_io) {
+/* Names listed in the .hidden file of a directory, which GIO reports as
+ * hidden too. */
+static GHashTable *read_hidden_names(int dir_fd) {
+  g_autofree char *contents = NULL;
+  g_auto(GStrv) lines = NULL;
+  GHashTable *names;
+  GString *buffer;
+  char chunk[4096];
+  ssize_t n;
+  int fd;
+  guint i;
+
+  fd = openat(dir_fd, ".hidden", O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return NULL;
+  }
+
+  buffer = g_string_new(NULL);
+  while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+    g_string_append_len(buffer, chunk, n);
+  }
+  close(fd);
+  contents = g_string_free(buffer, FALSE);
+
+  names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  lines = g_strsplit(contents, "\n", -1);
+  for (i = 0; lines[i] != NULL; i++) {
+    if (lines[i][0] != '\0') {
+      g_hash_table_add(names, g_steal_pointer(&lines[i]));
+    }
+  }
+
+  return names;
+}
+
+/* Counts the children of a local directory with a plain readdir() loop,
+ * which glibc serves from large getdents64() batches, instead of creating a
+ * GFileInfo for each child. */
+static void count_children_native_thread(GTask *task, gpointer source_object,
+                                         gpointer task_data,
+                                         GCancellable *cancellable) {
   DirectoryCountState *state;
-  GFile *location;
+  GHashTable *hidden_names;
+  struct dirent *entry;
+  const char *name;
+  gsize len;
+  DIR *dir;
+  int fd;
+
+  state = task_data;
+
+  fd = open(state->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd == -1) {
+    g_task_return_boolean(task, FALSE);
+    return;
+  }
 
-  if (directory->details->count_in_progress != NULL) {
-    *doing_io = TRUE;
+  hidden_names = read_hidden_names(fd);
+
+  dir = fdopendir(fd);
+  if (dir == NULL) {
+    close(fd);
+    g_clear_pointer(&hidden_names, g_hash_table_unref);
+    g_task_return_boolean(task, FALSE);
     return;
   }
 
+  while ((entry = readdir(dir)) != NULL) {
+    name = entry->d_name;
+    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+      continue;
+    }
+
+    state->total_count++;
+
+    len = strlen(name);
+    if (name[0] != '.' && name[len - 1] != '~' &&
+        (hidden_names == NULL || !g_hash_table_contains(hidden_names, name))) {
+      state->visible_count++;
+    }
+
+    if ((state->total_count & 0xfff) == 0 &&
+        g_cancellable_is_cancelled(cancellable)) {
+      break;
+    }
+  }
+
+  closedir(dir);
+  g_clear_pointer(&hidden_names, g_hash_table_unref);
+
+  g_task_return_boolean(task, TRUE);
+}
+
+static void count_children_native_callback(GObject *source_object,
+                                           GAsyncResult *res,
+                                           gpointer user_data) {
+  DirectoryCountState *state;
+
+  state = g_task_get_task_data(G_TASK(res));
+
+  if (state->directory != NULL) {
+    count_children_done(state, g_task_propagate_boolean(G_TASK(res), NULL));
+  }
+
+  directory_count_state_free(state);
+}
+
+static void directory_count_start(NautilusDirectory *directory,
+                                  NautilusFile *file, gboolean *doing_io) {
+  DirectoryCountState *state;
+  CachedDirectoryCount *cached;
+  GFile *location;
+
   if (!is_needy(file, should_get_directory_count_now,
-                REQUEST_DIRECTORY_COUNT)) {
+                REQUEST_DIRECTORY_COUNT) ||
+      get_directory_count_state(directory, file) != NULL) {
     return;
   }
-  *doing_io = TRUE;
 
   if (!nautilus_file_is_directory(file)) {
     file->details->directory_count_is_up_to_date = TRUE;
     file->details->directory_count_failed = FALSE;
     file->details->got_directory_count = FALSE;
 
+    *doing_io = TRUE;
     nautilus_directory_async_state_changed(directory);
     return;
   }
 
-  if (!async_job_start(directory, "directory count")) {
+  /* Nothing was added or removed since it was last counted */
+  cached = lookup_cached_directory_count(file);
+  if (cached != NULL) {
+    set_cached_directory_count(directory, file, cached);
     return;
   }
 
-  /* Start counting. */
+  if (g_list_length(directory->details->count_in_progress) >=
+      MAX_DIRECTORY_COUNTS) {
+    *doing_io = TRUE;
+    return;
+  }
+
+  if (directory->details->count_in_progress == NULL &&
+      !async_job_start(directory, "directory count")) {
+    *doing_io = TRUE;
+    return;
+  }
+
+  /* Start counting. The file can move on in the queue meanwhile. */
   state = g_new0(DirectoryCountState, 1);
   state->count_file = file;
-  state->directory = nautilus_directory_ref(directory);
+  state->directory = directory;
   state->cancellable = g_cancellable_new();
+  state->mtime = file->details->mtime;
 
-  directory->details->count_in_progress = state;
+  directory->details->count_in_progress =
+      g_list_prepend(directory->details->count_in_progress, state);
 
   location = nautilus_file_get_location(file);
 
@@ -2243,13 +2642,23 @@ static void directory_count_start(NautilusDirectory *directory,
     DEBUG("load_directory called to get shallow file count for %s", uri);
   }
 
-  g_file_enumerate_children_async(
-      location,
-      G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN
-                                     "," G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP,
-      G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, /* flags */
-      G_PRIORITY_DEFAULT,                  /* prio */
-      state->cancellable, count_children_callback, state);
+  state->path = g_file_get_path(location);
+  if (state->path != NULL) {
+    g_autoptr(GTask) task = NULL;
+
+    task = g_task_new(NULL, state->cancellable,
+                      count_children_native_callback, NULL);
+    g_task_set_task_data(task, state, NULL);
+    g_task_run_in_thread(task, count_children_native_thread);
+  } else {
+    g_file_enumerate_children_async(
+        location,
+        G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN
+                                       "," G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP,
+        G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, /* flags */
+        G_PRIORITY_DEFAULT,                  /* prio */
+        state->cancellable, count_children_callback, state);
+  }
   g_object_unref(location);
 }
 
@@ -2780,6 +3189,20 @@ static void get_info_state_free(GetInfoState *state) {
   g_free(state);
 }
 
+static GetInfoState *get_file_info_state(NautilusDirectory *directory,
+                                         NautilusFile *file) {
+  GList *node;
+
+  for (node = directory->details->get_info_in_progress; node != NULL;
+       node = node->next) {
+    if (((GetInfoState *)node->data)->file == file) {
+      return node->data;
+    }
+  }
+
+  return NULL;
+}
+
 static void query_info_callback(GObject *source_object, GAsyncResult *res,
                                 gpointer user_data) {
   NautilusDirectory *directory;
@@ -2798,39 +3221,52 @@ static void query_info_callback(GObject *source_object, GAsyncResult *res,
 
   directory = nautilus_directory_ref(state->directory);
 
-  get_info_file = directory->details->get_info_file;
-  g_assert(NAUTILUS_IS_FILE(get_info_file));
-
-  directory->details->get_info_file = NULL;
-  directory->details->get_info_in_progress = NULL;
+  get_info_file = state->file;
 
-  /* ref here because we might be removing the last ref when we
-   * mark the file gone below, but we need to keep a ref at
-   * least long enough to send the change notification.
-   */
-  nautilus_file_ref(get_info_file);
+  directory->details->get_info_in_progress =
+      g_list_remove(directory->details->get_info_in_progress, state);
+  if (directory->details->get_info_in_progress == NULL) {
+    async_job_end(directory, "file info");
+  }
 
   error = NULL;
   info = g_file_query_info_finish(G_FILE(source_object), res, &error);
 
-  if (info == NULL) {
-    if (error->domain == G_IO_ERROR && error->code == G_IO_ERROR_NOT_FOUND) {
-      /* mark file as gone */
-      nautilus_file_mark_gone(get_info_file);
-    }
-    get_info_file->details->file_info_is_up_to_date = TRUE;
-    nautilus_file_clear_info(get_info_file);
-    get_info_file->details->get_info_failed = TRUE;
-    get_info_file->details->get_info_error = error;
+  if (get_info_file != NULL) {
+    g_assert(NAUTILUS_IS_FILE(get_info_file));
+
+    /* ref here because we might be removing the last ref when we
+     * mark the file gone below, but we need to keep a ref at
+     * least long enough to send the change notification.
+     */
+    nautilus_file_ref(get_info_file);
+
+    if (info == NULL) {
+      if (error->domain == G_IO_ERROR && error->code == G_IO_ERROR_NOT_FOUND) {
+        /* mark file as gone */
+        nautilus_file_mark_gone(get_info_file);
+      }
+      get_info_file->details->file_info_is_up_to_date = TRUE;
+      nautilus_file_clear_info(get_info_file);
+      get_info_file->details->get_info_failed = TRUE;
+      get_info_file->details->get_info_error = error;
+    } else {
+      nautilus_file_update_info(get_info_file, info);
+      g_object_unref(info);
+    }
+
+    nautilus_file_changed(get_info_file);
+
+    /* Now that its info is known, it can get its other attributes */
+    if (!get_info_file->details->is_gone) {
+      nautilus_directory_add_file_to_work_queue(directory, get_info_file);
+    }
+    nautilus_file_unref(get_info_file);
   } else {
-    nautilus_file_update_info(get_info_file, info);
-    g_object_unref(info);
+    g_clear_object(&info);
+    g_clear_error(&error);
   }
 
-  nautilus_file_changed(get_info_file);
-  nautilus_file_unref(get_info_file);
-
-  async_job_end(directory, "file info");
   nautilus_directory_async_state_changed(directory);
 
   nautilus_directory_unref(directory);
@@ -2839,56 +3275,72 @@ static void query_info_callback(GObject *source_object, GAsyncResult *res,
 }
 
 static void file_info_stop(NautilusDirectory *directory) {
+  GetInfoState *state;
   NautilusFile *file;
+  GList *node, *next;
+
+  for (node = directory->details->get_info_in_progress; node != NULL;
+       node = next) {
+    next = node->next;
+    state = node->data;
+    file = state->file;
 
-  if (directory->details->get_info_in_progress != NULL) {
-    file = directory->details->get_info_file;
     if (file != NULL) {
       g_assert(NAUTILUS_IS_FILE(file));
       g_assert(file->details->directory == directory);
       if (is_needy(file, lacks_info, REQUEST_FILE_INFO)) {
-        return;
+        continue;
       }
     }
 
     /* The info is not wanted, so stop it. */
-    file_info_cancel(directory);
+    file_info_query_cancel(directory, state);
+
+    /* It left the work queue when the query started, and might still
+     * need its other attributes. */
+    if (file != NULL) {
+      nautilus_directory_add_file_to_work_queue(directory, file);
+    }
   }
 }
 
+/* Starts reading the info of @file without waiting for the queries already
+ * in flight, up to MAX_FILE_INFO_QUERIES at once. */
 static void file_info_start(NautilusDirectory *directory, NautilusFile *file,
                             gboolean *doing_io) {
   GFile *location;
   GetInfoState *state;
 
-  file_info_stop(directory);
-
-  if (directory->details->get_info_in_progress != NULL) {
-    *doing_io = TRUE;
+  if (get_file_info_state(directory, file) != NULL ||
+      !is_needy(file, lacks_info, REQUEST_FILE_INFO)) {
     return;
   }
 
-  if (!is_needy(file, lacks_info, REQUEST_FILE_INFO)) {
+  if (g_list_length(directory->details->get_info_in_progress) >=
+      MAX_FILE_INFO_QUERIES) {
+    *doing_io = TRUE;
     return;
   }
-  *doing_io = TRUE;
 
-  if (!async_job_start(directory, "file info")) {
+  if (directory->details->get_info_in_progress == NULL &&
+      !async_job_start(directory, "file info")) {
+    *doing_io = TRUE;
     return;
   }
 
-  directory->details->get_info_file = file;
   file->details->get_info_failed = FALSE;
   if (file->details->get_info_error) {
     g_error_free(file->details->get_info_error);
     file->details->get_info_error = NULL;
   }
 
-  state = g_new(GetInfoState, 1);
+  state = g_new0(GetInfoState, 1);
   state->directory = directory;
+  state->file = file;
   state->cancellable = g_cancellable_new();
 
-  directory->details->get_info_in_progress = state;
+  directory->details->get_info_in_progress =
+      g_list_prepend(directory->details->get_info_in_progress, state);
 
   location = nautilus_file_get_location(file);
   g_file_query_info_async(location, NAUTILUS_FILE_DEFAULT_ATTRIBUTES, 0,
@@ -2903,14 +3355,8 @@ static void thumbnail_done(NautilusDirectory *directory, NautilusFile *file,
   time_t thumb_mtime = 0;
 
   file->details->thumbnail_is_up_to_date = TRUE;
-  if (file->details->thumbnail) {
-    g_object_unref(file->details->thumbnail);
-    file->details->thumbnail = NULL;
-  }
-  if (file->details->scaled_thumbnail) {
-    g_object_unref(file->details->scaled_thumbnail);
-    file->details->scaled_thumbnail = NULL;
-  }
+  nautilus_thumbnail_cache_remove(file->details->thumbnail_handle);
+  file->details->thumbnail_handle = 0;
 
   if (pixbuf) {
     thumb_mtime_str = gdk_pixbuf_get_option(pixbuf, "tEXt::Thumb::MTime");
@@ -2919,54 +3365,61 @@ static void thumbnail_done(NautilusDirectory *directory, NautilusFile *file,
     }
 
     if (thumb_mtime == 0 || thumb_mtime == file->details->mtime) {
-      file->details->thumbnail = g_object_ref(pixbuf);
+      file->details->thumbnail_handle = nautilus_thumbnail_cache_insert(pixbuf);
       file->details->thumbnail_mtime = thumb_mtime;
     } else {
       g_free(file->details->thumbnail_path);
       file->details->thumbnail_path = NULL;
     }
   }
-
-  nautilus_directory_async_state_changed(directory);
 }
 
-static void thumbnail_stop(NautilusDirectory *directory) {
-  NautilusFile *file;
-
-  if (directory->details->thumbnail_state != NULL) {
-    file = directory->details->thumbnail_state->file;
+static ThumbnailState *get_thumbnail_state(NautilusDirectory *directory,
+                                           NautilusFile *file) {
+  GList *node;
 
-    if (file != NULL) {
-      g_assert(NAUTILUS_IS_FILE(file));
-      g_assert(file->details->directory == directory);
-      if (is_needy(file, lacks_thumbnail, REQUEST_THUMBNAIL)) {
-        return;
-      }
+  for (node = directory->details->thumbnail_loads; node != NULL;
+       node = node->next) {
+    if (((ThumbnailState *)node->data)->file == file) {
+      return node->data;
     }
+  }
 
-    /* The link info is not wanted, so stop it. */
-    thumbnail_cancel(directory);
+  for (node = directory->details->thumbnail_results; node != NULL;
+       node = node->next) {
+    if (((ThumbnailState *)node->data)->file == file) {
+      return node->data;
+    }
   }
+
+  return NULL;
 }
 
-static void thumbnail_got_pixbuf(NautilusDirectory *directory,
-                                 NautilusFile *file, GdkPixbuf *pixbuf) {
-  nautilus_directory_ref(directory);
+static void thumbnail_stop(NautilusDirectory *directory) {
+  ThumbnailState *state;
+  GList *node, *next;
 
-  nautilus_file_ref(file);
-  thumbnail_done(directory, file, pixbuf);
-  nautilus_file_changed(file);
-  nautilus_file_unref(file);
+  for (node = directory->details->thumbnail_loads; node != NULL; node = next) {
+    next = node->next;
+    state = node->data;
 
-  if (pixbuf) {
-    g_object_unref(pixbuf);
-  }
+    if (state->file != NULL) {
+      g_assert(NAUTILUS_IS_FILE(state->file));
+      g_assert(state->file->details->directory == directory);
+      if (is_needy(state->file, lacks_thumbnail, REQUEST_THUMBNAIL)) {
+        continue;
+      }
+    }
 
-  nautilus_directory_unref(directory);
+    /* The thumbnail is not wanted, so stop loading it. */
+    thumbnail_load_cancel(directory, state);
+  }
 }
 
 static void thumbnail_state_free(ThumbnailState *state) {
   g_object_unref(state->cancellable);
+  g_free(state->path);
+  g_clear_object(&state->pixbuf);
   g_free(state);
 }
 
@@ -3032,75 +3485,137 @@ static GdkPixbuf *get_pixbuf_for_content(goffset file_len,
   return pixbuf;
 }
 
-static void thumbnail_read_callback(GObject *source_object, GAsyncResult *res,
-                                    gpointer user_data) {
+static gboolean thumbnail_deliver_batch(gpointer user_data) {
+  NautilusDirectory *directory;
   ThumbnailState *state;
-  gsize file_size;
+  GList *results, *changed_files, *node;
+
+  directory = user_data;
+  directory->details->thumbnail_batch_id = 0;
+
+  results = g_list_reverse(
+      g_steal_pointer(&directory->details->thumbnail_results));
+
+  nautilus_directory_ref(directory);
+
+  changed_files = NULL;
+  for (node = results; node != NULL; node = node->next) {
+    state = node->data;
+
+    if (state->file == NULL) {
+      continue;
+    }
+
+    thumbnail_done(directory, state->file, state->pixbuf);
+    if (nautilus_file_is_self_owned(state->file)) {
+      nautilus_file_changed(state->file);
+    } else {
+      changed_files =
+          g_list_prepend(changed_files, nautilus_file_ref(state->file));
+    }
+  }
+  g_list_free_full(results, (GDestroyNotify)thumbnail_state_free);
+
+  /* Tell the views about the whole batch at once */
+  changed_files = g_list_reverse(changed_files);
+  nautilus_directory_emit_change_signals(directory, changed_files);
+  nautilus_file_list_free(changed_files);
+
+  nautilus_directory_async_state_changed(directory);
+  nautilus_directory_unref(directory);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Runs in a worker thread, so that reading and decoding the thumbnail does
+ * not block the main loop */
+static void thumbnail_load_thread(GTask *task, gpointer source_object,
+                                  gpointer task_data,
+                                  GCancellable *cancellable) {
+  ThumbnailState *state;
+  g_autoptr(GFile) location = NULL;
   char *file_contents;
-  gboolean result;
+  gsize file_size;
+
+  state = task_data;
+  location = g_file_new_for_path(state->path);
+
+  nautilus_trace_begin("thumbnail load", NULL);
+  if (g_file_load_contents(location, cancellable, &file_contents, &file_size,
+                           NULL, NULL)) {
+    state->pixbuf = get_pixbuf_for_content(file_size, file_contents);
+    g_free(file_contents);
+  }
+  nautilus_trace_end("thumbnail load", NULL);
+}
+
+static void thumbnail_load_callback(GObject *source_object, GAsyncResult *res,
+                                    gpointer user_data) {
+  ThumbnailState *state;
   NautilusDirectory *directory;
-  GdkPixbuf *pixbuf;
 
-  state = user_data;
+  state = g_task_get_task_data(G_TASK(res));
+  directory = state->directory;
 
-  if (state->directory == NULL) {
+  if (directory == NULL) {
     /* Operation was cancelled. Bail out */
     thumbnail_state_free(state);
     return;
   }
 
-  directory = nautilus_directory_ref(state->directory);
-
-  result = g_file_load_contents_finish(G_FILE(source_object), res,
-                                       &file_contents, &file_size, NULL, NULL);
+  directory->details->thumbnail_loads =
+      g_list_remove(directory->details->thumbnail_loads, state);
+  directory->details->thumbnail_results =
+      g_list_prepend(directory->details->thumbnail_results, state);
 
-  pixbuf = NULL;
-  if (result) {
-    pixbuf = get_pixbuf_for_content(file_size, file_contents);
-    g_free(file_contents);
+  if (directory->details->thumbnail_loads == NULL) {
+    async_job_end(directory, "thumbnail");
   }
 
-  state->directory->details->thumbnail_state = NULL;
-  async_job_end(state->directory, "thumbnail");
-
-  thumbnail_got_pixbuf(state->directory, state->file, pixbuf);
-
-  thumbnail_state_free(state);
+  if (directory->details->thumbnail_batch_id == 0) {
+    directory->details->thumbnail_batch_id = g_timeout_add(
+        THUMBNAIL_BATCH_INTERVAL, thumbnail_deliver_batch, directory);
+  }
 
-  nautilus_directory_unref(directory);
+  /* A load finished, so the next one can start */
+  nautilus_directory_async_state_changed(directory);
 }
 
 static void thumbnail_start(NautilusDirectory *directory, NautilusFile *file,
                             gboolean *doing_io) {
-  GFile *location;
+  g_autoptr(GTask) task = NULL;
   ThumbnailState *state;
 
-  if (directory->details->thumbnail_state != NULL) {
-    *doing_io = TRUE;
+  if (!is_needy(file, lacks_thumbnail, REQUEST_THUMBNAIL) ||
+      get_thumbnail_state(directory, file) != NULL) {
     return;
   }
 
-  if (!is_needy(file, lacks_thumbnail, REQUEST_THUMBNAIL)) {
+  if (g_list_length(directory->details->thumbnail_loads) >=
+      MAX_THUMBNAIL_LOADS) {
+    *doing_io = TRUE;
     return;
   }
-  *doing_io = TRUE;
 
-  if (!async_job_start(directory, "thumbnail")) {
+  if (directory->details->thumbnail_loads == NULL &&
+      !async_job_start(directory, "thumbnail")) {
+    *doing_io = TRUE;
     return;
   }
 
+  /* The file can move on in the queue while its thumbnail is loading */
   state = g_new0(ThumbnailState, 1);
   state->directory = directory;
   state->file = file;
   state->cancellable = g_cancellable_new();
+  state->path = g_strdup(file->details->thumbnail_path);
 
-  location = g_file_new_for_path(file->details->thumbnail_path);
+  directory->details->thumbnail_loads =
+      g_list_prepend(directory->details->thumbnail_loads, state);
 
-  directory->details->thumbnail_state = state;
-
-  g_file_load_contents_async(location, state->cancellable,
-                             thumbnail_read_callback, state);
-  g_object_unref(location);
+  task = g_task_new(NULL, state->cancellable, thumbnail_load_callback, NULL);
+  g_task_set_task_data(task, state, NULL);
+  g_task_run_in_thread(task, thumbnail_load_thread);
 }
 
 static void mount_stop(NautilusDirectory *directory) {
@@ -3405,7 +3920,24 @@ static void filesystem_info_start(NautilusDirectory *directory,
   g_object_unref(location);
 }
 
+static void extension_info_batch_cancel(NautilusDirectory *directory,
+                                        ExtensionInfoBatch *batch) {
+  g_cancellable_cancel(batch->cancellable);
+  batch->directory = NULL;
+
+  directory->details->extension_info_batches =
+      g_list_remove(directory->details->extension_info_batches, batch);
+  if (directory->details->extension_info_batches == NULL) {
+    async_job_end(directory, "extension info batch");
+  }
+}
+
 static void extension_info_cancel(NautilusDirectory *directory) {
+  while (directory->details->extension_info_batches != NULL) {
+    extension_info_batch_cancel(
+        directory, directory->details->extension_info_batches->data);
+  }
+
   if (directory->details->extension_info_in_progress != NULL) {
     if (directory->details->extension_info_idle) {
       g_source_remove(directory->details->extension_info_idle);
@@ -3424,7 +3956,35 @@ static void extension_info_cancel(NautilusDirectory *directory) {
   }
 }
 
+static gboolean batch_is_needed(ExtensionInfoBatch *batch) {
+  NautilusFile *file;
+  GList *node;
+
+  for (node = batch->files; node != NULL; node = node->next) {
+    file = node->data;
+    if (is_needy(file, lacks_extension_info, REQUEST_EXTENSION_INFO)) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
 static void extension_info_stop(NautilusDirectory *directory) {
+  ExtensionInfoBatch *batch;
+  GList *node, *next;
+
+  for (node = directory->details->extension_info_batches; node != NULL;
+       node = next) {
+    next = node->next;
+    batch = node->data;
+
+    /* None of the files wants the info anymore, so stop it. */
+    if (!batch_is_needed(batch)) {
+      extension_info_batch_cancel(directory, batch);
+    }
+  }
+
   if (directory->details->extension_info_in_progress != NULL) {
     NautilusFile *file;
 
@@ -3501,19 +4061,184 @@ static void info_provider_callback(NautilusInfoProvider *provider,
       G_PRIORITY_DEFAULT_IDLE, info_provider_idle_callback, response, g_free);
 }
 
+static void extension_info_batch_free(ExtensionInfoBatch *batch) {
+  g_object_unref(batch->provider);
+  g_object_unref(batch->cancellable);
+  nautilus_file_list_free(batch->files);
+  g_hash_table_destroy(batch->file_set);
+  g_free(batch);
+}
+
+static ExtensionInfoBatch *
+get_extension_info_batch(NautilusDirectory *directory, NautilusFile *file,
+                         NautilusInfoProvider *provider) {
+  ExtensionInfoBatch *batch;
+  GList *node;
+
+  for (node = directory->details->extension_info_batches; node != NULL;
+       node = node->next) {
+    batch = node->data;
+    if (batch->provider == provider &&
+        g_hash_table_contains(batch->file_set, file)) {
+      return batch;
+    }
+  }
+
+  return NULL;
+}
+
+static void extension_info_batch_callback(GObject *source_object,
+                                          GAsyncResult *res,
+                                          gpointer user_data) {
+  ExtensionInfoBatch *batch;
+  NautilusDirectory *directory;
+  g_autoptr(GError) error = NULL;
+  NautilusFile *file;
+  GList *node, *link;
+  GList *done_files;
+
+  batch = user_data;
+
+  /* The provider adds the info to the files here, whatever happens next */
+  if (!nautilus_info_provider_update_file_info_batch_finish(
+          batch->provider, res, &error) &&
+      !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+    g_warning("Could not update the info of %u files: %s",
+              g_hash_table_size(batch->file_set), error->message);
+  }
+
+  directory = batch->directory;
+  if (directory == NULL) {
+    /* Operation was cancelled. Bail out */
+    extension_info_batch_free(batch);
+    return;
+  }
+
+  nautilus_directory_ref(directory);
+
+  directory->details->extension_info_batches =
+      g_list_remove(directory->details->extension_info_batches, batch);
+  if (directory->details->extension_info_batches == NULL) {
+    async_job_end(directory, "extension info batch");
+  }
+
+  /* A failure counts as done too, like for a single file */
+  done_files = NULL;
+  for (node = batch->files; node != NULL; node = node->next) {
+    file = node->data;
+
+    link = g_list_find(file->details->pending_info_providers, batch->provider);
+    if (link == NULL) {
+      continue;
+    }
+
+    file->details->pending_info_providers =
+        g_list_delete_link(file->details->pending_info_providers, link);
+    g_object_unref(batch->provider);
+
+    if (file->details->pending_info_providers == NULL) {
+      nautilus_file_apply_extension_info(file);
+      done_files = g_list_prepend(done_files, nautilus_file_ref(file));
+    }
+  }
+
+  /* Tell about all of the files at once */
+  nautilus_directory_emit_change_signals(directory, done_files);
+  nautilus_file_list_free(done_files);
+
+  extension_info_batch_free(batch);
+
+  nautilus_directory_async_state_changed(directory);
+  nautilus_directory_unref(directory);
+}
+
+/* Hands @provider the files of the extension queue that are waiting for it,
+ * starting from the head. */
+static void extension_info_batch_start(NautilusDirectory *directory,
+                                       NautilusInfoProvider *provider) {
+  ExtensionInfoBatch *batch;
+  NautilusFile *file;
+  GList *node;
+
+  if (g_list_length(directory->details->extension_info_batches) >=
+      MAX_EXTENSION_INFO_BATCHES) {
+    return;
+  }
+
+  if (directory->details->extension_info_batches == NULL &&
+      !async_job_start(directory, "extension info batch")) {
+    return;
+  }
+
+  batch = g_new0(ExtensionInfoBatch, 1);
+  batch->directory = directory;
+  batch->provider = g_object_ref(provider);
+  batch->cancellable = g_cancellable_new();
+  batch->file_set = g_hash_table_new(NULL, NULL);
+
+  for (node = nautilus_file_queue_peek_head_link(
+           directory->details->extension_queue);
+       node != NULL &&
+       g_hash_table_size(batch->file_set) < EXTENSION_INFO_BATCH_SIZE;
+       node = node->next) {
+    file = node->data;
+
+    if (g_list_find(file->details->pending_info_providers, provider) == NULL ||
+        !is_needy(file, lacks_extension_info, REQUEST_EXTENSION_INFO) ||
+        get_extension_info_batch(directory, file, provider) != NULL) {
+      continue;
+    }
+
+    batch->files = g_list_prepend(batch->files, nautilus_file_ref(file));
+    g_hash_table_add(batch->file_set, file);
+  }
+  batch->files = g_list_reverse(batch->files);
+
+  directory->details->extension_info_batches =
+      g_list_prepend(directory->details->extension_info_batches, batch);
+
+  nautilus_info_provider_update_file_info_batch_async(
+      provider, batch->files, batch->cancellable,
+      extension_info_batch_callback, batch);
+}
+
 static void extension_info_start(NautilusDirectory *directory,
                                  NautilusFile *file, gboolean *doing_io) {
   NautilusInfoProvider *provider;
   NautilusOperationResult result;
   NautilusOperationHandle *handle;
   GClosure *update_complete;
+  GList *node;
 
-  if (directory->details->extension_info_in_progress != NULL) {
+  if (!is_needy(file, lacks_extension_info, REQUEST_EXTENSION_INFO)) {
+    return;
+  }
+
+  /* The providers that support it get this file and the next ones in a
+   * batch, all of them at the same time. */
+  provider = NULL;
+  for (node = file->details->pending_info_providers; node != NULL;
+       node = node->next) {
+    if (!nautilus_info_provider_supports_batch(node->data)) {
+      if (provider == NULL) {
+        provider = node->data;
+      }
+      continue;
+    }
+
+    if (get_extension_info_batch(directory, file, node->data) == NULL) {
+      extension_info_batch_start(directory, node->data);
+    }
     *doing_io = TRUE;
+  }
+
+  /* The others get one file at a time */
+  if (provider == NULL) {
     return;
   }
 
-  if (!is_needy(file, lacks_extension_info, REQUEST_EXTENSION_INFO)) {
+  if (directory->details->extension_info_in_progress != NULL) {
+    *doing_io = TRUE;
     return;
   }
   *doing_io = TRUE;
@@ -3522,8 +4247,6 @@ static void extension_info_start(NautilusDirectory *directory,
     return;
   }
 
-  provider = file->details->pending_info_providers->data;
-
   update_complete =
       g_cclosure_new(G_CALLBACK(info_provider_callback), directory, NULL);
   g_closure_set_marshal(update_complete, g_cclosure_marshal_generic);
@@ -3574,6 +4297,14 @@ static void start_or_stop_io(NautilusDirectory *directory) {
       return;
     }
 
+    if (get_file_info_state(directory, file) != NULL) {
+      /* Comes back to the queue once its info is read, so that the
+       * next files can be queried meanwhile */
+      nautilus_file_queue_remove(directory->details->high_priority_queue,
+                                 file);
+      continue;
+    }
+
     move_file_to_low_priority_queue(directory, file);
   }
 
@@ -3667,9 +4398,11 @@ void nautilus_directory_cancel(NautilusDirectory *directory) {
 
 static void cancel_directory_count_for_file(NautilusDirectory *directory,
                                             NautilusFile *file) {
-  if (directory->details->count_in_progress != NULL &&
-      directory->details->count_in_progress->count_file == file) {
-    directory_count_cancel(directory);
+  DirectoryCountState *state;
+
+  state = get_directory_count_state(directory, file);
+  if (state != NULL) {
+    directory_count_state_cancel(directory, state);
   }
 }
 
@@ -3690,16 +4423,26 @@ static void cancel_mime_list_for_file(NautilusDirectory *directory,
 
 static void cancel_file_info_for_file(NautilusDirectory *directory,
                                       NautilusFile *file) {
-  if (directory->details->get_info_file == file) {
-    file_info_cancel(directory);
+  GetInfoState *state;
+
+  state = get_file_info_state(directory, file);
+  if (state != NULL) {
+    file_info_query_cancel(directory, state);
   }
 }
 
 static void cancel_thumbnail_for_file(NautilusDirectory *directory,
                                       NautilusFile *file) {
-  if (directory->details->thumbnail_state != NULL &&
-      directory->details->thumbnail_state->file == file) {
-    thumbnail_cancel(directory);
+  ThumbnailState *state;
+  GList *node;
+
+  for (node = directory->details->thumbnail_loads; node != NULL;
+       node = node->next) {
+    state = node->data;
+    if (state->file == file) {
+      thumbnail_load_cancel(directory, state);
+      break;
+    }
   }
 }
 
@@ -3796,6 +4539,18 @@ void nautilus_directory_add_file_to_work_queue(NautilusDirectory *directory,
   nautilus_file_queue_enqueue(directory->details->high_priority_queue, file);
 }
 
+/* Used for files that are visible, so that their thumbnails and other
+ * low priority attributes are loaded before the rest of the directory. */
+void nautilus_directory_prioritize_file(NautilusDirectory *directory,
+                                        NautilusFile *file) {
+  g_return_if_fail(file->details->directory == directory);
+
+  nautilus_file_queue_move_to_head(directory->details->high_priority_queue,
+                                   file);
+  nautilus_file_queue_move_to_head(directory->details->low_priority_queue,
+                                   file);
+}
+
 static void add_all_files_to_work_queue(NautilusDirectory *directory) {
   GList *node;
   NautilusFile *file;
@@ -33,6 +33,7 @@ typedef struct DirectoryLoadState DirectoryLoadState;
 typedef struct DirectoryCountState DirectoryCountState;
 typedef struct DeepCountState DeepCountState;
 typedef struct GetInfoState GetInfoState;
+typedef struct ExtensionInfoBatch ExtensionInfoBatch;
 typedef struct NewFilesState NewFilesState;
 typedef struct MimeListState MimeListState;
 typedef struct ThumbnailState ThumbnailState;
@@ -100,22 +101,26 @@ struct NautilusDirectoryDetails
 
 	GList *new_files_in_progress; /* list of NewFilesState * */
 
-	DirectoryCountState *count_in_progress;
+	GList *count_in_progress; /* DirectoryCountState being counted */
+	GList *cached_counts_changed; /* NautilusFile given a cached count */
+	guint cached_counts_changed_idle_id;
 
 	NautilusFile *deep_count_file;
 	DeepCountState *deep_count_in_progress;
 
 	MimeListState *mime_list_in_progress;
 
-	NautilusFile *get_info_file;
-	GetInfoState *get_info_in_progress;
+	GList *get_info_in_progress; /* GetInfoState being queried */
 
 	NautilusFile *extension_info_file;
 	NautilusInfoProvider *extension_info_provider;
 	NautilusOperationHandle *extension_info_in_progress;
 	guint extension_info_idle;
+	GList *extension_info_batches; /* ExtensionInfoBatch being updated */
 
-	ThumbnailState *thumbnail_state;
+	GList *thumbnail_loads; /* ThumbnailState being read and decoded */
+	GList *thumbnail_results; /* ThumbnailState waiting for the next batch */
+	guint thumbnail_batch_id;
 
 	MountState *mount_state;
 
@@ -218,7 +223,11 @@ void               nautilus_directory_add_file_to_work_queue          (NautilusD
 								       NautilusFile *file);
 void               nautilus_directory_remove_file_from_work_queue     (NautilusDirectory *directory,
 								       NautilusFile *file);
+void               nautilus_directory_prioritize_file                 (NautilusDirectory *directory,
+								       NautilusFile *file);
 
 
 /* debugging functions */
 int                nautilus_directory_number_outstanding              (void);
+void               nautilus_directory_get_async_job_counts            (guint *n_running,
+								       guint *n_waiting);
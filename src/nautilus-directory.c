@@ -53,6 +53,10 @@ static GParamSpec *properties[NUM_PROPERTIES] = {
 
 static GHashTable *directories;
 
+/* Directories recently left by a view, most recent first. Each one holds a
+ * reference and a monitor, with this queue as client. */
+static GQueue warm_directories = G_QUEUE_INIT;
+
 static NautilusDirectory *nautilus_directory_new(GFile *location);
 static void set_directory_location(NautilusDirectory *directory,
                                    GFile *location);
@@ -166,6 +170,11 @@ static void nautilus_directory_finalize(GObject *object) {
     g_source_remove(directory->details->call_ready_idle_id);
   }
 
+  if (directory->details->cached_counts_changed_idle_id != 0) {
+    g_source_remove(directory->details->cached_counts_changed_idle_id);
+  }
+  nautilus_file_list_free(directory->details->cached_counts_changed);
+
   if (directory->details->location) {
     g_object_unref(directory->details->location);
   }
@@ -1458,6 +1467,67 @@ void nautilus_directory_file_monitor_remove(NautilusDirectory *directory,
       ->file_monitor_remove(directory, client);
 }
 
+#define MAX_WARM_DIRECTORIES 10
+/* Files kept in all the warm directories together */
+#define MAX_WARM_FILES 300000
+
+static void cool_directory(NautilusDirectory *directory) {
+  nautilus_directory_file_monitor_remove(directory, &warm_directories);
+  nautilus_directory_unref(directory);
+}
+
+static void trim_warm_directories(void) {
+  NautilusDirectory *directory;
+  GList *link, *next;
+  guint n_directories;
+  guint n_files;
+
+  n_directories = 0;
+  n_files = 0;
+  for (link = warm_directories.head; link != NULL; link = next) {
+    next = link->next;
+    directory = link->data;
+
+    n_directories++;
+    n_files += g_hash_table_size(directory->details->file_hash);
+    if (n_directories > MAX_WARM_DIRECTORIES || n_files > MAX_WARM_FILES) {
+      n_files -= g_hash_table_size(directory->details->file_hash);
+      n_directories--;
+
+      g_queue_delete_link(&warm_directories, link);
+      cool_directory(directory);
+    }
+  }
+}
+
+/* The monitor keeps the file list up to date while no view shows it, so it
+ * can be shown as is when going back to it. That's only done for local
+ * directories, where monitoring is reliable and cheap. */
+void nautilus_directory_keep_warm(NautilusDirectory *directory) {
+  GList *link;
+
+  g_return_if_fail(NAUTILUS_IS_DIRECTORY(directory));
+
+  if (!NAUTILUS_IS_VFS_DIRECTORY(directory) ||
+      !g_file_is_native(directory->details->location)) {
+    return;
+  }
+
+  link = g_queue_find(&warm_directories, directory);
+  if (link != NULL) {
+    g_queue_unlink(&warm_directories, link);
+    g_queue_push_head_link(&warm_directories, link);
+  } else {
+    nautilus_directory_file_monitor_add(nautilus_directory_ref(directory),
+                                        &warm_directories, TRUE,
+                                        NAUTILUS_FILE_ATTRIBUTE_INFO, NULL,
+                                        NULL);
+    g_queue_push_head(&warm_directories, directory);
+  }
+
+  trim_warm_directories();
+}
+
 void nautilus_directory_force_reload(NautilusDirectory *directory) {
   g_return_if_fail(NAUTILUS_IS_DIRECTORY(directory));
 
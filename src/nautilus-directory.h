@@ -210,6 +210,10 @@ void               nautilus_directory_file_monitor_remove      (NautilusDirector
 								gconstpointer              client);
 void               nautilus_directory_force_reload             (NautilusDirectory         *directory);
 
+/* Keep a directory a view is leaving loaded and monitored for a while, so
+ * that going back to it doesn't read it again. */
+void               nautilus_directory_keep_warm                (NautilusDirectory         *directory);
+
 /* Get a list of all files currently known in the directory. */
 GList *            nautilus_directory_get_file_list            (NautilusDirectory         *directory);
 
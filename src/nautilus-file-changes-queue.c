@@ -41,6 +41,7 @@ typedef struct {
 typedef struct {
   GList *head;
   GList *tail;
+  guint length;
   GMutex mutex;
 } NautilusFileChangesQueue;
 
@@ -73,6 +74,7 @@ nautilus_file_changes_queue_add_common(NautilusFileChangesQueue *queue,
   if (queue->tail == NULL) {
     queue->tail = queue->head;
   }
+  queue->length++;
 
   g_mutex_unlock(&queue->mutex);
 }
@@ -144,6 +146,7 @@ nautilus_file_changes_queue_get_change(NautilusFileChangesQueue *queue) {
     queue->head = g_list_remove_link(queue->head, queue->tail);
     g_list_free_1(queue->tail);
     queue->tail = new_tail;
+    queue->length--;
   }
 
   g_mutex_unlock(&queue->mutex);
@@ -151,6 +154,19 @@ nautilus_file_changes_queue_get_change(NautilusFileChangesQueue *queue) {
   return result;
 }
 
+guint nautilus_file_changes_queue_get_length(void) {
+  NautilusFileChangesQueue *queue;
+  guint length;
+
+  queue = nautilus_file_changes_queue_get();
+
+  g_mutex_lock(&queue->mutex);
+  length = queue->length;
+  g_mutex_unlock(&queue->mutex);
+
+  return length;
+}
+
 enum { CONSUME_CHANGES_MAX_CHUNK = 20 };
 
 static void pairs_list_free(GList *pairs) {
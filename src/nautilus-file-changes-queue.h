@@ -29,3 +29,4 @@ void nautilus_file_changes_queue_file_moved                      (GFile      *fr
 								  GFile      *to);
 
 void nautilus_file_changes_consume_changes                       (gboolean    consume_all);
+guint nautilus_file_changes_queue_get_length                     (void);
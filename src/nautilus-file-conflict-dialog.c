@@ -51,6 +51,7 @@ struct _NautilusFileConflictDialog {
   GtkWidget *skip_button;
   GtkWidget *rename_button;
   GtkWidget *replace_button;
+  GtkWidget *update_button;
   GtkWidget *dest_image;
   GtkWidget *src_image;
 };
@@ -110,6 +111,11 @@ void nautilus_file_conflict_dialog_disable_apply_to_all(
   gtk_widget_hide(fcd->checkbox);
 }
 
+void nautilus_file_conflict_dialog_disable_update(
+    NautilusFileConflictDialog *fcd) {
+  gtk_widget_hide(fcd->update_button);
+}
+
 static void entry_text_changed_cb(GtkEditable *entry,
                                   NautilusFileConflictDialog *dialog) {
   if (g_strcmp0(gtk_entry_get_text(GTK_ENTRY(entry)), "") != 0 &&
@@ -139,6 +145,7 @@ static void on_expanded_notify(GtkExpander *w, GParamSpec *pspec,
                                NautilusFileConflictDialog *dialog) {
   if (gtk_expander_get_expanded(w)) {
     gtk_widget_hide(dialog->replace_button);
+    gtk_widget_set_sensitive(dialog->update_button, FALSE);
     gtk_widget_show(dialog->rename_button);
     gtk_dialog_set_default_response(GTK_DIALOG(dialog),
                                     CONFLICT_RESPONSE_RENAME);
@@ -165,6 +172,7 @@ static void on_expanded_notify(GtkExpander *w, GParamSpec *pspec,
   } else {
     gtk_widget_hide(dialog->rename_button);
     gtk_widget_show(dialog->replace_button);
+    gtk_widget_set_sensitive(dialog->update_button, TRUE);
     gtk_dialog_set_default_response(GTK_DIALOG(dialog),
                                     CONFLICT_RESPONSE_REPLACE);
 
@@ -229,6 +237,8 @@ static void nautilus_file_conflict_dialog_class_init(
                                        replace_button);
   gtk_widget_class_bind_template_child(widget_class, NautilusFileConflictDialog,
                                        skip_button);
+  gtk_widget_class_bind_template_child(widget_class, NautilusFileConflictDialog,
+                                       update_button);
   gtk_widget_class_bind_template_child(widget_class, NautilusFileConflictDialog,
                                        dest_image);
   gtk_widget_class_bind_template_child(widget_class, NautilusFileConflictDialog,
@@ -247,6 +257,7 @@ static gboolean activate_buttons(NautilusFileConflictDialog *fcd) {
   gtk_widget_set_sensitive(GTK_WIDGET(fcd->skip_button), TRUE);
   gtk_widget_set_sensitive(GTK_WIDGET(fcd->rename_button), TRUE);
   gtk_widget_set_sensitive(GTK_WIDGET(fcd->replace_button), TRUE);
+  gtk_widget_set_sensitive(GTK_WIDGET(fcd->update_button), TRUE);
   gtk_widget_set_sensitive(GTK_WIDGET(fcd->expander), TRUE);
   return G_SOURCE_REMOVE;
 }
@@ -257,6 +268,7 @@ void nautilus_file_conflict_dialog_delay_buttons_activation(
   gtk_widget_set_sensitive(GTK_WIDGET(fcd->skip_button), FALSE);
   gtk_widget_set_sensitive(GTK_WIDGET(fcd->rename_button), FALSE);
   gtk_widget_set_sensitive(GTK_WIDGET(fcd->replace_button), FALSE);
+  gtk_widget_set_sensitive(GTK_WIDGET(fcd->update_button), FALSE);
   gtk_widget_set_sensitive(GTK_WIDGET(fcd->expander), FALSE);
 
   g_timeout_add_seconds(BUTTON_ACTIVATION_DELAY_IN_SECONDS,
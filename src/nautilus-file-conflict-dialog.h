@@ -59,6 +59,8 @@ void nautilus_file_conflict_dialog_disable_replace(
     NautilusFileConflictDialog *fcd);
 void nautilus_file_conflict_dialog_disable_apply_to_all(
     NautilusFileConflictDialog *fcd);
+void nautilus_file_conflict_dialog_disable_update(
+    NautilusFileConflictDialog *fcd);
 
 void nautilus_file_conflict_dialog_delay_buttons_activation(
     NautilusFileConflictDialog *fdc);
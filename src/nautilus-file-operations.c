@@ -23,12 +23,16 @@
  */
 
 #include <config.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <locale.h>
 #include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -56,8 +60,14 @@
 #include "nautilus-file-undo-manager.h"
 #include "nautilus-file-undo-operations.h"
 #include "nautilus-file-utilities.h"
+#include "nautilus-global-preferences.h"
 #include "nautilus-gtk4-helpers.h"
+#include "nautilus-job-scheduler.h"
 #include "nautilus-operations-ui-manager.h"
+#ifdef HAVE_LIBARCHIVE
+#include "nautilus-parallel-compressor.h"
+#endif
+#include "nautilus-trace.h"
 #include "nautilus-trash-monitor.h"
 #include "nautilus-ui-utilities.h"
 
@@ -83,6 +93,7 @@ typedef struct {
   gboolean skip_all_conflict;
   gboolean merge_all;
   gboolean replace_all;
+  gboolean update_all;
   gboolean delete_all;
 } CommonJob;
 
@@ -145,6 +156,22 @@ typedef struct {
   guint32 file_mask;
   guint32 dir_permissions;
   guint32 dir_mask;
+  uid_t owner; /* (uid_t) -1 to keep it */
+  gid_t group; /* (gid_t) -1 to keep it */
+
+  /* Counts of items, updated by all the workers */
+  gint n_items_seen;
+  gint n_items_changed;
+  gint n_dirs_seen;
+  gint n_dirs_done;
+  guint64 last_report_time;
+
+  /* Native walk, where each directory is a work item for the pool */
+  GThreadPool *pool;
+  gint pending_dirs;
+  GMutex mutex; /* Protects the undo info */
+  GMutex error_mutex; /* One error dialog at a time */
+  GCond done_cond;
 } SetPermissionsJob;
 
 typedef enum {
@@ -190,19 +217,39 @@ typedef struct {
   GList *source_files;
   GFile *destination_directory;
   GList *output_files;
-  gboolean destination_decided;
-  gboolean extraction_failed;
-
-  gdouble base_progress;
 
-  guint64 archive_compressed_size;
+  /* Several archives are extracted at once. This protects the fields
+   * below, as well as output_files. */
+  GMutex mutex;
+  /* Output files handed out to the extractors, which only create them
+   * later on */
+  GHashTable *reserved_output_files;
+  /* Compressed size of the archives, in proportion of their progress */
+  gdouble extracted_size;
   guint64 total_compressed_size;
   gint total_files;
+  guint archives_left;
+  guint n_workers;
+
+  /* Held while asking the user something, so that the questions about
+   * different archives come one after the other */
+  GMutex prompt_mutex;
 
   NautilusExtractCallback done_callback;
   gpointer done_callback_data;
 } ExtractJob;
 
+typedef struct {
+  ExtractJob *extract_job;
+  GFile *source_file;
+  guint64 compressed_size;
+  /* Owned by extract_job->output_files, set once the extractor decided
+   * where to extract the archive */
+  GFile *output_file;
+  gdouble progress;
+  gboolean failed;
+} ExtractArchive;
+
 typedef struct {
   CommonJob common;
   GList *source_files;
@@ -211,6 +258,7 @@ typedef struct {
   AutoarFormat format;
   AutoarFilter filter;
   gchar *passphrase;
+  gboolean parallel;
 
   guint64 total_size;
   guint total_files;
@@ -926,10 +974,13 @@ static gpointer init_common(gsize job_size, GtkWindow *parent_window,
   common->time = g_timer_new();
   common->inhibit_cookie = 0;
 
+  nautilus_trace_async_begin("file operation", common, NULL);
+
   return common;
 }
 
 static void finalize_common(CommonJob *common) {
+  nautilus_trace_async_end("file operation", common, NULL);
   nautilus_progress_info_finish(common->progress);
 
   if (common->inhibit_cookie != 0) {
@@ -1602,14 +1653,307 @@ static void report_delete_progress(CommonJob *job, SourceInfo *source_info,
 }
 #pragma GCC diagnostic pop
 
+/* Opens a folder that a walk listed before as @dev and @ino. A walk only keeps
+ * the folders it is reading open, however many are queued, and opens the rest
+ * by path when it gets to them. Not following @path if it was swapped for a
+ * symbolic link is not enough then, as any folder above it may have been: the
+ * folder has to be the very same one. Otherwise, fails with ENOENT. */
+static int open_walked_dir(const char *path, dev_t dev, ino_t ino) {
+  struct stat statbuf;
+  int fd;
+
+  fd = open(path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  if (fd == -1) {
+    return -1;
+  }
+
+  if (fstat(fd, &statbuf) == -1 || statbuf.st_dev != dev ||
+      statbuf.st_ino != ino) {
+    close(fd);
+    errno = ENOENT;
+    return -1;
+  }
+
+  return fd;
+}
+
+/* Running out of descriptors or memory says nothing about the folder */
+static gboolean is_resource_errno(int errsv) {
+  return errsv == EMFILE || errsv == ENFILE || errsv == ENOMEM;
+}
+
 typedef void (*DeleteCallback)(GFile *file, GError *error,
                                gpointer callback_data);
 
+/* Local folders are deleted by a pool of workers, each one reading a folder
+ * and unlinking its entries relative to the folder's descriptor. Subfolders
+ * are queued as new work items, and a folder is removed by whichever worker
+ * finishes the last of its children, relative to its parent reopened with
+ * open_walked_dir(). Workers report what they removed through an event
+ * queue, so the callback still runs in the job thread. */
+typedef struct NativeDeleteDir NativeDeleteDir;
+
+struct NativeDeleteDir {
+  NativeDeleteDir *parent;
+  char *path;
+  char *name;
+  dev_t dev;
+  ino_t ino;
+  gint pending; /* The folder's own scan, plus its unfinished subfolders */
+  gint failed;
+  int open_errno;
+};
+
+typedef struct {
+  GThreadPool *pool;
+  GAsyncQueue *events;
+  GCancellable *cancellable;
+  int root_parent_fd;
+  gboolean success;
+} NativeDelete;
+
+typedef struct {
+  char *path; /* NULL once the whole tree is done */
+  GError *error;
+} NativeDeleteEvent;
+
+static void native_delete_event_free(NativeDeleteEvent *event) {
+  g_free(event->path);
+  g_clear_error(&event->error);
+  g_free(event);
+}
+
+static void native_delete_push_event(NativeDelete *delete, char *path,
+                                     int errsv) {
+  NativeDeleteEvent *event;
+
+  event = g_new0(NativeDeleteEvent, 1);
+  event->path = path;
+  if (errsv != 0) {
+    g_set_error_literal(&event->error, G_IO_ERROR, g_io_error_from_errno(errsv),
+                        g_strerror(errsv));
+  }
+
+  g_async_queue_push(delete->events, event);
+}
+
+static int native_delete_remove_dir(NativeDelete *delete,
+                                    NativeDeleteDir *dir) {
+  int parent_fd;
+  int errsv;
+
+  if (dir->parent == NULL) {
+    parent_fd = delete->root_parent_fd;
+  } else {
+    parent_fd =
+        open_walked_dir(dir->parent->path, dir->parent->dev, dir->parent->ino);
+    if (parent_fd == -1) {
+      return errno;
+    }
+  }
+
+  errsv = unlinkat(parent_fd, dir->name, AT_REMOVEDIR) == 0 ? 0 : errno;
+
+  if (dir->parent != NULL) {
+    close(parent_fd);
+  }
+
+  return errsv;
+}
+
+static void native_delete_dir_release(NativeDelete *delete,
+                                      NativeDeleteDir *dir) {
+  NativeDeleteDir *parent;
+  gboolean failed;
+  int errsv;
+
+  while (dir != NULL && g_atomic_int_dec_and_test(&dir->pending)) {
+    parent = dir->parent;
+    failed = g_atomic_int_get(&dir->failed) ||
+             g_cancellable_is_cancelled(delete->cancellable);
+
+    if (!failed) {
+      errsv = native_delete_remove_dir(delete, dir);
+      if (errsv == 0) {
+        native_delete_push_event(delete, g_steal_pointer(&dir->path), 0);
+      } else {
+        /* A folder that could not be read is only worth reporting if it
+         * was not empty */
+        if (dir->open_errno != 0 && (errsv == ENOTEMPTY || errsv == EEXIST)) {
+          errsv = dir->open_errno;
+        }
+        native_delete_push_event(delete, g_steal_pointer(&dir->path), errsv);
+        failed = TRUE;
+      }
+    }
+
+    if (parent == NULL) {
+      close(delete->root_parent_fd);
+      delete->success = !failed;
+      native_delete_push_event(delete, NULL, 0);
+    } else if (failed) {
+      g_atomic_int_set(&parent->failed, TRUE);
+    }
+
+    g_free(dir->path);
+    g_free(dir->name);
+    g_free(dir);
+    dir = parent;
+  }
+}
+
+static void native_delete_dir_func(gpointer data, gpointer user_data) {
+  NativeDeleteDir *dir = data;
+  NativeDelete *delete = user_data;
+  struct dirent *entry;
+  struct stat statbuf;
+  gboolean is_dir;
+  char *path;
+  DIR *dirp;
+  int fd;
+
+  dirp = NULL;
+  fd = -1;
+  if (!g_cancellable_is_cancelled(delete->cancellable)) {
+    fd = open_walked_dir(dir->path, dir->dev, dir->ino);
+    if (fd == -1) {
+      dir->open_errno = errno;
+    } else if ((dirp = fdopendir(fd)) == NULL) {
+      dir->open_errno = errno;
+      close(fd);
+      fd = -1;
+    }
+  }
+
+  /* The folder can't be removed without reading it first, and is reported
+   * as it is, rather than as not empty */
+  if (is_resource_errno(dir->open_errno)) {
+    native_delete_push_event(delete, g_strdup(dir->path), dir->open_errno);
+    g_atomic_int_set(&dir->failed, TRUE);
+  }
+
+  while (dirp != NULL && !g_cancellable_is_cancelled(delete->cancellable) &&
+         (entry = readdir(dirp)) != NULL) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+      continue;
+    }
+
+    /* Subfolders are looked at, to be reopened as the same folder later */
+    is_dir = FALSE;
+    if ((entry->d_type == DT_DIR || entry->d_type == DT_UNKNOWN) &&
+        fstatat(fd, entry->d_name, &statbuf, AT_SYMLINK_NOFOLLOW) == 0) {
+      is_dir = S_ISDIR(statbuf.st_mode);
+    }
+
+    path = g_build_filename(dir->path, entry->d_name, NULL);
+
+    if (is_dir) {
+      NativeDeleteDir *child;
+
+      child = g_new0(NativeDeleteDir, 1);
+      child->parent = dir;
+      child->path = path;
+      child->name = g_strdup(entry->d_name);
+      child->dev = statbuf.st_dev;
+      child->ino = statbuf.st_ino;
+      child->pending = 1;
+
+      g_atomic_int_inc(&dir->pending);
+      g_thread_pool_push(delete->pool, child, NULL);
+    } else if (unlinkat(fd, entry->d_name, 0) == 0) {
+      native_delete_push_event(delete, path, 0);
+    } else {
+      native_delete_push_event(delete, path, errno);
+      g_atomic_int_set(&dir->failed, TRUE);
+    }
+  }
+
+  if (dirp != NULL) {
+    closedir(dirp);
+  }
+
+  native_delete_dir_release(delete, dir);
+}
+
+static gboolean delete_directory_native(GFile *file, const char *path,
+                                        const struct stat *statbuf,
+                                        GCancellable *cancellable,
+                                        DeleteCallback callback,
+                                        gpointer callback_data) {
+  NativeDelete delete = {0};
+  NativeDeleteDir *root;
+  NativeDeleteEvent *event;
+  g_autofree char *parent_path = NULL;
+  int parent_fd;
+
+  parent_path = g_path_get_dirname(path);
+  parent_fd = open(parent_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (parent_fd == -1) {
+    if (callback) {
+      g_autoptr(GError) error = NULL;
+      int errsv = errno;
+
+      g_set_error_literal(&error, G_IO_ERROR, g_io_error_from_errno(errsv),
+                          g_strerror(errsv));
+      callback(file, error, callback_data);
+    }
+
+    return FALSE;
+  }
+
+  delete.cancellable = cancellable;
+  delete.root_parent_fd = parent_fd;
+  delete.events = g_async_queue_new();
+  delete.pool = g_thread_pool_new(native_delete_dir_func, &delete,
+                                  g_get_num_processors(), FALSE, NULL);
+
+  root = g_new0(NativeDeleteDir, 1);
+  root->path = g_strdup(path);
+  root->name = g_path_get_basename(path);
+  root->dev = statbuf->st_dev;
+  root->ino = statbuf->st_ino;
+  root->pending = 1;
+  g_thread_pool_push(delete.pool, root, NULL);
+
+  while ((event = g_async_queue_pop(delete.events))->path != NULL) {
+    if (callback) {
+      g_autoptr(GFile) event_file = NULL;
+
+      if (strcmp(event->path, path) == 0) {
+        event_file = g_object_ref(file);
+      } else {
+        event_file = g_file_new_for_path(event->path);
+      }
+
+      callback(event_file, event->error, callback_data);
+    }
+
+    native_delete_event_free(event);
+  }
+  native_delete_event_free(event);
+
+  g_thread_pool_free(delete.pool, FALSE, TRUE);
+  g_async_queue_unref(delete.events);
+
+  return delete.success;
+}
+
 static gboolean delete_file_recursively(GFile *file, GCancellable *cancellable,
                                         DeleteCallback callback,
                                         gpointer callback_data) {
   gboolean success;
   g_autoptr(GError) error = NULL;
+  g_autofree char *path = NULL;
+  struct stat statbuf;
+
+  if (g_file_is_native(file)) {
+    path = g_file_get_path(file);
+  }
+
+  if (path != NULL && lstat(path, &statbuf) == 0 && S_ISDIR(statbuf.st_mode)) {
+    return delete_directory_native(file, path, &statbuf, cancellable,
+                                   callback, callback_data);
+  }
 
   do {
     g_autoptr(GFileEnumerator) enumerator = NULL;
@@ -1930,8 +2274,14 @@ static void trash_file(CommonJob *job, GFile *file, gboolean *skipped_file,
     nautilus_file_changes_queue_file_removed(file);
 
     if (job->undo_info != NULL) {
+      g_autoptr(GFile) trashed_file = NULL;
+
+      /* Record the item created in the trash, so that undoing doesn't need
+       * to look for it in the whole trash. */
+      trashed_file = nautilus_find_trashed_file(
+          file, g_get_real_time() / G_USEC_PER_SEC);
       nautilus_file_undo_info_trash_add_file(
-          NAUTILUS_FILE_UNDO_INFO_TRASH(job->undo_info), file);
+          NAUTILUS_FILE_UNDO_INFO_TRASH(job->undo_info), file, trashed_file);
     }
 
     report_trash_progress(job, source_info, transfer_info);
@@ -2235,7 +2585,9 @@ static void trash_or_delete_internal_async(
 
   task = g_task_new(NULL, NULL, delete_task_done, job);
   g_task_set_task_data(task, job, NULL);
-  g_task_run_in_thread(task, trash_or_delete_internal);
+  nautilus_job_scheduler_run_in_thread(task, trash_or_delete_internal,
+                                       job->common.progress, job->files->data,
+                                       NULL);
   g_object_unref(task);
 }
 
@@ -3655,6 +4007,39 @@ static gboolean is_dir(GFile *file) {
   return file_type == G_FILE_TYPE_DIRECTORY;
 }
 
+/* For the Update choice of the conflict dialog: whether @dest has to be
+ * overwritten with @src. If not, @src is skipped, as mv -u does. */
+static gboolean needs_update(CopyMoveJob *copy_job, GFile *src, GFile *dest) {
+  CommonJob *job;
+
+  job = (CommonJob *)copy_job;
+
+  return !nautilus_is_up_to_date_copy(
+      src, dest,
+      g_settings_get_boolean(nautilus_preferences,
+                             NAUTILUS_PREFERENCES_UPDATE_COMPARES_CONTENTS),
+      job->cancellable);
+}
+
+/* A move that skips an up to date @src only takes it away when @dest has the
+ * very same bytes, so that nothing can be lost. The job did not move it, so
+ * it is left out of the undo information. */
+static void remove_duplicate_source(CopyMoveJob *copy_job, GFile *src,
+                                    GFile *dest) {
+  CommonJob *job;
+
+  job = (CommonJob *)copy_job;
+
+  if (!copy_job->is_move ||
+      !nautilus_file_contents_are_equal(src, dest, job->cancellable)) {
+    return;
+  }
+
+  if (g_file_delete(src, job->cancellable, NULL)) {
+    nautilus_file_changes_queue_file_removed(src);
+  }
+}
+
 static GFile *map_possibly_volatile_file_to_real(GFile *volatile_file,
                                                  GCancellable *cancellable,
                                                  GError **error) {
@@ -4191,7 +4576,7 @@ static FileConflictResponse *handle_copy_move_conflict(CommonJob *job,
 
   basename = g_file_get_basename(dest);
   suggested_file =
-      nautilus_generate_unique_file_in_directory(dest_dir, basename);
+      nautilus_generate_unique_file_in_directory(dest_dir, basename, NULL);
   suggestion = g_file_get_basename(suggested_file);
 
   response = copy_move_conflict_ask_user_action(job->parent_window,
@@ -4491,7 +4876,18 @@ retry:
       goto retry;
     }
 
-    if ((is_merge && job->merge_all) || (!is_merge && job->replace_all)) {
+    if ((is_merge && (job->merge_all || job->update_all)) ||
+        (!is_merge && job->replace_all)) {
+      overwrite = TRUE;
+      goto retry;
+    }
+
+    if (!is_merge && job->update_all) {
+      if (!needs_update(copy_job, src, dest)) {
+        remove_duplicate_source(copy_job, src, dest);
+        goto out;
+      }
+
       overwrite = TRUE;
       goto retry;
     }
@@ -4523,6 +4919,21 @@ retry:
       overwrite = TRUE;
       file_conflict_response_free(response);
       goto retry;
+    } else if (response->id == CONFLICT_RESPONSE_UPDATE) {
+      /* The files of an updated folder are updated without asking, and
+       * so are the later conflicts since they share the job. */
+      if (response->apply_to_all || is_merge) {
+        job->update_all = TRUE;
+      }
+      file_conflict_response_free(response);
+
+      if (!is_merge && !needs_update(copy_job, src, dest)) {
+        remove_duplicate_source(copy_job, src, dest);
+        goto out;
+      }
+
+      overwrite = TRUE;
+      goto retry;
     } else if (response->id == CONFLICT_RESPONSE_RENAME) {
       g_object_unref(dest);
       dest = get_target_file_for_display_name(dest_dir, response->new_name);
@@ -4833,11 +5244,12 @@ static void nautilus_file_operations_copy(GTask *task, gpointer source_object,
   copy_files(job, dest_fs_id, &source_info, &transfer_info);
 }
 
-void nautilus_file_operations_copy_sync(GList *files, GFile *target_dir) {
+static void copy_sync(GList *files, GFile *target_dir, gboolean update_all) {
   GTask *task;
   CopyMoveJob *job;
 
   job = copy_job_setup(files, target_dir, NULL, NULL, NULL, NULL);
+  job->common.update_all = update_all;
 
   task = g_task_new(NULL, job->common.cancellable, NULL, job);
   g_task_set_task_data(task, job, NULL);
@@ -4850,6 +5262,15 @@ void nautilus_file_operations_copy_sync(GList *files, GFile *target_dir) {
   copy_task_done(NULL, NULL, job);
 }
 
+void nautilus_file_operations_copy_sync(GList *files, GFile *target_dir) {
+  copy_sync(files, target_dir, FALSE);
+}
+
+void nautilus_file_operations_copy_update_sync(GList *files,
+                                               GFile *target_dir) {
+  copy_sync(files, target_dir, TRUE);
+}
+
 void nautilus_file_operations_copy_async(
     GList *files, GFile *target_dir, GtkWindow *parent_window,
     NautilusFileOperationsDBusData *dbus_data,
@@ -4862,7 +5283,9 @@ void nautilus_file_operations_copy_async(
 
   task = g_task_new(NULL, job->common.cancellable, copy_task_done, job);
   g_task_set_task_data(task, job, NULL);
-  g_task_run_in_thread(task, nautilus_file_operations_copy);
+  nautilus_job_scheduler_run_in_thread(task, nautilus_file_operations_copy,
+                                       job->common.progress, job->files->data,
+                                       job->destination);
   g_object_unref(task);
 }
 
@@ -5075,7 +5498,18 @@ retry:
       goto retry;
     }
 
-    if ((is_merge && job->merge_all) || (!is_merge && job->replace_all)) {
+    if ((is_merge && (job->merge_all || job->update_all)) ||
+        (!is_merge && job->replace_all)) {
+      overwrite = TRUE;
+      goto retry;
+    }
+
+    if (!is_merge && job->update_all) {
+      if (!needs_update(move_job, src, dest)) {
+        remove_duplicate_source(move_job, src, dest);
+        goto out;
+      }
+
       overwrite = TRUE;
       goto retry;
     }
@@ -5107,6 +5541,21 @@ retry:
       overwrite = TRUE;
       file_conflict_response_free(response);
       goto retry;
+    } else if (response->id == CONFLICT_RESPONSE_UPDATE) {
+      /* The files of an updated folder are updated without asking, and
+       * so are the later conflicts since they share the job. */
+      if (response->apply_to_all || is_merge) {
+        job->update_all = TRUE;
+      }
+      file_conflict_response_free(response);
+
+      if (!is_merge && !needs_update(move_job, src, dest)) {
+        remove_duplicate_source(move_job, src, dest);
+        goto out;
+      }
+
+      overwrite = TRUE;
+      goto retry;
     } else if (response->id == CONFLICT_RESPONSE_RENAME) {
       g_object_unref(dest);
       dest = get_target_file_for_display_name(dest_dir, response->new_name);
@@ -5279,11 +5728,12 @@ static CopyMoveJob *move_job_setup(GList *files, GFile *target_dir,
   return job;
 }
 
-void nautilus_file_operations_move_sync(GList *files, GFile *target_dir) {
+static void move_sync(GList *files, GFile *target_dir, gboolean update_all) {
   GTask *task;
   CopyMoveJob *job;
 
   job = move_job_setup(files, target_dir, NULL, NULL, NULL, NULL);
+  job->common.update_all = update_all;
   task = g_task_new(NULL, job->common.cancellable, NULL, job);
   g_task_set_task_data(task, job, NULL);
   g_task_run_in_thread_sync(task, nautilus_file_operations_move);
@@ -5295,6 +5745,15 @@ void nautilus_file_operations_move_sync(GList *files, GFile *target_dir) {
   move_task_done(NULL, NULL, job);
 }
 
+void nautilus_file_operations_move_sync(GList *files, GFile *target_dir) {
+  move_sync(files, target_dir, FALSE);
+}
+
+void nautilus_file_operations_move_update_sync(GList *files,
+                                               GFile *target_dir) {
+  move_sync(files, target_dir, TRUE);
+}
+
 void nautilus_file_operations_move_async(
     GList *files, GFile *target_dir, GtkWindow *parent_window,
     NautilusFileOperationsDBusData *dbus_data,
@@ -5307,7 +5766,9 @@ void nautilus_file_operations_move_async(
 
   task = g_task_new(NULL, job->common.cancellable, move_task_done, job);
   g_task_set_task_data(task, job, NULL);
-  g_task_run_in_thread(task, nautilus_file_operations_move);
+  nautilus_job_scheduler_run_in_thread(task, nautilus_file_operations_move,
+                                       job->common.progress, job->files->data,
+                                       job->destination);
   g_object_unref(task);
 }
 
@@ -5709,6 +6170,9 @@ static void set_permissions_task_done(GObject *source_object, GAsyncResult *res,
   job = user_data;
 
   g_object_unref(job->file);
+  g_mutex_clear(&job->mutex);
+  g_mutex_clear(&job->error_mutex);
+  g_cond_clear(&job->done_cond);
 
   if (job->done_callback) {
     job->done_callback(!job_aborted((CommonJob *)job), job->done_callback_data);
@@ -5717,6 +6181,272 @@ static void set_permissions_task_done(GObject *source_object, GAsyncResult *res,
   finalize_common((CommonJob *)job);
 }
 
+static void report_set_permissions_progress(SetPermissionsJob *job,
+                                            gboolean force) {
+  gint n_items_seen;
+  gint n_items_changed;
+  guint64 now;
+
+  now = g_get_monotonic_time();
+  if (!force && job->last_report_time != 0 &&
+      now - job->last_report_time < PROGRESS_NOTIFY_INTERVAL) {
+    return;
+  }
+  job->last_report_time = now;
+
+  n_items_seen = g_atomic_int_get(&job->n_items_seen);
+  n_items_changed = g_atomic_int_get(&job->n_items_changed);
+
+  nautilus_progress_info_take_details(
+      job->common.progress,
+      g_strdup_printf(ngettext("Changed %'d of %'d item",
+                               "Changed %'d of %'d items", n_items_seen),
+                      n_items_changed, n_items_seen));
+
+  /* The total is not known until the walk ends, the folders found so far
+   * are the best estimate */
+  nautilus_progress_info_set_progress(
+      job->common.progress, g_atomic_int_get(&job->n_dirs_done),
+      MAX(g_atomic_int_get(&job->n_dirs_seen), 1));
+}
+
+static guint32 get_new_mode(SetPermissionsJob *job, guint32 mode,
+                            gboolean is_dir) {
+  if (is_dir) {
+    return (mode & ~job->dir_mask) | job->dir_permissions;
+  } else {
+    return (mode & ~job->file_mask) | job->file_permissions;
+  }
+}
+
+static gboolean needs_owner_change(SetPermissionsJob *job, uid_t uid,
+                                   gid_t gid) {
+  return (job->owner != (uid_t)-1 && job->owner != uid) ||
+         (job->group != (gid_t)-1 && job->group != gid);
+}
+
+static void add_original_permissions(SetPermissionsJob *job, GFile *file,
+                                     guint32 mode) {
+  if (job->common.undo_info == NULL) {
+    return;
+  }
+
+  g_mutex_lock(&job->mutex);
+  nautilus_file_undo_info_rec_permissions_add_file(
+      NAUTILUS_FILE_UNDO_INFO_REC_PERMISSIONS(job->common.undo_info), file,
+      mode);
+  g_mutex_unlock(&job->mutex);
+}
+
+/* A folder waiting to be walked, reopened with open_walked_dir() */
+typedef struct {
+  char *path;
+  dev_t dev;
+  ino_t ino;
+} SetPermissionsDir;
+
+static void set_permissions_dir_done(SetPermissionsJob *job,
+                                     SetPermissionsDir *dir) {
+  g_free(dir->path);
+  g_free(dir);
+
+  g_atomic_int_inc(&job->n_dirs_done);
+  if (g_atomic_int_dec_and_test(&job->pending_dirs)) {
+    g_mutex_lock(&job->mutex);
+    g_cond_signal(&job->done_cond);
+    g_mutex_unlock(&job->mutex);
+  }
+}
+
+/* Called from the workers, which take turns to ask */
+static void report_set_permissions_error(SetPermissionsJob *job,
+                                         const char *path, int errsv) {
+  CommonJob *common;
+  g_autoptr(GFile) file = NULL;
+  g_autofree gchar *basename = NULL;
+  char *primary;
+  char *secondary;
+  int response;
+
+  common = (CommonJob *)job;
+
+  g_mutex_lock(&job->error_mutex);
+
+  if (job_aborted(common) || common->skip_all_error) {
+    g_mutex_unlock(&job->error_mutex);
+    return;
+  }
+
+  file = g_file_new_for_path(path);
+  basename = get_basename(file);
+  primary = g_strdup(_("Error while setting permissions."));
+  if (errsv == EACCES) {
+    secondary =
+        g_strdup_printf(_("The folder “%s” cannot be handled because you "
+                          "do not have permissions to read it."),
+                        basename);
+  } else {
+    secondary = g_strdup_printf(
+        _("There was an error reading the folder “%s”."), basename);
+  }
+
+  response = run_warning(common, primary, secondary, g_strerror(errsv), TRUE,
+                         CANCEL, SKIP_ALL, SKIP, NULL);
+
+  if (response == 0 || response == GTK_RESPONSE_DELETE_EVENT) {
+    abort_job(common);
+  } else if (response == 1) /* skip all */
+  {
+    common->skip_all_error = TRUE;
+  } else if (response == 2) /* skip */
+  {                         /* do nothing */
+  } else {
+    g_assert_not_reached();
+  }
+
+  g_mutex_unlock(&job->error_mutex);
+}
+
+/* Applies the changes to @name in @dir, relative to its descriptor. The
+ * owner is changed first, since changing it clears the setuid and setgid
+ * bits that the new mode may set. */
+static void set_permissions_native_child(SetPermissionsJob *job,
+                                         SetPermissionsDir *dir, int dir_fd,
+                                         const char *name) {
+  struct stat statbuf;
+  gboolean is_dir;
+  gboolean owner_changed;
+  gboolean changed;
+  guint32 mode;
+
+  if (fstatat(dir_fd, name, &statbuf, AT_SYMLINK_NOFOLLOW) == -1) {
+    /* Ignore errors */
+    return;
+  }
+
+  g_atomic_int_inc(&job->n_items_seen);
+  is_dir = S_ISDIR(statbuf.st_mode);
+
+  owner_changed =
+      needs_owner_change(job, statbuf.st_uid, statbuf.st_gid) &&
+      fchownat(dir_fd, name, job->owner, job->group, AT_SYMLINK_NOFOLLOW) == 0;
+  changed = owner_changed;
+
+  /* Symlinks have no permissions of their own */
+  if (!S_ISLNK(statbuf.st_mode)) {
+    mode = get_new_mode(job, statbuf.st_mode, is_dir);
+
+    if ((owner_changed || (mode & 07777) != (statbuf.st_mode & 07777)) &&
+        fchmodat(dir_fd, name, mode & 07777, 0) == 0 &&
+        (mode & 07777) != (statbuf.st_mode & 07777)) {
+      g_autofree char *path = NULL;
+      g_autoptr(GFile) file = NULL;
+
+      path = g_build_filename(dir->path, name, NULL);
+      file = g_file_new_for_path(path);
+      add_original_permissions(job, file, statbuf.st_mode);
+      changed = TRUE;
+    }
+  }
+
+  if (changed) {
+    g_atomic_int_inc(&job->n_items_changed);
+  }
+
+  if (is_dir && !job_aborted((CommonJob *)job)) {
+    SetPermissionsDir *child;
+
+    child = g_new0(SetPermissionsDir, 1);
+    child->path = g_build_filename(dir->path, name, NULL);
+    child->dev = statbuf.st_dev;
+    child->ino = statbuf.st_ino;
+
+    g_atomic_int_inc(&job->n_dirs_seen);
+    g_atomic_int_inc(&job->pending_dirs);
+    g_thread_pool_push(job->pool, child, NULL);
+  }
+}
+
+static void set_permissions_native_dir(gpointer data, gpointer user_data) {
+  SetPermissionsDir *dir = data;
+  SetPermissionsJob *job = user_data;
+  struct dirent *entry;
+  DIR *dirp;
+  int fd;
+  int errsv;
+
+  if (job_aborted((CommonJob *)job)) {
+    set_permissions_dir_done(job, dir);
+    return;
+  }
+
+  dirp = NULL;
+  errsv = 0;
+  fd = open_walked_dir(dir->path, dir->dev, dir->ino);
+  if (fd == -1) {
+    errsv = errno;
+  } else if ((dirp = fdopendir(fd)) == NULL) {
+    errsv = errno;
+    close(fd);
+  }
+
+  if (dirp != NULL) {
+    while (!job_aborted((CommonJob *)job) && (entry = readdir(dirp)) != NULL) {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+        continue;
+      }
+
+      set_permissions_native_child(job, dir, dirfd(dirp), entry->d_name);
+    }
+
+    closedir(dirp);
+  } else if (errsv != 0 && errsv != ENOENT) {
+    /* Running out of descriptors is reported as well, rather than leaving
+     * the folder unchanged without a word */
+    report_set_permissions_error(job, dir->path, errsv);
+  }
+
+  set_permissions_dir_done(job, dir);
+}
+
+static void set_permissions_native(SetPermissionsJob *job, const char *path) {
+  SetPermissionsDir *root;
+  struct stat statbuf;
+  gint64 end_time;
+
+  if (lstat(path, &statbuf) == -1) {
+    report_set_permissions_error(job, path, errno);
+    return;
+  }
+
+  job->pool = g_thread_pool_new(set_permissions_native_dir, job,
+                                g_get_num_processors(), FALSE, NULL);
+
+  g_atomic_int_set(&job->pending_dirs, 1);
+  g_atomic_int_set(&job->n_dirs_seen, 1);
+
+  /* The folder itself was chosen by the user, whatever is there now */
+  root = g_new0(SetPermissionsDir, 1);
+  root->path = g_strdup(path);
+  root->dev = statbuf.st_dev;
+  root->ino = statbuf.st_ino;
+  g_thread_pool_push(job->pool, root, NULL);
+
+  g_mutex_lock(&job->mutex);
+  while (g_atomic_int_get(&job->pending_dirs) > 0) {
+    end_time = g_get_monotonic_time() + PROGRESS_NOTIFY_INTERVAL;
+    g_cond_wait_until(&job->done_cond, &job->mutex, end_time);
+
+    g_mutex_unlock(&job->mutex);
+    report_set_permissions_progress(job, FALSE);
+    g_mutex_lock(&job->mutex);
+  }
+  g_mutex_unlock(&job->mutex);
+
+  g_thread_pool_free(job->pool, FALSE, TRUE);
+  job->pool = NULL;
+}
+
 static void set_permissions_file(SetPermissionsJob *job, GFile *file,
                                  GFileInfo *info);
 
@@ -5729,8 +6459,9 @@ static void set_permissions_contained_files(SetPermissionsJob *job,
 
   enumerator = g_file_enumerate_children(
       file,
-      G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE
-                                     "," G_FILE_ATTRIBUTE_UNIX_MODE,
+      G_FILE_ATTRIBUTE_STANDARD_NAME
+      "," G_FILE_ATTRIBUTE_STANDARD_TYPE "," G_FILE_ATTRIBUTE_UNIX_MODE
+      "," G_FILE_ATTRIBUTE_UNIX_UID "," G_FILE_ATTRIBUTE_UNIX_GID,
       G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, common->cancellable, NULL);
   if (enumerator) {
     GFileInfo *child_info;
@@ -5748,65 +6479,74 @@ static void set_permissions_contained_files(SetPermissionsJob *job,
     g_file_enumerator_close(enumerator, common->cancellable, NULL);
     g_object_unref(enumerator);
   }
+
+  job->n_dirs_done++;
 }
 
 static void set_permissions_file(SetPermissionsJob *job, GFile *file,
                                  GFileInfo *info) {
   CommonJob *common;
-  gboolean free_info;
+  gboolean is_dir;
+  gboolean owner_changed;
+  gboolean changed;
   guint32 current;
   guint32 value;
-  guint32 mask;
 
   common = (CommonJob *)job;
 
-  nautilus_progress_info_pulse_progress(common->progress);
+  job->n_items_seen++;
+  report_set_permissions_progress(job, FALSE);
 
-  free_info = FALSE;
-  if (info == NULL) {
-    free_info = TRUE;
-    info = g_file_query_info(
-        file, G_FILE_ATTRIBUTE_STANDARD_TYPE "," G_FILE_ATTRIBUTE_UNIX_MODE,
-        G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, common->cancellable, NULL);
-    /* Ignore errors */
-    if (info == NULL) {
-      return;
+  is_dir = g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY;
+  owner_changed = FALSE;
+
+  if (!job_aborted(common) &&
+      g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_UNIX_UID) &&
+      needs_owner_change(
+          job,
+          g_file_info_get_attribute_uint32(info, G_FILE_ATTRIBUTE_UNIX_UID),
+          g_file_info_get_attribute_uint32(info, G_FILE_ATTRIBUTE_UNIX_GID))) {
+    if (job->owner != (uid_t)-1 &&
+        g_file_set_attribute_uint32(file, G_FILE_ATTRIBUTE_UNIX_UID, job->owner,
+                                    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                    common->cancellable, NULL)) {
+      owner_changed = TRUE;
+    }
+    if (job->group != (gid_t)-1 &&
+        g_file_set_attribute_uint32(file, G_FILE_ATTRIBUTE_UNIX_GID, job->group,
+                                    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                    common->cancellable, NULL)) {
+      owner_changed = TRUE;
     }
   }
 
-  if (g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY) {
-    value = job->dir_permissions;
-    mask = job->dir_mask;
-  } else {
-    value = job->file_permissions;
-    mask = job->file_mask;
-  }
+  changed = owner_changed;
 
   if (!job_aborted(common) &&
       g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_UNIX_MODE)) {
     current =
         g_file_info_get_attribute_uint32(info, G_FILE_ATTRIBUTE_UNIX_MODE);
+    value = get_new_mode(job, current, is_dir);
 
-    if (common->undo_info != NULL) {
-      nautilus_file_undo_info_rec_permissions_add_file(
-          NAUTILUS_FILE_UNDO_INFO_REC_PERMISSIONS(common->undo_info), file,
-          current);
+    /* Changing the owner may have cleared the setuid and setgid bits */
+    if ((owner_changed || value != current) &&
+        g_file_set_attribute_uint32(file, G_FILE_ATTRIBUTE_UNIX_MODE, value,
+                                    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                    common->cancellable, NULL) &&
+        value != current) {
+      add_original_permissions(job, file, current);
+      changed = TRUE;
     }
+  }
 
-    current = (current & ~mask) | value;
-
-    g_file_set_attribute_uint32(file, G_FILE_ATTRIBUTE_UNIX_MODE, current,
-                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                common->cancellable, NULL);
+  if (changed) {
+    job->n_items_changed++;
   }
 
-  if (!job_aborted(common) &&
-      g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY) {
+  if (!job_aborted(common) && is_dir) {
+    job->n_dirs_seen++;
     set_permissions_contained_files(job, file);
   }
-  if (free_info) {
-    g_object_unref(info);
-  }
 }
 
 static void set_permissions_thread_func(GTask *task, gpointer source_object,
@@ -5814,20 +6554,46 @@ static void set_permissions_thread_func(GTask *task, gpointer source_object,
                                         GCancellable *cancellable) {
   SetPermissionsJob *job = task_data;
   CommonJob *common;
+  g_autofree char *path = NULL;
 
   common = (CommonJob *)job;
 
   nautilus_progress_info_set_status(common->progress, _("Setting permissions"));
 
   nautilus_progress_info_start(job->common.progress);
-  set_permissions_contained_files(job, job->file);
+
+  /* Local folders are walked in parallel, working relative to each folder's
+   * descriptor. Anything else goes through GIO, one item at a time. */
+  if (g_file_is_native(job->file)) {
+    path = g_file_get_path(job->file);
+  }
+
+  if (path != NULL) {
+    set_permissions_native(job, path);
+  } else {
+    job->n_dirs_seen = 1;
+    set_permissions_contained_files(job, job->file);
+  }
+
+  report_set_permissions_progress(job, TRUE);
+}
+
+static void set_permissions_start(SetPermissionsJob *job) {
+  g_autoptr(GTask) task = NULL;
+
+  g_mutex_init(&job->mutex);
+  g_mutex_init(&job->error_mutex);
+  g_cond_init(&job->done_cond);
+
+  task = g_task_new(NULL, NULL, set_permissions_task_done, job);
+  g_task_set_task_data(task, job, NULL);
+  g_task_run_in_thread(task, set_permissions_thread_func);
 }
 
 void nautilus_file_set_permissions_recursive(
     const char *directory, guint32 file_permissions, guint32 file_mask,
-    guint32 dir_permissions, guint32 dir_mask, NautilusOpCallback callback,
-    gpointer callback_data) {
-  g_autoptr(GTask) task = NULL;
+    guint32 dir_permissions, guint32 dir_mask, int uid, int gid,
+    NautilusOpCallback callback, gpointer callback_data) {
   SetPermissionsJob *job;
 
   job = op_job_new(SetPermissionsJob, NULL, NULL);
@@ -5836,6 +6602,8 @@ void nautilus_file_set_permissions_recursive(
   job->file_mask = file_mask;
   job->dir_permissions = dir_permissions;
   job->dir_mask = dir_mask;
+  job->owner = uid >= 0 ? (uid_t)uid : (uid_t)-1;
+  job->group = gid >= 0 ? (gid_t)gid : (gid_t)-1;
   job->done_callback = callback;
   job->done_callback_data = callback_data;
 
@@ -5844,9 +6612,7 @@ void nautilus_file_set_permissions_recursive(
         job->file, file_permissions, file_mask, dir_permissions, dir_mask);
   }
 
-  task = g_task_new(NULL, NULL, set_permissions_task_done, job);
-  g_task_set_task_data(task, job, NULL);
-  g_task_run_in_thread(task, set_permissions_thread_func);
+  set_permissions_start(job);
 }
 
 static GList *location_list_from_uri_list(const GList *uris) {
@@ -6515,6 +7281,9 @@ static void extract_task_done(GObject *source_object, GAsyncResult *res,
   g_list_free_full(extract_job->source_files, g_object_unref);
   g_list_free_full(extract_job->output_files, g_object_unref);
   g_object_unref(extract_job->destination_directory);
+  g_hash_table_destroy(extract_job->reserved_output_files);
+  g_mutex_clear(&extract_job->mutex);
+  g_mutex_clear(&extract_job->prompt_mutex);
 
   finalize_common((CommonJob *)extract_job);
 
@@ -6525,30 +7294,41 @@ static GFile *extract_job_on_decide_destination(AutoarExtractor *extractor,
                                                 GFile *destination,
                                                 GList *files,
                                                 gpointer user_data) {
-  ExtractJob *extract_job = user_data;
+  ExtractArchive *archive = user_data;
+  ExtractJob *extract_job = archive->extract_job;
   GFile *decided_destination;
   g_autofree char *basename = NULL;
 
-  nautilus_progress_info_set_details(extract_job->common.progress,
-                                     _("Verifying destination"));
+  if (extract_job->n_workers == 1) {
+    nautilus_progress_info_set_details(extract_job->common.progress,
+                                       _("Verifying destination"));
+  }
 
   basename = g_file_get_basename(destination);
+
+  /* The names handed out to the other archives are avoided too, as their
+   * output may not exist yet */
+  g_mutex_lock(&extract_job->mutex);
   decided_destination = nautilus_generate_unique_file_in_directory(
-      extract_job->destination_directory, basename);
+      extract_job->destination_directory, basename,
+      extract_job->reserved_output_files);
+  g_hash_table_add(extract_job->reserved_output_files,
+                   g_object_ref(decided_destination));
+  g_mutex_unlock(&extract_job->mutex);
 
   if (job_aborted((CommonJob *)extract_job)) {
     g_object_unref(decided_destination);
     return NULL;
   }
 
-  /* The extract_job->destination_decided variable signalizes whether the
-   * extract_job->output_files list already contains the final location as
-   * its first link. There is no way to get this over the AutoarExtractor
-   * API currently.
+  /* There is no way to get the final location over the AutoarExtractor
+   * API currently, so it is kept in archive->output_file.
    */
+  g_mutex_lock(&extract_job->mutex);
   extract_job->output_files =
       g_list_prepend(extract_job->output_files, decided_destination);
-  extract_job->destination_decided = TRUE;
+  g_mutex_unlock(&extract_job->mutex);
+  archive->output_file = decided_destination;
 
   return g_object_ref(decided_destination);
 }
@@ -6557,60 +7337,73 @@ static void extract_job_on_progress(AutoarExtractor *extractor,
                                     guint64 archive_current_decompressed_size,
                                     guint archive_current_decompressed_files,
                                     gpointer user_data) {
-  ExtractJob *extract_job = user_data;
-  CommonJob *common = user_data;
-  GFile *source_file;
+  ExtractArchive *archive = user_data;
+  ExtractJob *extract_job = archive->extract_job;
+  CommonJob *common = (CommonJob *)extract_job;
   char *details;
   double elapsed;
   double transfer_rate;
   int remaining_time;
   guint64 archive_total_decompressed_size;
-  gdouble archive_weight;
   gdouble archive_decompress_progress;
   guint64 job_completed_size;
+  guint64 total_compressed_size;
+  gint total_files;
   gdouble job_progress;
-  g_autofree gchar *basename = NULL;
   g_autofree gchar *formatted_size_job_completed_size = NULL;
   g_autofree gchar *formatted_size_total_compressed_size = NULL;
 
-  source_file = autoar_extractor_get_source_file(extractor);
-
-  basename = get_basename(source_file);
-  nautilus_progress_info_take_status(
-      common->progress, g_strdup_printf(_("Extracting “%s”"), basename));
-
   archive_total_decompressed_size = autoar_extractor_get_total_size(extractor);
 
   archive_decompress_progress = (gdouble)archive_current_decompressed_size /
                                 (gdouble)archive_total_decompressed_size;
 
-  archive_weight = 0;
+  g_mutex_lock(&extract_job->mutex);
+  extract_job->extracted_size +=
+      (archive_decompress_progress - archive->progress) *
+      archive->compressed_size;
+  archive->progress = archive_decompress_progress;
+
+  job_progress = 0;
   if (extract_job->total_compressed_size) {
-    archive_weight = (gdouble)extract_job->archive_compressed_size /
-                     (gdouble)extract_job->total_compressed_size;
+    job_progress =
+        extract_job->extracted_size / extract_job->total_compressed_size;
   }
+  total_compressed_size = extract_job->total_compressed_size;
+  total_files = extract_job->total_files;
+  g_mutex_unlock(&extract_job->mutex);
 
-  job_progress =
-      archive_decompress_progress * archive_weight + extract_job->base_progress;
+  if (extract_job->n_workers == 1) {
+    g_autofree gchar *basename = NULL;
+
+    basename = get_basename(archive->source_file);
+    nautilus_progress_info_take_status(
+        common->progress, g_strdup_printf(_("Extracting “%s”"), basename));
+  } else {
+    nautilus_progress_info_take_status(
+        common->progress,
+        g_strdup_printf(ngettext("Extracting %'d file", "Extracting %'d files",
+                                 total_files),
+                        total_files));
+  }
 
   elapsed = g_timer_elapsed(common->time, NULL);
 
   transfer_rate = 0;
   remaining_time = -1;
 
-  job_completed_size = job_progress * extract_job->total_compressed_size;
+  job_completed_size = job_progress * total_compressed_size;
 
   if (elapsed > 0) {
     transfer_rate = job_completed_size / elapsed;
   }
   if (transfer_rate > 0) {
-    remaining_time = (extract_job->total_compressed_size - job_completed_size) /
-                     transfer_rate;
+    remaining_time =
+        (total_compressed_size - job_completed_size) / transfer_rate;
   }
 
   formatted_size_job_completed_size = g_format_size(job_completed_size);
-  formatted_size_total_compressed_size =
-      g_format_size(extract_job->total_compressed_size);
+  formatted_size_total_compressed_size = g_format_size(total_compressed_size);
   if (elapsed < SECONDS_NEEDED_FOR_RELIABLE_TRANSFER_RATE ||
       transfer_rate == 0) {
     /* To translators: %s will expand to a size like "2 bytes" or
@@ -6652,108 +7445,118 @@ static void extract_job_on_progress(AutoarExtractor *extractor,
 
 static void extract_job_on_error(AutoarExtractor *extractor, GError *error,
                                  gpointer user_data) {
-  ExtractJob *extract_job = user_data;
-  GFile *source_file;
-  GFile *destination;
+  ExtractArchive *archive = user_data;
+  ExtractJob *extract_job = archive->extract_job;
   gint response_id;
   gint remaining_files;
+  gint total_files;
   g_autofree gchar *basename = NULL;
 
-  source_file = autoar_extractor_get_source_file(extractor);
-
   if (IS_IO_ERROR(error, NOT_SUPPORTED)) {
+    g_mutex_lock(&extract_job->prompt_mutex);
     handle_unsupported_compressed_file(extract_job->common.parent_window,
-                                       source_file);
+                                       archive->source_file);
+    g_mutex_unlock(&extract_job->prompt_mutex);
 
     return;
   }
 
-  extract_job->extraction_failed = TRUE;
+  archive->failed = TRUE;
 
-  /* It is safe to use extract_job->output_files->data only when the
-   * extract_job->destination_decided variable was set, see comment in the
-   * extract_job_on_decide_destination function.
-   */
-  if (extract_job->destination_decided) {
-    destination = extract_job->output_files->data;
-    delete_file_recursively(destination, NULL, NULL, NULL);
-    extract_job->output_files = g_list_delete_link(extract_job->output_files,
-                                                   extract_job->output_files);
-    g_object_unref(destination);
+  if (archive->output_file != NULL) {
+    delete_file_recursively(archive->output_file, NULL, NULL, NULL);
+
+    g_mutex_lock(&extract_job->mutex);
+    extract_job->output_files =
+        g_list_remove(extract_job->output_files, archive->output_file);
+    g_mutex_unlock(&extract_job->mutex);
+    g_clear_object(&archive->output_file);
   }
 
-  if (extract_job->common.skip_all_error) {
+  g_mutex_lock(&extract_job->prompt_mutex);
+
+  /* Another archive may have been skipped or cancelled in the meantime */
+  if (extract_job->common.skip_all_error ||
+      job_aborted((CommonJob *)extract_job)) {
+    g_mutex_unlock(&extract_job->prompt_mutex);
     return;
   }
 
-  basename = get_basename(source_file);
+  basename = get_basename(archive->source_file);
   nautilus_progress_info_take_status(
       extract_job->common.progress,
       g_strdup_printf(_("Error extracting “%s”"), basename));
 
-  remaining_files =
-      g_list_length(g_list_find_custom(extract_job->source_files, source_file,
-                                       (GCompareFunc)g_file_equal)) -
-      1;
+  g_mutex_lock(&extract_job->mutex);
+  remaining_files = extract_job->archives_left - 1;
+  total_files = extract_job->total_files;
+  g_mutex_unlock(&extract_job->mutex);
+
   response_id = run_cancel_or_skip_warning(
       (CommonJob *)extract_job,
       g_strdup_printf(_("There was an error while extracting “%s”."), basename),
-      g_strdup(error->message), NULL, extract_job->total_files,
-      remaining_files);
+      g_strdup(error->message), NULL, total_files, remaining_files);
 
   if (response_id == 0 || response_id == GTK_RESPONSE_DELETE_EVENT) {
     abort_job((CommonJob *)extract_job);
   } else if (response_id == 1) {
     extract_job->common.skip_all_error = TRUE;
   }
+
+  g_mutex_unlock(&extract_job->prompt_mutex);
 }
 
 static void extract_job_on_completed(AutoarExtractor *extractor,
                                      gpointer user_data) {
-  ExtractJob *extract_job = user_data;
-  GFile *output_file;
-
-  output_file = G_FILE(extract_job->output_files->data);
+  ExtractArchive *archive = user_data;
 
-  nautilus_file_changes_queue_file_added(output_file);
+  if (archive->output_file != NULL) {
+    nautilus_file_changes_queue_file_added(archive->output_file);
+  }
 }
 
 static gchar *extract_job_on_request_passphrase(AutoarExtractor *extractor,
                                                 gpointer user_data) {
-  ExtractJob *extract_job = user_data;
+  ExtractArchive *archive = user_data;
+  ExtractJob *extract_job = archive->extract_job;
   GtkWindow *parent_window;
-  GFile *source_file;
   g_autofree gchar *basename = NULL;
   gchar *passphrase;
 
+  g_mutex_lock(&extract_job->prompt_mutex);
+
+  if (job_aborted((CommonJob *)extract_job)) {
+    g_mutex_unlock(&extract_job->prompt_mutex);
+    return NULL;
+  }
+
   parent_window = extract_job->common.parent_window;
-  source_file = autoar_extractor_get_source_file(extractor);
-  basename = get_basename(source_file);
+  basename = get_basename(archive->source_file);
 
   passphrase = extract_ask_passphrase(parent_window, basename);
   if (passphrase == NULL) {
     abort_job((CommonJob *)extract_job);
   }
 
+  g_mutex_unlock(&extract_job->prompt_mutex);
+
   return passphrase;
 }
 
 static void extract_job_on_scanned(AutoarExtractor *extractor,
                                    guint total_files, gpointer user_data) {
+  ExtractArchive *archive = user_data;
+  ExtractJob *extract_job = archive->extract_job;
   guint64 total_size;
-  ExtractJob *extract_job;
-  GFile *source_file;
   g_autofree gchar *basename = NULL;
   GFileInfo *fsinfo;
   guint64 free_size;
 
-  extract_job = user_data;
   total_size = autoar_extractor_get_total_size(extractor);
-  source_file = autoar_extractor_get_source_file(extractor);
-  basename = get_basename(source_file);
+  basename = get_basename(archive->source_file);
 
   fsinfo = g_file_query_filesystem_info(
-      source_file,
+      archive->source_file,
       G_FILE_ATTRIBUTE_FILESYSTEM_FREE "," G_FILE_ATTRIBUTE_FILESYSTEM_READONLY,
       extract_job->common.cancellable, NULL);
   free_size = g_file_info_get_attribute_uint64(
@@ -6763,15 +7566,21 @@ static void extract_job_on_scanned(AutoarExtractor *extractor,
    * be determined. Ideally an API should be used instead.
    */
   if (total_size != G_MAXUINT64 && total_size > free_size) {
-    nautilus_progress_info_take_status(
-        extract_job->common.progress,
-        g_strdup_printf(_("Error extracting “%s”"), basename));
-    run_error(
-        &extract_job->common,
-        g_strdup_printf(_("Not enough free space to extract %s"), basename),
-        NULL, NULL, FALSE, CANCEL, NULL);
+    g_mutex_lock(&extract_job->prompt_mutex);
 
-    abort_job((CommonJob *)extract_job);
+    if (!job_aborted((CommonJob *)extract_job)) {
+      nautilus_progress_info_take_status(
+          extract_job->common.progress,
+          g_strdup_printf(_("Error extracting “%s”"), basename));
+      run_error(
+          &extract_job->common,
+          g_strdup_printf(_("Not enough free space to extract %s"), basename),
+          NULL, NULL, FALSE, CANCEL, NULL);
+
+      abort_job((CommonJob *)extract_job);
+    }
+
+    g_mutex_unlock(&extract_job->prompt_mutex);
   }
 }
 
@@ -6812,12 +7621,67 @@ static void report_extract_final_progress(ExtractJob *extract_job) {
   nautilus_progress_info_set_progress(extract_job->common.progress, 1, 1);
 }
 
+static void extract_archive(gpointer data, gpointer user_data) {
+  ExtractArchive *archive = data;
+  ExtractJob *extract_job = archive->extract_job;
+  g_autoptr(AutoarExtractor) extractor = NULL;
+
+  if (!job_aborted((CommonJob *)extract_job)) {
+    extractor = autoar_extractor_new(archive->source_file,
+                                     extract_job->destination_directory);
+
+    autoar_extractor_set_notify_interval(extractor, PROGRESS_NOTIFY_INTERVAL);
+    g_signal_connect(extractor, "scanned", G_CALLBACK(extract_job_on_scanned),
+                     archive);
+    g_signal_connect(extractor, "error", G_CALLBACK(extract_job_on_error),
+                     archive);
+    g_signal_connect(extractor, "decide-destination",
+                     G_CALLBACK(extract_job_on_decide_destination), archive);
+    g_signal_connect(extractor, "progress", G_CALLBACK(extract_job_on_progress),
+                     archive);
+    g_signal_connect(extractor, "completed",
+                     G_CALLBACK(extract_job_on_completed), archive);
+    g_signal_connect(extractor, "request-passphrase",
+                     G_CALLBACK(extract_job_on_request_passphrase), archive);
+
+    autoar_extractor_start(extractor, extract_job->common.cancellable);
+
+    g_signal_handlers_disconnect_by_data(extractor, archive);
+  }
+
+  g_mutex_lock(&extract_job->mutex);
+  if (!archive->failed) {
+    extract_job->extracted_size +=
+        (1 - archive->progress) * archive->compressed_size;
+  } else {
+    extract_job->total_files--;
+    extract_job->extracted_size -= archive->progress * archive->compressed_size;
+    extract_job->total_compressed_size -= archive->compressed_size;
+  }
+  extract_job->archives_left--;
+  g_mutex_unlock(&extract_job->mutex);
+}
+
+static guint get_extract_workers(ExtractJob *extract_job) {
+  guint n_workers;
+
+  n_workers = MIN((guint)g_get_num_processors(),
+                  nautilus_job_scheduler_get_device_concurrency(
+                      extract_job->destination_directory));
+  n_workers = MIN(n_workers, (guint)extract_job->total_files);
+
+  return MAX(n_workers, 1);
+}
+
 static void extract_task_thread_func(GTask *task, gpointer source_object,
                                      gpointer task_data,
                                      GCancellable *cancellable) {
   ExtractJob *extract_job = task_data;
   GList *l;
-  g_autofree guint64 *archive_compressed_sizes = NULL;
+  g_autofree ExtractArchive *archives = NULL;
+  g_autoptr(GError) error = NULL;
+  GThreadPool *pool = NULL;
+  gint n_archives;
   gint i;
 
   g_timer_start(extract_job->common.time);
@@ -6827,10 +7691,10 @@ static void extract_task_thread_func(GTask *task, gpointer source_object,
   nautilus_progress_info_set_details(extract_job->common.progress,
                                      _("Preparing to extract"));
 
-  extract_job->total_files = g_list_length(extract_job->source_files);
+  n_archives = g_list_length(extract_job->source_files);
+  extract_job->total_files = n_archives;
 
-  archive_compressed_sizes =
-      g_malloc0_n(extract_job->total_files, sizeof(guint64));
+  archives = g_new0(ExtractArchive, n_archives);
   extract_job->total_compressed_size = 0;
 
   for (l = extract_job->source_files, i = 0;
@@ -6839,62 +7703,46 @@ static void extract_task_thread_func(GTask *task, gpointer source_object,
     g_autoptr(GFileInfo) info = NULL;
 
     source_file = G_FILE(l->data);
+    archives[i].extract_job = extract_job;
+    archives[i].source_file = source_file;
+
     info = g_file_query_info(source_file, G_FILE_ATTRIBUTE_STANDARD_SIZE,
                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
                              extract_job->common.cancellable, NULL);
 
     if (info) {
-      archive_compressed_sizes[i] = g_file_info_get_size(info);
-      extract_job->total_compressed_size += archive_compressed_sizes[i];
+      archives[i].compressed_size = g_file_info_get_size(info);
+      extract_job->total_compressed_size += archives[i].compressed_size;
     }
   }
 
-  extract_job->base_progress = 0;
-
-  for (l = extract_job->source_files, i = 0;
-       l != NULL && !job_aborted((CommonJob *)extract_job); l = l->next, i++) {
-    g_autoptr(AutoarExtractor) extractor = NULL;
-
-    extractor = autoar_extractor_new(G_FILE(l->data),
-                                     extract_job->destination_directory);
-
-    autoar_extractor_set_notify_interval(extractor, PROGRESS_NOTIFY_INTERVAL);
-    g_signal_connect(extractor, "scanned", G_CALLBACK(extract_job_on_scanned),
-                     extract_job);
-    g_signal_connect(extractor, "error", G_CALLBACK(extract_job_on_error),
-                     extract_job);
-    g_signal_connect(extractor, "decide-destination",
-                     G_CALLBACK(extract_job_on_decide_destination),
-                     extract_job);
-    g_signal_connect(extractor, "progress", G_CALLBACK(extract_job_on_progress),
-                     extract_job);
-    g_signal_connect(extractor, "completed",
-                     G_CALLBACK(extract_job_on_completed), extract_job);
-    g_signal_connect(extractor, "request-passphrase",
-                     G_CALLBACK(extract_job_on_request_passphrase),
-                     extract_job);
-
-    extract_job->archive_compressed_size = archive_compressed_sizes[i];
-    extract_job->destination_decided = FALSE;
-    extract_job->extraction_failed = FALSE;
-
-    autoar_extractor_start(extractor, extract_job->common.cancellable);
+  extract_job->extracted_size = 0;
+  extract_job->archives_left = extract_job->total_files;
+  extract_job->n_workers = get_extract_workers(extract_job);
 
-    g_signal_handlers_disconnect_by_data(extractor, extract_job);
+  if (extract_job->n_workers > 1) {
+    pool = g_thread_pool_new(extract_archive, NULL, extract_job->n_workers,
+                             FALSE, &error);
+    if (pool == NULL) {
+      g_warning("Could not extract in parallel: %s", error->message);
+      extract_job->n_workers = 1;
+    }
+  }
 
-    if (!extract_job->extraction_failed) {
-      extract_job->base_progress +=
-          (gdouble)extract_job->archive_compressed_size /
-          (gdouble)extract_job->total_compressed_size;
+  for (i = 0; i < n_archives && !job_aborted((CommonJob *)extract_job); i++) {
+    if (pool != NULL) {
+      g_thread_pool_push(pool, &archives[i], NULL);
     } else {
-      extract_job->total_files--;
-      extract_job->base_progress *= extract_job->total_compressed_size;
-      extract_job->total_compressed_size -=
-          extract_job->archive_compressed_size;
-      extract_job->base_progress /= extract_job->total_compressed_size;
+      extract_archive(&archives[i], NULL);
     }
   }
 
+  if (pool != NULL) {
+    /* Waits for the archives being extracted and those left in the queue,
+     * which return right away if the job was aborted */
+    g_thread_pool_free(pool, FALSE, TRUE);
+  }
+
   if (!job_aborted((CommonJob *)extract_job)) {
     report_extract_final_progress(extract_job);
   }
@@ -6926,6 +7774,10 @@ void nautilus_file_operations_extract_files(
   extract_job->source_files =
       g_list_copy_deep(files, (GCopyFunc)g_object_ref, NULL);
   extract_job->destination_directory = g_object_ref(destination_directory);
+  extract_job->reserved_output_files = g_hash_table_new_full(
+      g_file_hash, (GEqualFunc)g_file_equal, g_object_unref, NULL);
+  g_mutex_init(&extract_job->mutex);
+  g_mutex_init(&extract_job->prompt_mutex);
   extract_job->done_callback = done_callback;
   extract_job->done_callback_data = done_callback_data;
 
@@ -6939,7 +7791,9 @@ void nautilus_file_operations_extract_files(
   task = g_task_new(NULL, extract_job->common.cancellable, extract_task_done,
                     extract_job);
   g_task_set_task_data(task, extract_job, NULL);
-  g_task_run_in_thread(task, extract_task_thread_func);
+  nautilus_job_scheduler_run_in_thread(
+      task, extract_task_thread_func, extract_job->common.progress,
+      extract_job->source_files->data, extract_job->destination_directory);
 }
 
 static void compress_task_done(GObject *source_object, GAsyncResult *res,
@@ -7156,6 +8010,39 @@ static void compress_job_on_completed(AutoarCompressor *compressor,
                                          destination_directory);
 }
 
+#ifdef HAVE_LIBARCHIVE
+static void compress_job_on_parallel_progress(guint64 completed_size,
+                                              guint completed_files,
+                                              gpointer user_data) {
+  compress_job_on_progress(NULL, completed_size, completed_files, user_data);
+}
+
+/* The threaded encoder keeps a block per thread in memory, so do not let it
+ * take more than a few of them. */
+#define MAX_COMPRESS_THREADS 8
+
+static gboolean compress_in_parallel(CompressJob *compress_job) {
+  g_autoptr(GError) error = NULL;
+  guint n_threads;
+
+  n_threads = MIN(g_get_num_processors(), MAX_COMPRESS_THREADS);
+  if (nautilus_parallel_compressor_run(
+          compress_job->source_files, compress_job->output_file,
+          compress_job->format, compress_job->filter, n_threads,
+          compress_job_on_parallel_progress, compress_job,
+          compress_job->common.cancellable, &error)) {
+    compress_job_on_completed(NULL, compress_job);
+    return TRUE;
+  }
+
+  if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+    compress_job_on_error(NULL, error, compress_job);
+  }
+
+  return FALSE;
+}
+#endif
+
 static void compress_task_thread_func(GTask *task, gpointer source_object,
                                       gpointer task_data,
                                       GCancellable *cancellable) {
@@ -7173,6 +8060,22 @@ static void compress_task_thread_func(GTask *task, gpointer source_object,
   compress_job->total_files = source_info.num_files;
   compress_job->total_size = source_info.num_bytes;
 
+#ifdef HAVE_LIBARCHIVE
+  if (compress_job->parallel &&
+      nautilus_parallel_compressor_is_supported(
+          compress_job->source_files, compress_job->output_file,
+          compress_job->format, compress_job->filter)) {
+    compress_job->success = compress_in_parallel(compress_job);
+
+    /* There is nothing to undo if the output was not created */
+    if (compress_job->common.undo_info != NULL && !compress_job->success) {
+      g_clear_object(&compress_job->common.undo_info);
+    }
+
+    return;
+  }
+#endif
+
   compressor = autoar_compressor_new(
       compress_job->source_files, compress_job->output_file,
       compress_job->format, compress_job->filter, FALSE);
@@ -7213,6 +8116,9 @@ void nautilus_file_operations_compress(
   compress_job->format = format;
   compress_job->filter = filter;
   compress_job->passphrase = g_strdup(passphrase);
+  compress_job->parallel =
+      g_settings_get_boolean(nautilus_compression_preferences,
+                             NAUTILUS_PREFERENCES_PARALLEL_COMPRESSION);
   compress_job->done_callback = done_callback;
   compress_job->done_callback_data = done_callback_data;
 
@@ -7226,7 +8132,9 @@ void nautilus_file_operations_compress(
   task = g_task_new(NULL, compress_job->common.cancellable, compress_task_done,
                     compress_job);
   g_task_set_task_data(task, compress_job, NULL);
-  g_task_run_in_thread(task, compress_task_thread_func);
+  nautilus_job_scheduler_run_in_thread(
+      task, compress_task_thread_func, compress_job->common.progress,
+      compress_job->source_files->data, compress_job->output_file);
 }
 
 #if !defined(NAUTILUS_OMIT_SELF_CHECK)
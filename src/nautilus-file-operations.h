@@ -80,9 +80,10 @@ void nautilus_file_operations_delete_async(
     NautilusFileOperationsDBusData *dbus_data,
     NautilusDeleteCallback done_callback, gpointer done_callback_data);
 
+/* @uid and @gid are -1 to keep the owner and group of the files */
 void nautilus_file_set_permissions_recursive(
     const char *directory, guint32 file_permissions, guint32 file_mask,
-    guint32 folder_permissions, guint32 folder_mask,
+    guint32 folder_permissions, guint32 folder_mask, int uid, int gid,
     NautilusOpCallback callback, gpointer callback_data);
 
 void nautilus_file_operations_unmount_mount(GtkWindow *parent_window,
@@ -103,12 +104,15 @@ void nautilus_file_operations_copy_async(
     NautilusFileOperationsDBusData *dbus_data,
     NautilusCopyCallback done_callback, gpointer done_callback_data);
 void nautilus_file_operations_copy_sync(GList *files, GFile *target_dir);
+/* As the Update choice of the conflict dialog, for all the conflicts */
+void nautilus_file_operations_copy_update_sync(GList *files, GFile *target_dir);
 
 void nautilus_file_operations_move_async(
     GList *files, GFile *target_dir, GtkWindow *parent_window,
     NautilusFileOperationsDBusData *dbus_data,
     NautilusCopyCallback done_callback, gpointer done_callback_data);
 void nautilus_file_operations_move_sync(GList *files, GFile *target_dir);
+void nautilus_file_operations_move_update_sync(GList *files, GFile *target_dir);
 
 void nautilus_file_operations_duplicate(
     GList *files, GtkWindow *parent_window,
@@ -88,12 +88,10 @@ struct NautilusFileDetails
 	GIcon *icon;
 	
 	char *thumbnail_path;
-	GdkPixbuf *thumbnail;
+	/* Handle in the thumbnail cache, 0 if there is no thumbnail loaded */
+	guint thumbnail_handle;
 	time_t thumbnail_mtime;
 
-	GdkPixbuf *scaled_thumbnail;
-	double thumbnail_scale;
-
 	GList *mime_list; /* If this is a directory, the list of MIME types in it. */
 
 	/* Info you might get from a link (.desktop, .directory or nautilus link) */
@@ -269,6 +267,7 @@ gboolean               nautilus_file_is_self_owned                      (Nautilu
 void                   nautilus_file_invalidate_count_and_mime_list     (NautilusFile           *file);
 gboolean               nautilus_file_rename_in_progress                 (NautilusFile           *file);
 void                   nautilus_file_invalidate_extension_info_internal (NautilusFile           *file);
+void                   nautilus_file_apply_extension_info               (NautilusFile           *file);
 void                   nautilus_file_info_providers_done                (NautilusFile           *file);
 
 
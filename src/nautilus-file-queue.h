@@ -40,7 +40,15 @@ NautilusFile *     nautilus_file_queue_dequeue  (NautilusFileQueue *queue);
 void               nautilus_file_queue_remove   (NautilusFileQueue *queue,
 						 NautilusFile      *file);
 
+/* Move a file to the head of the queue, if it's in the queue. */
+void               nautilus_file_queue_move_to_head (NautilusFileQueue *queue,
+						     NautilusFile      *file);
+
 /* Get the file at the head of the queue without removing or unrefing it. */
 NautilusFile *     nautilus_file_queue_head     (NautilusFileQueue *queue);
 
+/* Get the files in the queue, from the head. The list belongs to the queue
+ * and must not be modified. */
+GList *            nautilus_file_queue_peek_head_link (NautilusFileQueue *queue);
+
 gboolean           nautilus_file_queue_is_empty (NautilusFileQueue *queue);
@@ -0,0 +1,400 @@
+/* nautilus-file-undo-journal.c - Compact storage of per-file undo records
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "nautilus-file-undo-journal.h"
+
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define JOURNAL_BLOCK_SIZE (64 * 1024)
+/* Bytes kept in memory before the full blocks are moved to the spill file */
+#define JOURNAL_MEMORY_BUDGET (4 * 1024 * 1024)
+
+#define RECORD_HAS_TARGET (1 << 0)
+
+/* Records are stored as a stream of bytes: the part that was spilled comes
+ * first, followed by the bytes in the memory blocks. Each record is
+ *
+ *   flags, value, origin URI, [target URI]
+ *
+ * where integers are LEB128 encoded, and URIs are encoded as the length of
+ * the prefix shared with the previous URI of the same kind, followed by the
+ * length and bytes of the rest. */
+struct NautilusFileUndoJournal {
+  GPtrArray *blocks;
+  gsize used;
+
+  FILE *spill;
+  gsize spilled;
+  gboolean spill_failed;
+
+  GString *last_origin;
+  GString *last_target;
+  guint length;
+};
+
+typedef struct {
+  NautilusFileUndoJournal *journal;
+  gsize position;
+} JournalReader;
+
+NautilusFileUndoJournal *nautilus_file_undo_journal_new(void) {
+  NautilusFileUndoJournal *journal;
+
+  journal = g_new0(NautilusFileUndoJournal, 1);
+  journal->blocks = g_ptr_array_new_with_free_func(g_free);
+  journal->last_origin = g_string_new(NULL);
+  journal->last_target = g_string_new(NULL);
+
+  return journal;
+}
+
+void nautilus_file_undo_journal_free(NautilusFileUndoJournal *journal) {
+  if (journal == NULL) {
+    return;
+  }
+
+  g_ptr_array_unref(journal->blocks);
+  if (journal->spill != NULL) {
+    fclose(journal->spill);
+  }
+  g_string_free(journal->last_origin, TRUE);
+  g_string_free(journal->last_target, TRUE);
+  g_free(journal);
+}
+
+static void journal_write(NautilusFileUndoJournal *journal, const guint8 *data,
+                          gsize len) {
+  guint block_index;
+  gsize offset;
+  gsize n;
+
+  while (len > 0) {
+    block_index = journal->used / JOURNAL_BLOCK_SIZE;
+    offset = journal->used % JOURNAL_BLOCK_SIZE;
+
+    if (block_index == journal->blocks->len) {
+      g_ptr_array_add(journal->blocks, g_malloc(JOURNAL_BLOCK_SIZE));
+    }
+
+    n = MIN(len, JOURNAL_BLOCK_SIZE - offset);
+    memcpy((guint8 *)g_ptr_array_index(journal->blocks, block_index) + offset,
+           data, n);
+
+    journal->used += n;
+    data += n;
+    len -= n;
+  }
+}
+
+static void journal_write_uint(NautilusFileUndoJournal *journal,
+                               guint32 value) {
+  guint8 buffer[5];
+  gsize len = 0;
+
+  do {
+    buffer[len] = value & 0x7f;
+    value >>= 7;
+    if (value != 0) {
+      buffer[len] |= 0x80;
+    }
+    len++;
+  } while (value != 0);
+
+  journal_write(journal, buffer, len);
+}
+
+static void journal_write_uri(NautilusFileUndoJournal *journal, GString *last,
+                              const gchar *uri) {
+  gsize prefix;
+  gsize len;
+
+  len = strlen(uri);
+  for (prefix = 0; prefix < last->len && prefix < len; prefix++) {
+    if (last->str[prefix] != uri[prefix]) {
+      break;
+    }
+  }
+
+  journal_write_uint(journal, prefix);
+  journal_write_uint(journal, len - prefix);
+  journal_write(journal, (const guint8 *)uri + prefix, len - prefix);
+
+  g_string_truncate(last, prefix);
+  g_string_append(last, uri + prefix);
+}
+
+static gboolean journal_open_spill(NautilusFileUndoJournal *journal) {
+  g_autofree gchar *path = NULL;
+  gint fd;
+
+  fd = g_file_open_tmp("nautilus-undo-XXXXXX", &path, NULL);
+  if (fd == -1) {
+    return FALSE;
+  }
+
+  /* Nobody else needs to see it, and it goes away with the process */
+  g_unlink(path);
+
+  journal->spill = fdopen(fd, "w+b");
+  if (journal->spill == NULL) {
+    close(fd);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Moves the full blocks to the spill file, keeping the last partial block in
+ * memory, so that the memory used stays under the budget. */
+static void journal_maybe_spill(NautilusFileUndoJournal *journal) {
+  guint n_full_blocks;
+  guint i;
+
+  if (journal->used < JOURNAL_MEMORY_BUDGET || journal->spill_failed) {
+    return;
+  }
+
+  if (journal->spill == NULL && !journal_open_spill(journal)) {
+    journal->spill_failed = TRUE;
+    return;
+  }
+
+  n_full_blocks = journal->used / JOURNAL_BLOCK_SIZE;
+
+  if (fseek(journal->spill, 0, SEEK_END) != 0) {
+    journal->spill_failed = TRUE;
+    return;
+  }
+
+  for (i = 0; i < n_full_blocks; i++) {
+    if (fwrite(g_ptr_array_index(journal->blocks, i), 1, JOURNAL_BLOCK_SIZE,
+               journal->spill) != JOURNAL_BLOCK_SIZE) {
+      /* Keep everything in memory from now on */
+      fflush(journal->spill);
+      if (ftruncate(fileno(journal->spill), journal->spilled) != 0) {
+        g_warning("Could not truncate the undo journal spill file");
+      }
+      journal->spill_failed = TRUE;
+      return;
+    }
+  }
+
+  if (fflush(journal->spill) != 0) {
+    journal->spill_failed = TRUE;
+    return;
+  }
+
+  journal->spilled += (gsize)n_full_blocks * JOURNAL_BLOCK_SIZE;
+  journal->used -= (gsize)n_full_blocks * JOURNAL_BLOCK_SIZE;
+
+  /* The partial block becomes the first one, and the others are reused */
+  if (n_full_blocks < journal->blocks->len) {
+    gpointer partial;
+
+    partial = journal->blocks->pdata[n_full_blocks];
+    journal->blocks->pdata[n_full_blocks] = journal->blocks->pdata[0];
+    journal->blocks->pdata[0] = partial;
+  }
+}
+
+void nautilus_file_undo_journal_append(NautilusFileUndoJournal *journal,
+                                       GFile *origin, GFile *target,
+                                       guint32 value) {
+  g_autofree gchar *origin_uri = NULL;
+  g_autofree gchar *target_uri = NULL;
+
+  g_return_if_fail(journal != NULL);
+  g_return_if_fail(G_IS_FILE(origin));
+
+  origin_uri = g_file_get_uri(origin);
+
+  journal_write_uint(journal, target != NULL ? RECORD_HAS_TARGET : 0);
+  journal_write_uint(journal, value);
+  journal_write_uri(journal, journal->last_origin, origin_uri);
+
+  if (target != NULL) {
+    target_uri = g_file_get_uri(target);
+    journal_write_uri(journal, journal->last_target, target_uri);
+  }
+
+  journal->length++;
+
+  journal_maybe_spill(journal);
+}
+
+guint nautilus_file_undo_journal_get_length(NautilusFileUndoJournal *journal) {
+  return journal->length;
+}
+
+static gboolean journal_read(JournalReader *reader, guint8 *data, gsize len) {
+  NautilusFileUndoJournal *journal;
+  gsize memory_position;
+  gsize offset;
+  gsize n;
+
+  journal = reader->journal;
+
+  while (len > 0) {
+    if (reader->position < journal->spilled) {
+      /* The spill file is read sequentially from the start */
+      n = MIN(len, journal->spilled - reader->position);
+      if (fread(data, 1, n, journal->spill) != n) {
+        return FALSE;
+      }
+    } else {
+      memory_position = reader->position - journal->spilled;
+      if (memory_position >= journal->used) {
+        return FALSE;
+      }
+
+      offset = memory_position % JOURNAL_BLOCK_SIZE;
+      n = MIN(len, JOURNAL_BLOCK_SIZE - offset);
+      n = MIN(n, journal->used - memory_position);
+      memcpy(data,
+             (guint8 *)g_ptr_array_index(journal->blocks,
+                                         memory_position / JOURNAL_BLOCK_SIZE) +
+                 offset,
+             n);
+    }
+
+    reader->position += n;
+    data += n;
+    len -= n;
+  }
+
+  return TRUE;
+}
+
+static gboolean journal_read_uint(JournalReader *reader, guint32 *value) {
+  guint8 byte;
+  guint shift;
+
+  *value = 0;
+  for (shift = 0; shift < 35; shift += 7) {
+    if (!journal_read(reader, &byte, 1)) {
+      return FALSE;
+    }
+
+    *value |= (guint32)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+static gboolean journal_read_uri(JournalReader *reader, GString *last) {
+  guint32 prefix;
+  guint32 suffix_len;
+
+  if (!journal_read_uint(reader, &prefix) ||
+      !journal_read_uint(reader, &suffix_len) || prefix > last->len) {
+    return FALSE;
+  }
+
+  g_string_set_size(last, prefix + suffix_len);
+
+  return journal_read(reader, (guint8 *)last->str + prefix, suffix_len);
+}
+
+void nautilus_file_undo_journal_foreach(NautilusFileUndoJournal *journal,
+                                        NautilusFileUndoJournalFunc func,
+                                        gpointer user_data) {
+  JournalReader reader = {journal, 0};
+  g_autoptr(GString) origin_uri = NULL;
+  g_autoptr(GString) target_uri = NULL;
+  guint32 flags;
+  guint32 value;
+  guint i;
+
+  g_return_if_fail(journal != NULL);
+
+  if (journal->spill != NULL && fseek(journal->spill, 0, SEEK_SET) != 0) {
+    g_warning("Could not read the undo journal spill file");
+    return;
+  }
+
+  origin_uri = g_string_new(NULL);
+  target_uri = g_string_new(NULL);
+
+  for (i = 0; i < journal->length; i++) {
+    g_autoptr(GFile) origin = NULL;
+    g_autoptr(GFile) target = NULL;
+
+    if (!journal_read_uint(&reader, &flags) ||
+        !journal_read_uint(&reader, &value) ||
+        !journal_read_uri(&reader, origin_uri) ||
+        ((flags & RECORD_HAS_TARGET) &&
+         !journal_read_uri(&reader, target_uri))) {
+      g_warning("Corrupted undo journal, %u records skipped",
+                journal->length - i);
+      return;
+    }
+
+    origin = g_file_new_for_uri(origin_uri->str);
+    if (flags & RECORD_HAS_TARGET) {
+      target = g_file_new_for_uri(target_uri->str);
+    }
+
+    if (!func(origin, target, value, user_data)) {
+      return;
+    }
+  }
+}
+
+static gboolean prepend_origin(GFile *origin, GFile *target, guint32 value,
+                               gpointer user_data) {
+  GList **list = user_data;
+
+  *list = g_list_prepend(*list, g_object_ref(origin));
+
+  return TRUE;
+}
+
+static gboolean prepend_target(GFile *origin, GFile *target, guint32 value,
+                               gpointer user_data) {
+  GList **list = user_data;
+
+  if (target != NULL) {
+    *list = g_list_prepend(*list, g_object_ref(target));
+  }
+
+  return TRUE;
+}
+
+GList *
+nautilus_file_undo_journal_get_origins(NautilusFileUndoJournal *journal) {
+  GList *origins = NULL;
+
+  nautilus_file_undo_journal_foreach(journal, prepend_origin, &origins);
+
+  return g_list_reverse(origins);
+}
+
+GList *
+nautilus_file_undo_journal_get_targets(NautilusFileUndoJournal *journal) {
+  GList *targets = NULL;
+
+  nautilus_file_undo_journal_foreach(journal, prepend_target, &targets);
+
+  return g_list_reverse(targets);
+}
@@ -0,0 +1,48 @@
+/* nautilus-file-undo-journal.h - Compact storage of per-file undo records
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+/* An append-only list of (origin, target, value) records, where target is
+ * optional. Locations are stored as URIs sharing their prefix with the
+ * previous record, in arena blocks that are spilled to an unlinked temporary
+ * file once the journal grows past its memory budget. This keeps the memory
+ * used by undo information bounded regardless of the size of the operation.
+ */
+typedef struct NautilusFileUndoJournal NautilusFileUndoJournal;
+
+typedef gboolean (*NautilusFileUndoJournalFunc)(GFile *origin, GFile *target,
+                                                guint32 value,
+                                                gpointer user_data);
+
+NautilusFileUndoJournal *nautilus_file_undo_journal_new(void);
+void nautilus_file_undo_journal_free(NautilusFileUndoJournal *journal);
+
+void nautilus_file_undo_journal_append(NautilusFileUndoJournal *journal,
+                                       GFile *origin, GFile *target,
+                                       guint32 value);
+guint nautilus_file_undo_journal_get_length(NautilusFileUndoJournal *journal);
+
+/* Calls @func for each record in order, until it returns FALSE. */
+void nautilus_file_undo_journal_foreach(NautilusFileUndoJournal *journal,
+                                        NautilusFileUndoJournalFunc func,
+                                        gpointer user_data);
+
+/* These return new lists of new references, in the order of the records. */
+GList *nautilus_file_undo_journal_get_origins(NautilusFileUndoJournal *journal);
+GList *nautilus_file_undo_journal_get_targets(NautilusFileUndoJournal *journal);
@@ -30,18 +30,12 @@
 #include "nautilus-batch-rename-dialog.h"
 #include "nautilus-batch-rename-utilities.h"
 #include "nautilus-file-operations.h"
+#include "nautilus-file-undo-journal.h"
 #include "nautilus-file-undo-manager.h"
+#include "nautilus-file-utilities.h"
 #include "nautilus-file.h"
 #include "nautilus-tag-manager.h"
 
-/* Since we use g_get_current_time for setting "orig_trash_time" in the undo
- * info, there are situations where the difference between this value and the
- * real deletion time can differ enough to make the rounding a difference of 1
- * second, failing the equality check. To make sure we avoid this, and to be
- * preventive, use 2 seconds epsilon.
- */
-#define TRASH_TIME_EPSILON 2
-
 typedef struct {
   NautilusFileUndoOp op_type;
   guint count; /* Number of items */
@@ -329,22 +323,28 @@ struct _NautilusFileUndoInfoExt {
 
   GFile *src_dir;
   GFile *dest_dir;
-  GQueue *sources;      /* Relative to src_dir */
-  GQueue *destinations; /* Relative to dest_dir */
+  /* Sources, relative to src_dir, as origins and destinations, relative
+   * to dest_dir, as targets */
+  NautilusFileUndoJournal *files;
 };
 
 G_DEFINE_TYPE(NautilusFileUndoInfoExt, nautilus_file_undo_info_ext,
               NAUTILUS_TYPE_FILE_UNDO_INFO)
 
+static gboolean get_first_target_short_name(GFile *origin, GFile *target,
+                                            guint32 value, gpointer user_data) {
+  char **file_name = user_data;
+
+  *file_name = g_file_get_basename(target);
+
+  return FALSE;
+}
+
 static char *ext_get_first_target_short_name(NautilusFileUndoInfoExt *self) {
-  GList *targets_first;
   char *file_name = NULL;
 
-  targets_first = g_queue_peek_head_link(self->destinations);
-
-  if (targets_first != NULL && targets_first->data != NULL) {
-    file_name = g_file_get_basename(targets_first->data);
-  }
+  nautilus_file_undo_journal_foreach(self->files, get_first_target_short_name,
+                                     &file_name);
 
   return file_name;
 }
@@ -480,34 +480,49 @@ static void
 ext_create_link_redo_func(NautilusFileUndoInfoExt *self,
                           GtkWindow *parent_window,
                           NautilusFileOperationsDBusData *dbus_data) {
-  nautilus_file_operations_link(g_queue_peek_head_link(self->sources),
-                                self->dest_dir, parent_window, dbus_data,
-                                file_undo_info_transfer_callback, self);
+  GList *sources;
+
+  sources = nautilus_file_undo_journal_get_origins(self->files);
+  nautilus_file_operations_link(sources, self->dest_dir, parent_window,
+                                dbus_data, file_undo_info_transfer_callback,
+                                self);
+  g_list_free_full(sources, g_object_unref);
 }
 
 static void ext_duplicate_redo_func(NautilusFileUndoInfoExt *self,
                                     GtkWindow *parent_window,
                                     NautilusFileOperationsDBusData *dbus_data) {
-  nautilus_file_operations_duplicate(g_queue_peek_head_link(self->sources),
-                                     parent_window, dbus_data,
+  GList *sources;
+
+  sources = nautilus_file_undo_journal_get_origins(self->files);
+  nautilus_file_operations_duplicate(sources, parent_window, dbus_data,
                                      file_undo_info_transfer_callback, self);
+  g_list_free_full(sources, g_object_unref);
 }
 
 static void ext_copy_redo_func(NautilusFileUndoInfoExt *self,
                                GtkWindow *parent_window,
                                NautilusFileOperationsDBusData *dbus_data) {
-  nautilus_file_operations_copy_async(g_queue_peek_head_link(self->sources),
-                                      self->dest_dir, parent_window, dbus_data,
+  GList *sources;
+
+  sources = nautilus_file_undo_journal_get_origins(self->files);
+  nautilus_file_operations_copy_async(sources, self->dest_dir, parent_window,
+                                      dbus_data,
                                       file_undo_info_transfer_callback, self);
+  g_list_free_full(sources, g_object_unref);
 }
 
 static void
 ext_move_restore_redo_func(NautilusFileUndoInfoExt *self,
                            GtkWindow *parent_window,
                            NautilusFileOperationsDBusData *dbus_data) {
-  nautilus_file_operations_move_async(g_queue_peek_head_link(self->sources),
-                                      self->dest_dir, parent_window, dbus_data,
+  GList *sources;
+
+  sources = nautilus_file_undo_journal_get_origins(self->files);
+  nautilus_file_operations_move_async(sources, self->dest_dir, parent_window,
+                                      dbus_data,
                                       file_undo_info_transfer_callback, self);
+  g_list_free_full(sources, g_object_unref);
 }
 
 static void ext_redo_func(NautilusFileUndoInfo *info, GtkWindow *parent_window,
@@ -532,17 +547,25 @@ static void ext_redo_func(NautilusFileUndoInfo *info, GtkWindow *parent_window,
 static void ext_restore_undo_func(NautilusFileUndoInfoExt *self,
                                   GtkWindow *parent_window,
                                   NautilusFileOperationsDBusData *dbus_data) {
+  GList *destinations;
+
+  destinations = nautilus_file_undo_journal_get_targets(self->files);
   nautilus_file_operations_trash_or_delete_async(
-      g_queue_peek_head_link(self->destinations), parent_window, dbus_data,
-      file_undo_info_delete_callback, self);
+      destinations, parent_window, dbus_data, file_undo_info_delete_callback,
+      self);
+  g_list_free_full(destinations, g_object_unref);
 }
 
 static void ext_move_undo_func(NautilusFileUndoInfoExt *self,
                                GtkWindow *parent_window,
                                NautilusFileOperationsDBusData *dbus_data) {
-  nautilus_file_operations_move_async(
-      g_queue_peek_head_link(self->destinations), self->src_dir, parent_window,
-      dbus_data, file_undo_info_transfer_callback, self);
+  GList *destinations;
+
+  destinations = nautilus_file_undo_journal_get_targets(self->files);
+  nautilus_file_operations_move_async(destinations, self->src_dir,
+                                      parent_window, dbus_data,
+                                      file_undo_info_transfer_callback, self);
+  g_list_free_full(destinations, g_object_unref);
 }
 
 static void
@@ -551,13 +574,13 @@ ext_copy_duplicate_undo_func(NautilusFileUndoInfoExt *self,
                              NautilusFileOperationsDBusData *dbus_data) {
   GList *files;
 
-  files = g_list_copy(g_queue_peek_head_link(self->destinations));
+  files = nautilus_file_undo_journal_get_targets(self->files);
   files = g_list_reverse(files); /* Deleting must be done in reverse */
 
   nautilus_file_operations_delete_async(files, parent_window, dbus_data,
                                         file_undo_info_delete_callback, self);
 
-  g_list_free(files);
+  g_list_free_full(files, g_object_unref);
 }
 
 static void ext_undo_func(NautilusFileUndoInfo *info, GtkWindow *parent_window,
@@ -583,14 +606,7 @@ static void nautilus_file_undo_info_ext_init(NautilusFileUndoInfoExt *self) {}
 static void nautilus_file_undo_info_ext_finalize(GObject *obj) {
   NautilusFileUndoInfoExt *self = NAUTILUS_FILE_UNDO_INFO_EXT(obj);
 
-  if (self->sources) {
-    g_queue_free_full(self->sources, g_object_unref);
-  }
-
-  if (self->destinations) {
-    g_queue_free_full(self->destinations, g_object_unref);
-  }
-
+  g_clear_pointer(&self->files, nautilus_file_undo_journal_free);
   g_clear_object(&self->src_dir);
   g_clear_object(&self->dest_dir);
 
@@ -619,16 +635,14 @@ nautilus_file_undo_info_ext_new(NautilusFileUndoOp op_type, gint item_count,
 
   self->src_dir = g_object_ref(src_dir);
   self->dest_dir = g_object_ref(target_dir);
-  self->sources = g_queue_new();
-  self->destinations = g_queue_new();
+  self->files = nautilus_file_undo_journal_new();
 
   return NAUTILUS_FILE_UNDO_INFO(self);
 }
 
 void nautilus_file_undo_info_ext_add_origin_target_pair(
     NautilusFileUndoInfoExt *self, GFile *origin, GFile *target) {
-  g_queue_push_tail(self->sources, g_object_ref(origin));
-  g_queue_push_tail(self->destinations, g_object_ref(target));
+  nautilus_file_undo_journal_append(self->files, origin, target, 0);
 }
 
 /* create new file/folder */
@@ -1270,9 +1284,30 @@ struct _NautilusFileUndoInfoTrash {
   GHashTable *trashed;
 };
 
+typedef struct {
+  gint64 trash_time;
+  /* the item created in the trash, if it could be found */
+  GFile *trashed_file;
+} TrashedFileData;
+
 G_DEFINE_TYPE(NautilusFileUndoInfoTrash, nautilus_file_undo_info_trash,
               NAUTILUS_TYPE_FILE_UNDO_INFO)
 
+static TrashedFileData *trashed_file_data_new(GFile *trashed_file) {
+  TrashedFileData *data;
+
+  data = g_new0(TrashedFileData, 1);
+  data->trash_time = g_get_real_time() / G_USEC_PER_SEC;
+  data->trashed_file = trashed_file != NULL ? g_object_ref(trashed_file) : NULL;
+
+  return data;
+}
+
+static void trashed_file_data_free(TrashedFileData *data) {
+  g_clear_object(&data->trashed_file);
+  g_free(data);
+}
+
 static void trash_strings_func(NautilusFileUndoInfo *info, gchar **undo_label,
                                gchar **undo_description, gchar **redo_label,
                                gchar **redo_description) {
@@ -1317,24 +1352,22 @@ static void trash_redo_func_callback(GHashTable *debuting_uris,
                                      gboolean user_cancel, gpointer user_data) {
   NautilusFileUndoInfoTrash *self = user_data;
   GHashTable *new_trashed_files;
-  GTimeVal current_time;
-  gsize updated_trash_time;
   GFile *file;
   GList *keys, *l;
 
   if (!user_cancel) {
     new_trashed_files = g_hash_table_new_full(
-        g_file_hash, (GEqualFunc)g_file_equal, g_object_unref, NULL);
+        g_file_hash, (GEqualFunc)g_file_equal, g_object_unref,
+        (GDestroyNotify)trashed_file_data_free);
 
     keys = g_hash_table_get_keys(self->trashed);
 
-    g_get_current_time(&current_time);
-    updated_trash_time = current_time.tv_sec;
-
+    /* The redo isn't recorded by the trash job, so the new trash items are
+     * looked up by name when undoing. */
     for (l = keys; l != NULL; l = l->next) {
       file = l->data;
       g_hash_table_insert(new_trashed_files, g_object_ref(file),
-                          GSIZE_TO_POINTER(updated_trash_time));
+                          trashed_file_data_new(NULL));
     }
 
     g_list_free(keys);
@@ -1362,19 +1395,15 @@ static void trash_redo_func(NautilusFileUndoInfo *info,
   }
 }
 
-static void trash_retrieve_files_to_restore_thread(GTask *task,
-                                                   gpointer source_object,
-                                                   gpointer task_data,
-                                                   GCancellable *cancellable) {
-  NautilusFileUndoInfoTrash *self =
-      NAUTILUS_FILE_UNDO_INFO_TRASH(source_object);
+/* Looks for the remaining files in the whole trash, matching them by original
+ * path and deletion date. This is only needed for the items that couldn't be
+ * found by name, e.g. those trashed on remote locations. */
+static void trash_scan_files_to_restore(NautilusFileUndoInfoTrash *self,
+                                        GHashTable *unresolved,
+                                        GHashTable *to_restore,
+                                        GError **error) {
   GFileEnumerator *enumerator;
-  GHashTable *to_restore;
   GFile *trash;
-  GError *error = NULL;
-
-  to_restore = g_hash_table_new_full(g_file_hash, (GEqualFunc)g_file_equal,
-                                     g_object_unref, g_object_unref);
 
   trash = g_file_new_for_uri("trash:///");
 
@@ -1382,29 +1411,32 @@ static void trash_retrieve_files_to_restore_thread(GTask *task,
       trash,
       G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_TRASH_DELETION_DATE
                                      "," G_FILE_ATTRIBUTE_TRASH_ORIG_PATH,
-      G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, &error);
+      G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, error);
 
   if (enumerator) {
     GFileInfo *info;
-    gpointer lookupvalue;
+    TrashedFileData *data;
     GFile *item;
     glong trash_time, orig_trash_time;
     const char *origpath;
     GFile *origfile;
 
-    while ((info = g_file_enumerator_next_file(enumerator, NULL, &error)) !=
-           NULL) {
+    while (g_hash_table_size(unresolved) > 0 &&
+           (info = g_file_enumerator_next_file(enumerator, NULL, error)) !=
+               NULL) {
       /* Retrieve the original file uri */
       origpath = g_file_info_get_attribute_byte_string(
           info, G_FILE_ATTRIBUTE_TRASH_ORIG_PATH);
       origfile = g_file_new_for_path(origpath);
 
-      lookupvalue = g_hash_table_lookup(self->trashed, origfile);
+      data = g_hash_table_contains(unresolved, origfile)
+                 ? g_hash_table_lookup(self->trashed, origfile)
+                 : NULL;
 
-      if (lookupvalue) {
+      if (data != NULL) {
         GDateTime *date;
 
-        orig_trash_time = GPOINTER_TO_SIZE(lookupvalue);
+        orig_trash_time = data->trash_time;
         trash_time = 0;
         date = g_file_info_get_deletion_date(info);
         if (date) {
@@ -1412,19 +1444,66 @@ static void trash_retrieve_files_to_restore_thread(GTask *task,
           g_date_time_unref(date);
         }
 
-        if (ABS(orig_trash_time - trash_time) <= TRASH_TIME_EPSILON) {
+        if (ABS(orig_trash_time - trash_time) <= NAUTILUS_TRASH_TIME_EPSILON) {
           /* File in the trash */
           item = g_file_get_child(trash, g_file_info_get_name(info));
           g_hash_table_insert(to_restore, item, g_object_ref(origfile));
+          g_hash_table_remove(unresolved, origfile);
         }
       }
 
       g_object_unref(origfile);
+      g_object_unref(info);
     }
     g_file_enumerator_close(enumerator, FALSE, NULL);
     g_object_unref(enumerator);
   }
   g_object_unref(trash);
+}
+
+static void trash_retrieve_files_to_restore_thread(GTask *task,
+                                                   gpointer source_object,
+                                                   gpointer task_data,
+                                                   GCancellable *cancellable) {
+  NautilusFileUndoInfoTrash *self =
+      NAUTILUS_FILE_UNDO_INFO_TRASH(source_object);
+  GHashTable *to_restore;
+  GHashTable *unresolved;
+  GHashTableIter iter;
+  TrashedFileData *data;
+  GFile *origfile;
+  GFile *item;
+  GError *error = NULL;
+
+  to_restore = g_hash_table_new_full(g_file_hash, (GEqualFunc)g_file_equal,
+                                     g_object_unref, g_object_unref);
+  unresolved = g_hash_table_new(g_file_hash, (GEqualFunc)g_file_equal);
+
+  /* Restore directly the items recorded by the trash job, or look them up by
+   * the names GLib could have given them, instead of scanning the trash. */
+  g_hash_table_iter_init(&iter, self->trashed);
+  while (g_hash_table_iter_next(&iter, (gpointer *)&origfile,
+                                (gpointer *)&data)) {
+    if (data->trashed_file != NULL &&
+        nautilus_trashed_file_is_for_location(data->trashed_file, origfile,
+                                              data->trash_time)) {
+      item = g_object_ref(data->trashed_file);
+    } else {
+      item = nautilus_find_trashed_file(origfile, data->trash_time);
+    }
+
+    if (item != NULL) {
+      g_hash_table_insert(to_restore, item, g_object_ref(origfile));
+    } else {
+      g_hash_table_add(unresolved, origfile);
+    }
+  }
+
+  if (g_hash_table_size(unresolved) > 0) {
+    trash_scan_files_to_restore(self, unresolved, to_restore, &error);
+  }
+
+  g_hash_table_destroy(unresolved);
 
   if (error != NULL) {
     g_task_return_error(task, error);
@@ -1466,8 +1545,12 @@ static void trash_retrieve_files_ready(GObject *source, GAsyncResult *res,
       item = l->data;
       dest = g_hash_table_lookup(files_to_restore, item);
 
-      g_file_move(item, dest, G_FILE_COPY_NOFOLLOW_SYMLINKS, NULL, NULL, NULL,
-                  NULL);
+      if (g_file_is_native(item)) {
+        nautilus_restore_trashed_file(item, dest, NULL, NULL);
+      } else {
+        g_file_move(item, dest, G_FILE_COPY_NOFOLLOW_SYMLINKS, NULL, NULL,
+                    NULL, NULL);
+      }
     }
 
     g_list_free(gfiles_in_trash);
@@ -1495,8 +1578,10 @@ static void trash_undo_func(NautilusFileUndoInfo *info,
 
 static void
 nautilus_file_undo_info_trash_init(NautilusFileUndoInfoTrash *self) {
-  self->trashed = g_hash_table_new_full(g_file_hash, (GEqualFunc)g_file_equal,
-                                        g_object_unref, NULL);
+  self->trashed =
+      g_hash_table_new_full(g_file_hash, (GEqualFunc)g_file_equal,
+                            g_object_unref,
+                            (GDestroyNotify)trashed_file_data_free);
 }
 
 static void nautilus_file_undo_info_trash_finalize(GObject *obj) {
@@ -1525,15 +1610,9 @@ NautilusFileUndoInfo *nautilus_file_undo_info_trash_new(gint item_count) {
 }
 
 void nautilus_file_undo_info_trash_add_file(NautilusFileUndoInfoTrash *self,
-                                            GFile *file) {
-  GTimeVal current_time;
-  gsize orig_trash_time;
-
-  g_get_current_time(&current_time);
-  orig_trash_time = current_time.tv_sec;
-
+                                            GFile *file, GFile *trashed_file) {
   g_hash_table_insert(self->trashed, g_object_ref(file),
-                      GSIZE_TO_POINTER(orig_trash_time));
+                      trashed_file_data_new(trashed_file));
 }
 
 GList *
@@ -1546,7 +1625,7 @@ struct _NautilusFileUndoInfoRecPermissions {
   NautilusFileUndoInfo parent_instance;
 
   GFile *dest_dir;
-  GHashTable *original_permissions;
+  NautilusFileUndoJournal *original_permissions;
   guint32 dir_mask;
   guint32 dir_permissions;
   guint32 file_mask;
@@ -1593,36 +1672,30 @@ rec_permissions_redo_func(NautilusFileUndoInfo *info, GtkWindow *parent_window,
   parent_uri = g_file_get_uri(self->dest_dir);
   nautilus_file_set_permissions_recursive(
       parent_uri, self->file_permissions, self->file_mask,
-      self->dir_permissions, self->dir_mask, rec_permissions_callback, self);
+      self->dir_permissions, self->dir_mask, -1, -1, rec_permissions_callback,
+      self);
   g_free(parent_uri);
 }
 
+static gboolean restore_original_permission(GFile *file, GFile *target,
+                                            guint32 permission,
+                                            gpointer user_data) {
+  g_file_set_attribute_uint32(file, G_FILE_ATTRIBUTE_UNIX_MODE, permission,
+                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, NULL);
+
+  return TRUE;
+}
+
 static void
 rec_permissions_undo_func(NautilusFileUndoInfo *info, GtkWindow *parent_window,
                           NautilusFileOperationsDBusData *dbus_data) {
   NautilusFileUndoInfoRecPermissions *self =
       NAUTILUS_FILE_UNDO_INFO_REC_PERMISSIONS(info);
 
-  if (g_hash_table_size(self->original_permissions) > 0) {
-    GList *gfiles_list;
-    guint32 perm;
-    GList *l;
-    GFile *dest;
-    char *item;
-
-    gfiles_list = g_hash_table_get_keys(self->original_permissions);
-    for (l = gfiles_list; l != NULL; l = l->next) {
-      item = l->data;
-      perm = GPOINTER_TO_UINT(
-          g_hash_table_lookup(self->original_permissions, item));
-      dest = g_file_new_for_uri(item);
-      g_file_set_attribute_uint32(dest, G_FILE_ATTRIBUTE_UNIX_MODE, perm,
-                                  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL,
-                                  NULL);
-      g_object_unref(dest);
-    }
+  if (nautilus_file_undo_journal_get_length(self->original_permissions) > 0) {
+    nautilus_file_undo_journal_foreach(self->original_permissions,
+                                       restore_original_permission, NULL);
 
-    g_list_free(gfiles_list);
     /* Here we must do what's necessary for the callback */
     file_undo_info_transfer_callback(NULL, TRUE, self);
   }
@@ -1630,15 +1703,14 @@ rec_permissions_undo_func(NautilusFileUndoInfo *info, GtkWindow *parent_window,
 
 static void nautilus_file_undo_info_rec_permissions_init(
     NautilusFileUndoInfoRecPermissions *self) {
-  self->original_permissions =
-      g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  self->original_permissions = nautilus_file_undo_journal_new();
 }
 
 static void nautilus_file_undo_info_rec_permissions_finalize(GObject *obj) {
   NautilusFileUndoInfoRecPermissions *self =
       NAUTILUS_FILE_UNDO_INFO_REC_PERMISSIONS(obj);
 
-  g_hash_table_destroy(self->original_permissions);
+  nautilus_file_undo_journal_free(self->original_permissions);
   g_clear_object(&self->dest_dir);
 
   G_OBJECT_CLASS(nautilus_file_undo_info_rec_permissions_parent_class)
@@ -1677,9 +1749,8 @@ NautilusFileUndoInfo *nautilus_file_undo_info_rec_permissions_new(
 
 void nautilus_file_undo_info_rec_permissions_add_file(
     NautilusFileUndoInfoRecPermissions *self, GFile *file, guint32 permission) {
-  gchar *original_uri = g_file_get_uri(file);
-  g_hash_table_insert(self->original_permissions, original_uri,
-                      GUINT_TO_POINTER(permission));
+  nautilus_file_undo_journal_append(self->original_permissions, file, NULL,
+                                    permission);
 }
 
 /* single file change permissions */
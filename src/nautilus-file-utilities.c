@@ -40,6 +40,7 @@
 #include <glib/gi18n.h>
 #include <glib/gstdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #define NAUTILUS_USER_DIRECTORY_NAME "nautilus"
@@ -455,7 +456,8 @@ GMount *nautilus_get_mounted_mount_for_root(GFile *location) {
 }
 
 GFile *nautilus_generate_unique_file_in_directory(GFile *directory,
-                                                  const char *basename) {
+                                                  const char *basename,
+                                                  GHashTable *reserved) {
   g_autofree char *basename_without_extension = NULL;
   const char *extension;
   GFile *child;
@@ -471,7 +473,8 @@ GFile *nautilus_generate_unique_file_in_directory(GFile *directory,
   child = g_file_get_child(directory, basename);
 
   copy = 1;
-  while (g_file_query_exists(child, NULL)) {
+  while ((reserved != NULL && g_hash_table_contains(reserved, child)) ||
+         g_file_query_exists(child, NULL)) {
     g_autofree char *filename = NULL;
 
     g_object_unref(child);
@@ -613,6 +616,364 @@ nautilus_trashed_files_get_original_directories(GList *files,
   return directories;
 }
 
+/* GLib names the n-th item trashed with the same basename "name.n.ext", see
+ * get_unique_filename() in glocalfile.c. */
+static gchar *get_trash_name_candidate(const gchar *basename, gint id) {
+  const gchar *dot;
+
+  if (id == 1) {
+    return g_strdup(basename);
+  }
+
+  dot = strchr(basename, '.');
+  if (dot != NULL) {
+    return g_strdup_printf("%.*s.%d%s", (int)(dot - basename), basename, id,
+                           dot);
+  }
+
+  return g_strdup_printf("%s.%d", basename, id);
+}
+
+static gchar *find_mountpoint_for_path(const gchar *path, dev_t dev) {
+  g_autofree gchar *dir = NULL;
+  gchar *parent;
+  GStatBuf parent_stat;
+
+  dir = g_strdup(path);
+  while (TRUE) {
+    parent = g_path_get_dirname(dir);
+    if (g_strcmp0(parent, dir) == 0 || g_lstat(parent, &parent_stat) != 0 ||
+        parent_stat.st_dev != dev) {
+      g_free(parent);
+      break;
+    }
+
+    g_free(dir);
+    dir = parent;
+  }
+
+  return g_steal_pointer(&dir);
+}
+
+/* Returns the trash directories where GLib may have moved @path, following
+ * the same device rules as g_file_trash(). */
+static GList *get_trash_dirs_for_path(const gchar *path) {
+  g_autofree gchar *dirname = NULL;
+  g_autofree gchar *topdir = NULL;
+  g_autofree gchar *uid = NULL;
+  GStatBuf dir_stat;
+  GStatBuf home_stat;
+  GList *trash_dirs = NULL;
+
+  dirname = g_path_get_dirname(path);
+  if (g_lstat(dirname, &dir_stat) != 0) {
+    return NULL;
+  }
+
+  if (g_stat(g_get_home_dir(), &home_stat) == 0 &&
+      home_stat.st_dev == dir_stat.st_dev) {
+    return g_list_prepend(NULL,
+                          g_build_filename(g_get_user_data_dir(), "Trash", NULL));
+  }
+
+  topdir = find_mountpoint_for_path(dirname, dir_stat.st_dev);
+  uid = g_strdup_printf("%lu", (unsigned long)geteuid());
+
+  trash_dirs =
+      g_list_prepend(trash_dirs, g_strdup_printf("%s/.Trash-%s", topdir, uid));
+  trash_dirs =
+      g_list_prepend(trash_dirs, g_build_filename(topdir, ".Trash", uid, NULL));
+
+  return trash_dirs;
+}
+
+static gchar *get_trash_topdir(const gchar *trash_dir) {
+  g_autofree gchar *parent = NULL;
+  g_autofree gchar *basename = NULL;
+
+  /* Either "$topdir/.Trash-$uid" or "$topdir/.Trash/$uid" */
+  parent = g_path_get_dirname(trash_dir);
+  basename = g_path_get_basename(trash_dir);
+  if (g_str_has_prefix(basename, ".Trash-")) {
+    return g_steal_pointer(&parent);
+  }
+
+  return g_path_get_dirname(parent);
+}
+
+static gboolean trash_info_matches(const gchar *trash_dir,
+                                   const gchar *trash_name,
+                                   const gchar *original_path,
+                                   gint64 deletion_time) {
+  g_autoptr(GKeyFile) key_file = NULL;
+  g_autofree gchar *info_name = NULL;
+  g_autofree gchar *info_path = NULL;
+  g_autofree gchar *escaped_path = NULL;
+  g_autofree gchar *path = NULL;
+  g_autofree gchar *date_string = NULL;
+  g_autoptr(GTimeZone) time_zone = NULL;
+  g_autoptr(GDateTime) date = NULL;
+
+  info_name = g_strconcat(trash_name, ".trashinfo", NULL);
+  info_path = g_build_filename(trash_dir, "info", info_name, NULL);
+
+  key_file = g_key_file_new();
+  if (!g_key_file_load_from_file(key_file, info_path, G_KEY_FILE_NONE, NULL)) {
+    return FALSE;
+  }
+
+  escaped_path = g_key_file_get_string(key_file, "Trash Info", "Path", NULL);
+  if (escaped_path == NULL) {
+    return FALSE;
+  }
+
+  path = g_uri_unescape_string(escaped_path, NULL);
+  if (path == NULL) {
+    return FALSE;
+  }
+
+  /* trash directories on other mounts store paths relative to the mount */
+  if (!g_path_is_absolute(path)) {
+    g_autofree gchar *topdir = get_trash_topdir(trash_dir);
+    g_autofree gchar *relative_path = g_steal_pointer(&path);
+
+    path = g_build_filename(topdir, relative_path, NULL);
+  }
+
+  if (g_strcmp0(path, original_path) != 0) {
+    return FALSE;
+  }
+
+  if (deletion_time < 0) {
+    return TRUE;
+  }
+
+  date_string =
+      g_key_file_get_string(key_file, "Trash Info", "DeletionDate", NULL);
+  if (date_string == NULL) {
+    return FALSE;
+  }
+
+  /* the deletion date is stored in local time, without time zone */
+  time_zone = g_time_zone_new_local();
+  date = g_date_time_new_from_iso8601(date_string, time_zone);
+  if (date == NULL) {
+    return FALSE;
+  }
+
+  return ABS(g_date_time_to_unix(date) - deletion_time) <=
+         NAUTILUS_TRASH_TIME_EPSILON;
+}
+
+/* Finds the item created in the trash by trashing @original around
+ * @deletion_time, or any deletion time if it is negative. Only the names GLib
+ * could have picked for it are probed, so the cost doesn't depend on the size
+ * of the trash. Returns the location of the item in the "files" directory of
+ * the trash, or %NULL if @original is not native or no item was found. */
+GFile *nautilus_find_trashed_file(GFile *original, gint64 deletion_time) {
+  g_autofree gchar *original_path = NULL;
+  g_autofree gchar *basename = NULL;
+  GList *trash_dirs;
+  GList *l;
+  GFile *trashed = NULL;
+  gint id;
+
+  original_path = g_file_get_path(original);
+  if (original_path == NULL) {
+    return NULL;
+  }
+
+  basename = g_path_get_basename(original_path);
+  trash_dirs = get_trash_dirs_for_path(original_path);
+
+  for (l = trash_dirs; l != NULL && trashed == NULL; l = l->next) {
+    const gchar *trash_dir = l->data;
+
+    /* GLib reserves the first name without a trash info file, so there is
+     * no point in looking further than the first free one */
+    for (id = 1; trashed == NULL; id++) {
+      g_autofree gchar *trash_name = NULL;
+      g_autofree gchar *info_name = NULL;
+      g_autofree gchar *info_path = NULL;
+      g_autofree gchar *files_path = NULL;
+
+      trash_name = get_trash_name_candidate(basename, id);
+      info_name = g_strconcat(trash_name, ".trashinfo", NULL);
+      info_path = g_build_filename(trash_dir, "info", info_name, NULL);
+      if (!g_file_test(info_path, G_FILE_TEST_EXISTS)) {
+        break;
+      }
+
+      files_path = g_build_filename(trash_dir, "files", trash_name, NULL);
+      if (g_file_test(files_path,
+                      G_FILE_TEST_EXISTS | G_FILE_TEST_IS_SYMLINK) &&
+          trash_info_matches(trash_dir, trash_name, original_path,
+                             deletion_time)) {
+        trashed = g_file_new_for_path(files_path);
+      }
+    }
+  }
+
+  g_list_free_full(trash_dirs, g_free);
+
+  return trashed;
+}
+
+static gchar *get_trash_info_path_for_trashed_file(GFile *trashed,
+                                                   gchar **trash_dir) {
+  g_autofree gchar *path = NULL;
+  g_autofree gchar *files_dir = NULL;
+  g_autofree gchar *trash_name = NULL;
+  g_autofree gchar *info_name = NULL;
+
+  path = g_file_get_path(trashed);
+  if (path == NULL) {
+    return NULL;
+  }
+
+  files_dir = g_path_get_dirname(path);
+  trash_name = g_path_get_basename(path);
+  info_name = g_strconcat(trash_name, ".trashinfo", NULL);
+  *trash_dir = g_path_get_dirname(files_dir);
+
+  return g_build_filename(*trash_dir, "info", info_name, NULL);
+}
+
+/* Checks that @trashed, as returned by nautilus_find_trashed_file(), is still
+ * the item that was created by trashing @original. */
+gboolean nautilus_trashed_file_is_for_location(GFile *trashed, GFile *original,
+                                               gint64 deletion_time) {
+  g_autofree gchar *trash_dir = NULL;
+  g_autofree gchar *info_path = NULL;
+  g_autofree gchar *trash_name = NULL;
+  g_autofree gchar *original_path = NULL;
+
+  original_path = g_file_get_path(original);
+  info_path = get_trash_info_path_for_trashed_file(trashed, &trash_dir);
+  if (original_path == NULL || info_path == NULL) {
+    return FALSE;
+  }
+
+  trash_name = g_file_get_basename(trashed);
+
+  return g_file_query_exists(trashed, NULL) &&
+         trash_info_matches(trash_dir, trash_name, original_path,
+                            deletion_time);
+}
+
+/* Moves @trashed, as returned by nautilus_find_trashed_file(), back to
+ * @original and removes its trash info, like restoring it through trash:///
+ * would do. */
+gboolean nautilus_restore_trashed_file(GFile *trashed, GFile *original,
+                                       GCancellable *cancellable,
+                                       GError **error) {
+  g_autofree gchar *trash_dir = NULL;
+  g_autofree gchar *info_path = NULL;
+
+  info_path = get_trash_info_path_for_trashed_file(trashed, &trash_dir);
+  if (info_path == NULL) {
+    g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                        "Not a local trash item");
+    return FALSE;
+  }
+
+  if (!g_file_move(trashed, original, G_FILE_COPY_NOFOLLOW_SYMLINKS,
+                   cancellable, NULL, NULL, error)) {
+    return FALSE;
+  }
+
+  g_unlink(info_path);
+
+  return TRUE;
+}
+
+/* Copies to FAT file systems round modification times to two seconds */
+#define UP_TO_DATE_MTIME_TOLERANCE_USEC (2 * G_USEC_PER_SEC)
+#define UP_TO_DATE_BUFFER_SIZE (64 * 1024)
+
+static gint64 get_mtime_usec(GFileInfo *info) {
+  return g_file_info_get_attribute_uint64(info,
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED) *
+             G_USEC_PER_SEC +
+         g_file_info_get_attribute_uint32(info,
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+}
+
+/* Reads both files to their end, a part of each at a time */
+gboolean nautilus_file_contents_are_equal(GFile *file_a, GFile *file_b,
+                                          GCancellable *cancellable) {
+  g_autoptr(GFileInputStream) stream_a = NULL;
+  g_autoptr(GFileInputStream) stream_b = NULL;
+  g_autofree guchar *buffer_a = NULL;
+  g_autofree guchar *buffer_b = NULL;
+  gsize read_a;
+  gsize read_b;
+
+  stream_a = g_file_read(file_a, cancellable, NULL);
+  stream_b = g_file_read(file_b, cancellable, NULL);
+  if (stream_a == NULL || stream_b == NULL) {
+    return FALSE;
+  }
+
+  buffer_a = g_malloc(UP_TO_DATE_BUFFER_SIZE);
+  buffer_b = g_malloc(UP_TO_DATE_BUFFER_SIZE);
+
+  do {
+    if (!g_input_stream_read_all(G_INPUT_STREAM(stream_a), buffer_a,
+                                 UP_TO_DATE_BUFFER_SIZE, &read_a, cancellable,
+                                 NULL) ||
+        !g_input_stream_read_all(G_INPUT_STREAM(stream_b), buffer_b,
+                                 UP_TO_DATE_BUFFER_SIZE, &read_b, cancellable,
+                                 NULL)) {
+      return FALSE;
+    }
+
+    if (read_a != read_b || memcmp(buffer_a, buffer_b, read_a) != 0) {
+      return FALSE;
+    }
+  } while (read_a == UP_TO_DATE_BUFFER_SIZE);
+
+  return TRUE;
+}
+
+/* Whether updating @copy with @source can be skipped: it has the same size
+ * and is at least as recent. If @compare_contents is set, a newer @source is
+ * also skipped when both files have exactly the same contents. */
+gboolean nautilus_is_up_to_date_copy(GFile *source, GFile *copy,
+                                     gboolean compare_contents,
+                                     GCancellable *cancellable) {
+  g_autoptr(GFileInfo) source_info = NULL;
+  g_autoptr(GFileInfo) copy_info = NULL;
+  const char *attributes;
+
+  attributes = G_FILE_ATTRIBUTE_STANDARD_TYPE
+      "," G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_TIME_MODIFIED
+      "," G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC;
+  source_info = g_file_query_info(source, attributes,
+                                  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                  cancellable, NULL);
+  copy_info = g_file_query_info(copy, attributes,
+                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                cancellable, NULL);
+  if (source_info == NULL || copy_info == NULL) {
+    return FALSE;
+  }
+
+  if (g_file_info_get_file_type(source_info) != G_FILE_TYPE_REGULAR ||
+      g_file_info_get_file_type(copy_info) != G_FILE_TYPE_REGULAR ||
+      g_file_info_get_size(source_info) != g_file_info_get_size(copy_info)) {
+    return FALSE;
+  }
+
+  if (get_mtime_usec(source_info) <=
+      get_mtime_usec(copy_info) + UP_TO_DATE_MTIME_TOLERANCE_USEC) {
+    return TRUE;
+  }
+
+  return compare_contents &&
+         nautilus_file_contents_are_equal(source, copy, cancellable);
+}
+
 GList *nautilus_file_list_from_uri_list(GList *uris) {
   GList *l;
   GList *result = NULL;
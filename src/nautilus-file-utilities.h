@@ -66,9 +66,11 @@ gboolean nautilus_uri_parse                          (const char  *uri,
 /* Return an allocated file location that is guranteed to be unique, but
  * tries to make the location name readable to users.
  * This isn't race-free, so don't use for security-related things
+ * The locations in @reserved, a set of GFile, are avoided too, if given.
  */
 GFile * nautilus_generate_unique_file_in_directory (GFile      *directory,
-                                                    const char *basename);
+                                                    const char *basename,
+                                                    GHashTable *reserved);
 
 GFile *  nautilus_find_existing_uri_in_hierarchy     (GFile *location);
 
@@ -79,6 +81,32 @@ GHashTable * nautilus_trashed_files_get_original_directories (GList *files,
 void nautilus_restore_files_from_trash (GList *files,
 					GtkWindow *parent_window);
 
+/* Items in the trash whose deletion date is this close to the time they were
+ * trashed at are considered to come from the same operation. */
+#define NAUTILUS_TRASH_TIME_EPSILON 2
+
+GFile *  nautilus_find_trashed_file                  (GFile        *original,
+                                                      gint64        deletion_time);
+gboolean nautilus_trashed_file_is_for_location       (GFile        *trashed,
+                                                      GFile        *original,
+                                                      gint64        deletion_time);
+gboolean nautilus_restore_trashed_file               (GFile        *trashed,
+                                                      GFile        *original,
+                                                      GCancellable *cancellable,
+                                                      GError      **error);
+
+/* Whether both files have the same bytes. This call does blocking I/O. */
+gboolean nautilus_file_contents_are_equal            (GFile        *file_a,
+                                                      GFile        *file_b,
+                                                      GCancellable *cancellable);
+
+/* Whether a copy of @source, over the existing @copy, can be skipped as it is
+ * already up to date. This call does blocking I/O. */
+gboolean nautilus_is_up_to_date_copy                 (GFile        *source,
+                                                      GFile        *copy,
+                                                      gboolean      compare_contents,
+                                                      GCancellable *cancellable);
+
 typedef void (*NautilusMountGetContent) (const char **content, gpointer user_data);
 
 char ** nautilus_get_cached_x_content_types_for_mount (GMount *mount);
@@ -67,6 +67,7 @@
 #include "nautilus-module.h"
 #include "nautilus-signaller.h"
 #include "nautilus-tag-manager.h"
+#include "nautilus-thumbnail-cache.h"
 #include "nautilus-thumbnails.h"
 #include "nautilus-ui-utilities.h"
 #include "nautilus-vfs-file.h"
@@ -141,6 +142,9 @@ static GQuark attribute_name_q, attribute_size_q, attribute_type_q,
     attribute_link_target_q, attribute_volume_q, attribute_free_space_q,
     attribute_starred_q;
 
+/* Number of NautilusFile objects that have not been finalized yet */
+static gint n_files_alive;
+
 static void nautilus_file_info_iface_init(NautilusFileInfoInterface *iface);
 static char *nautilus_file_get_owner_as_string(NautilusFile *file,
                                                gboolean include_real_name);
@@ -166,6 +170,8 @@ static void nautilus_file_init(NautilusFile *file) {
   nautilus_file_invalidate_extension_info_internal(file);
 
   file->details->free_space = -1;
+
+  g_atomic_int_inc(&n_files_alive);
 }
 
 static GObject *
@@ -740,12 +746,7 @@ static void finalize(GObject *object) {
   g_free(file->details->activation_uri);
   g_clear_object(&file->details->custom_icon);
 
-  if (file->details->thumbnail) {
-    g_object_unref(file->details->thumbnail);
-  }
-  if (file->details->scaled_thumbnail) {
-    g_object_unref(file->details->scaled_thumbnail);
-  }
+  nautilus_thumbnail_cache_remove(file->details->thumbnail_handle);
 
   if (file->details->mount) {
     g_signal_handlers_disconnect_by_func(file->details->mount,
@@ -776,9 +777,15 @@ static void finalize(GObject *object) {
 
   g_free(file->details->fts_snippet);
 
+  g_atomic_int_add(&n_files_alive, -1);
+
   G_OBJECT_CLASS(nautilus_file_parent_class)->finalize(object);
 }
 
+guint nautilus_file_get_n_alive(void) {
+  return g_atomic_int_get(&n_files_alive);
+}
+
 NautilusFile *nautilus_file_ref(NautilusFile *file) {
   if (file == NULL) {
     return NULL;
@@ -2307,7 +2314,7 @@ static gboolean update_info_internal(NautilusFile *file, GFileInfo *info,
       g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
   btime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_CREATED);
   if (file->details->atime != atime || file->details->mtime != mtime) {
-    if (file->details->thumbnail == NULL) {
+    if (file->details->thumbnail_handle == 0) {
       file->details->thumbnail_is_up_to_date = FALSE;
     }
 
@@ -2317,7 +2324,8 @@ static gboolean update_info_internal(NautilusFile *file, GFileInfo *info,
   file->details->mtime = mtime;
   file->details->btime = btime;
 
-  if (file->details->thumbnail != NULL && file->details->thumbnail_mtime != 0 &&
+  if (file->details->thumbnail_handle != 0 &&
+      file->details->thumbnail_mtime != 0 &&
       file->details->thumbnail_mtime != mtime) {
     file->details->thumbnail_is_up_to_date = FALSE;
     changed = TRUE;
@@ -4224,7 +4232,8 @@ static NautilusIconInfo *
 nautilus_file_get_thumbnail_icon(NautilusFile *file, int size, int scale,
                                  NautilusFileIconFlags flags) {
   int modified_size;
-  GdkPixbuf *pixbuf;
+  g_autoptr(GdkPixbuf) thumbnail = NULL;
+  g_autoptr(GdkPixbuf) pixbuf = NULL;
   int w, h, s;
   double thumb_scale;
   GIcon *gicon;
@@ -4232,7 +4241,6 @@ nautilus_file_get_thumbnail_icon(NautilusFile *file, int size, int scale,
 
   icon = NULL;
   gicon = NULL;
-  pixbuf = NULL;
 
   if (flags & NAUTILUS_FILE_ICON_FLAGS_FORCE_THUMBNAIL_SIZE) {
     modified_size = size * scale;
@@ -4241,9 +4249,21 @@ nautilus_file_get_thumbnail_icon(NautilusFile *file, int size, int scale,
                     NAUTILUS_GRID_ICON_SIZE_SMALL;
   }
 
-  if (file->details->thumbnail) {
-    w = gdk_pixbuf_get_width(file->details->thumbnail);
-    h = gdk_pixbuf_get_height(file->details->thumbnail);
+  if (file->details->thumbnail_handle != 0) {
+    thumbnail =
+        nautilus_thumbnail_cache_lookup(file->details->thumbnail_handle);
+    if (thumbnail == NULL) {
+      /* Dropped from the cache, load it again from the thumbnail file */
+      DEBUG("Reloading evicted thumbnail for %s", file->details->name);
+      file->details->thumbnail_handle = 0;
+      nautilus_file_invalidate_attributes(file,
+                                          NAUTILUS_FILE_ATTRIBUTE_THUMBNAIL);
+    }
+  }
+
+  if (thumbnail != NULL) {
+    w = gdk_pixbuf_get_width(thumbnail);
+    h = gdk_pixbuf_get_height(thumbnail);
 
     s = MAX(w, h);
     /* Don't scale up small thumbnails in the standard view */
@@ -4259,25 +4279,22 @@ nautilus_file_get_thumbnail_icon(NautilusFile *file, int size, int scale,
       thumb_scale = (double)NAUTILUS_LIST_ICON_SIZE_SMALL / s;
     }
 
-    if (file->details->thumbnail_scale == thumb_scale &&
-        file->details->scaled_thumbnail != NULL) {
-      pixbuf = file->details->scaled_thumbnail;
-    } else {
-      pixbuf = gdk_pixbuf_scale_simple(
-          file->details->thumbnail, MAX(w * thumb_scale, 1),
-          MAX(h * thumb_scale, 1), GDK_INTERP_BILINEAR);
+    pixbuf = nautilus_thumbnail_cache_lookup_scaled(
+        file->details->thumbnail_handle, thumb_scale);
+    if (pixbuf == NULL) {
+      pixbuf = gdk_pixbuf_scale_simple(thumbnail, MAX(w * thumb_scale, 1),
+                                       MAX(h * thumb_scale, 1),
+                                       GDK_INTERP_BILINEAR);
 
       /* We don't want frames around small icons */
-      if (!gdk_pixbuf_get_has_alpha(file->details->thumbnail) ||
-          s >= 128 * scale) {
+      if (!gdk_pixbuf_get_has_alpha(thumbnail) || s >= 128 * scale) {
         if (nautilus_is_video_file(file)) {
           nautilus_ui_frame_video(&pixbuf);
         }
       }
 
-      g_clear_object(&file->details->scaled_thumbnail);
-      file->details->scaled_thumbnail = pixbuf;
-      file->details->thumbnail_scale = thumb_scale;
+      nautilus_thumbnail_cache_set_scaled(file->details->thumbnail_handle,
+                                          pixbuf, thumb_scale);
     }
 
     DEBUG("Returning thumbnailed image, at size %d %d", (int)(w * thumb_scale),
@@ -5308,6 +5325,32 @@ char *nautilus_file_get_group_name(NautilusFile *file) {
   return g_strdup(file->details->group);
 }
 
+/**
+ * nautilus_file_get_uid:
+ *
+ * Get the user id of the file's owner.
+ *
+ * @file: The file in question.
+ *
+ * Return value: The user id, or -1 if it is not known.
+ **/
+int nautilus_file_get_uid(NautilusFile *file) {
+  return file->details->uid;
+}
+
+/**
+ * nautilus_file_get_gid:
+ *
+ * Get the id of the file's group.
+ *
+ * @file: The file in question.
+ *
+ * Return value: The group id, or -1 if it is not known.
+ **/
+int nautilus_file_get_gid(NautilusFile *file) {
+  return file->details->gid;
+}
+
 /**
  * nautilus_file_can_set_group:
  *
@@ -7082,6 +7125,19 @@ void nautilus_file_set_is_thumbnailing(NautilusFile *file,
   file->details->is_thumbnailing = is_thumbnailing;
 }
 
+void nautilus_file_prioritize_io(NautilusFile *file) {
+  g_autofree char *uri = NULL;
+
+  g_return_if_fail(NAUTILUS_IS_FILE(file));
+
+  if (file->details->is_thumbnailing) {
+    uri = nautilus_file_get_uri(file);
+    nautilus_thumbnail_prioritize(uri);
+  } else if (!nautilus_file_is_self_owned(file)) {
+    nautilus_directory_prioritize_file(file->details->directory, file);
+  }
+}
+
 /**
  * nautilus_file_invalidate_attributes
  *
@@ -7429,6 +7485,15 @@ void nautilus_file_list_cancel_call_when_ready(NautilusFileListHandle *handle) {
   }
 }
 
+static void thumbnail_cache_size_changed_callback(gpointer user_data) {
+  guint64 cache_size;
+
+  cache_size = g_settings_get_uint64(nautilus_preferences,
+                                     NAUTILUS_PREFERENCES_THUMBNAIL_CACHE_SIZE);
+
+  nautilus_thumbnail_cache_set_budget(cache_size * MEGA_TO_BASE_RATE);
+}
+
 static void thumbnail_limit_changed_callback(gpointer user_data) {
   cached_thumbnail_limit = g_settings_get_uint64(
       nautilus_preferences, NAUTILUS_PREFERENCES_FILE_THUMBNAIL_LIMIT);
@@ -7615,6 +7680,11 @@ static void nautilus_file_class_init(NautilusFileClass *class) {
       nautilus_preferences,
       "changed::" NAUTILUS_PREFERENCES_FILE_THUMBNAIL_LIMIT,
       G_CALLBACK(thumbnail_limit_changed_callback), NULL);
+  thumbnail_cache_size_changed_callback(NULL);
+  g_signal_connect_swapped(
+      nautilus_preferences,
+      "changed::" NAUTILUS_PREFERENCES_THUMBNAIL_CACHE_SIZE,
+      G_CALLBACK(thumbnail_cache_size_changed_callback), NULL);
   show_thumbnails_changed_callback(NULL);
   g_signal_connect_swapped(
       nautilus_preferences,
@@ -7625,7 +7695,8 @@ static void nautilus_file_class_init(NautilusFileClass *class) {
                    G_CALLBACK(mime_type_data_changed_callback), NULL);
 }
 
-void nautilus_file_info_providers_done(NautilusFile *file) {
+/* Makes what the info providers added current, without telling anyone. */
+void nautilus_file_apply_extension_info(NautilusFile *file) {
   g_list_free_full(file->details->extension_emblems, g_free);
   file->details->extension_emblems = file->details->pending_extension_emblems;
   file->details->pending_extension_emblems = NULL;
@@ -7637,6 +7708,10 @@ void nautilus_file_info_providers_done(NautilusFile *file) {
   file->details->extension_attributes =
       file->details->pending_extension_attributes;
   file->details->pending_extension_attributes = NULL;
+}
+
+void nautilus_file_info_providers_done(NautilusFile *file) {
+  nautilus_file_apply_extension_info(file);
 
   nautilus_file_changed(file);
 }
@@ -155,6 +155,9 @@ NautilusFile *nautilus_file_get_existing_by_uri(const char *uri);
 NautilusFile *nautilus_file_ref(NautilusFile *file);
 void nautilus_file_unref(NautilusFile *file);
 
+/* Number of files that have not been finalized yet, for statistics. */
+guint nautilus_file_get_n_alive(void);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(NautilusFile, nautilus_file_unref)
 
 /* Monitor the file. */
@@ -268,6 +271,8 @@ gboolean nautilus_file_can_get_group(NautilusFile *file);
 gboolean nautilus_file_can_set_group(NautilusFile *file);
 char *nautilus_file_get_owner_name(NautilusFile *file);
 char *nautilus_file_get_group_name(NautilusFile *file);
+int nautilus_file_get_uid(NautilusFile *file);
+int nautilus_file_get_gid(NautilusFile *file);
 GList *nautilus_get_user_names(void);
 GList *nautilus_get_all_group_names(void);
 GList *nautilus_file_get_settable_group_names(NautilusFile *file);
@@ -447,6 +452,10 @@ gboolean nautilus_file_opens_in_view(NautilusFile *file);
 /* Thumbnailing handling */
 gboolean nautilus_file_is_thumbnailing(NautilusFile *file);
 
+/* Do the pending I/O of a visible file, such as loading its thumbnail or
+ * counting its items, before that of the others */
+void nautilus_file_prioritize_io(NautilusFile *file);
+
 /* Convenience functions for dealing with a list of NautilusFile objects that
  * each have a ref. These are just convenient names for functions that work on
  * lists of GtkObject *.
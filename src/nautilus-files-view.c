@@ -2684,6 +2684,7 @@ static void nautilus_files_view_dispose(GObject *object) {
   nautilus_files_view_stop_loading(view);
 
   if (priv->model) {
+    nautilus_directory_keep_warm(priv->model);
     nautilus_directory_unref(priv->model);
     priv->model = NULL;
   }
@@ -7233,6 +7234,9 @@ static void load_directory(NautilusFilesView *view,
 
   /* Avoid freeing it and won't be able to ref it */
   if (priv->model != directory) {
+    if (priv->model != NULL) {
+      nautilus_directory_keep_warm(priv->model);
+    }
     nautilus_directory_unref(priv->model);
     priv->model = nautilus_directory_ref(directory);
   }
@@ -7715,6 +7719,26 @@ static void nautilus_files_view_set_property(GObject *object, guint prop_id,
   }
 }
 
+/* Search results are shown a page at a time, and scrolling to the end of
+ * the view shows the next one. */
+static void on_scrolled_window_edge_reached(NautilusFilesView *view,
+                                            GtkPositionType position) {
+  NautilusFilesViewPrivate *priv;
+  NautilusSearchDirectory *search_directory;
+
+  priv = nautilus_files_view_get_instance_private(view);
+
+  if (position != GTK_POS_BOTTOM ||
+      !NAUTILUS_IS_SEARCH_DIRECTORY(priv->model)) {
+    return;
+  }
+
+  search_directory = NAUTILUS_SEARCH_DIRECTORY(priv->model);
+  if (nautilus_search_directory_get_n_hidden_hits(search_directory) > 0) {
+    nautilus_search_directory_show_more_hits(search_directory);
+  }
+}
+
 /* handle Ctrl+Scroll, which will cause a zoom-in/out */
 static gboolean on_event(GtkWidget *widget, GdkEvent *event,
                          gpointer user_data) {
@@ -8136,6 +8160,8 @@ static void nautilus_files_view_init(NautilusFilesView *view) {
                            view);
   g_signal_connect_swapped(priv->scrolled_window, "popup-menu",
                            G_CALLBACK(popup_menu_callback), view);
+  g_signal_connect_swapped(priv->scrolled_window, "edge-reached",
+                           G_CALLBACK(on_scrolled_window_edge_reached), view);
 
   gtk_overlay_set_child(GTK_OVERLAY(priv->overlay), priv->scrolled_window);
 
@@ -74,6 +74,7 @@ typedef enum {
 /* Compression */
 #define NAUTILUS_PREFERENCES_DEFAULT_COMPRESSION_FORMAT                        \
   "default-compression-format"
+#define NAUTILUS_PREFERENCES_PARALLEL_COMPRESSION "parallel-compression"
 
 typedef enum {
   NAUTILUS_COMPRESSION_ZIP = 0,
@@ -108,6 +109,18 @@ typedef enum {
   "show-directory-item-counts"
 #define NAUTILUS_PREFERENCES_SHOW_FILE_THUMBNAILS "show-image-thumbnails"
 #define NAUTILUS_PREFERENCES_FILE_THUMBNAIL_LIMIT "thumbnail-limit"
+#define NAUTILUS_PREFERENCES_THUMBNAIL_CACHE_SIZE "thumbnail-cache-size"
+
+/* Saved listings of remote directories */
+#define NAUTILUS_PREFERENCES_LISTING_SNAPSHOT_SCHEMES "listing-snapshot-schemes"
+#define NAUTILUS_PREFERENCES_LISTING_SNAPSHOT_MAX_AGE "listing-snapshot-max-age"
+#define NAUTILUS_PREFERENCES_LISTING_SNAPSHOT_MAX_FILES                        \
+  "listing-snapshot-max-files"
+#define NAUTILUS_PREFERENCES_LISTING_SNAPSHOT_MAX_TOTAL_SIZE                   \
+  "listing-snapshot-max-total-size"
+
+/* Updating existing files when copying */
+#define NAUTILUS_PREFERENCES_UPDATE_COMPARES_CONTENTS "update-compares-contents"
 
 typedef enum {
   NAUTILUS_COMPLEX_SEARCH_BAR,
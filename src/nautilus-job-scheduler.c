@@ -0,0 +1,492 @@
+/* nautilus-job-scheduler.c - Runs file operations according to their devices
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "nautilus-job-scheduler.h"
+
+#include <glib/gi18n.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include "nautilus-trace.h"
+
+#define DEBUG_FLAG NAUTILUS_DEBUG_ASYNC_JOBS
+#include "nautilus-debug.h"
+
+/* Concurrent jobs allowed on a single device */
+#define SLOW_DEVICE_MAX_JOBS 1
+#define REMOTE_DEVICE_MAX_JOBS 2
+#define FAST_DEVICE_MAX_JOBS 4
+
+#define MAX_DEVICES_PER_JOB 2
+
+typedef enum {
+  /* Solid state disks, and file systems without a disk of their own */
+  DEVICE_KIND_FAST,
+  /* Spinning and removable disks */
+  DEVICE_KIND_SLOW,
+  DEVICE_KIND_REMOTE,
+} DeviceKind;
+
+typedef struct {
+  char *key;
+  DeviceKind kind;
+  guint n_running;
+} Device;
+
+typedef enum {
+  JOB_STATE_CLASSIFYING,
+  JOB_STATE_QUEUED,
+  JOB_STATE_RUNNING,
+} JobState;
+
+typedef struct {
+  GTask *task;
+  GTaskThreadFunc task_func;
+  NautilusProgressInfo *progress;
+  JobState state;
+
+  GFile *locations[MAX_DEVICES_PER_JOB];
+  /* Set by the classifying thread */
+  char *device_keys[MAX_DEVICES_PER_JOB];
+  DeviceKind device_kinds[MAX_DEVICES_PER_JOB];
+
+  Device *devices[MAX_DEVICES_PER_JOB];
+  guint n_devices;
+
+  gboolean held;
+  gboolean cancelled;
+  /* Whether the progress info was started to show the job as queued */
+  gboolean shown_as_queued;
+} Job;
+
+/* Progress info to Job, for all the jobs that are not finished yet */
+static GHashTable *jobs;
+/* Device key to Device. Devices are never freed, there are only a few. */
+static GHashTable *devices;
+static GQueue queue = G_QUEUE_INIT;
+
+static guint get_max_jobs_for_kind(DeviceKind kind) {
+  switch (kind) {
+  case DEVICE_KIND_SLOW:
+    return SLOW_DEVICE_MAX_JOBS;
+  case DEVICE_KIND_REMOTE:
+    return REMOTE_DEVICE_MAX_JOBS;
+  case DEVICE_KIND_FAST:
+  default:
+    return FAST_DEVICE_MAX_JOBS;
+  }
+}
+
+static gboolean sysfs_flag_is_set(const char *dir, const char *name) {
+  g_autofree char *path = NULL;
+  g_autofree char *contents = NULL;
+
+  path = g_build_filename(dir, name, NULL);
+  if (!g_file_get_contents(path, &contents, NULL, NULL)) {
+    return FALSE;
+  }
+
+  return g_strcmp0(g_strstrip(contents), "1") == 0;
+}
+
+static gboolean get_native_device(const char *path, char **key,
+                                  DeviceKind *kind) {
+  g_autofree char *existing = NULL;
+  g_autofree char *sysfs = NULL;
+  g_autofree char *partition = NULL;
+  g_autofree char *disk = NULL;
+  g_autofree char *dev_path = NULL;
+  g_autofree char *dev = NULL;
+  char *parent;
+  struct stat statbuf;
+
+  /* The output of a compression, for one, does not exist yet */
+  existing = g_strdup(path);
+  while (stat(existing, &statbuf) != 0) {
+    parent = g_path_get_dirname(existing);
+    if (strcmp(parent, existing) == 0) {
+      g_free(parent);
+      return FALSE;
+    }
+    g_free(existing);
+    existing = parent;
+  }
+
+  sysfs = g_strdup_printf("/sys/dev/block/%u:%u", major(statbuf.st_dev),
+                          minor(statbuf.st_dev));
+  if (!g_file_test(sysfs, G_FILE_TEST_EXISTS)) {
+    /* No block device, like tmpfs, or a virtual one, like btrfs */
+    *key = g_strdup_printf("dev:%u:%u", major(statbuf.st_dev),
+                           minor(statbuf.st_dev));
+    *kind = DEVICE_KIND_FAST;
+    return TRUE;
+  }
+
+  /* Partitions of a disk share its queue */
+  partition = g_build_filename(sysfs, "partition", NULL);
+  if (g_file_test(partition, G_FILE_TEST_EXISTS)) {
+    disk = g_build_filename(sysfs, "..", NULL);
+  } else {
+    disk = g_strdup(sysfs);
+  }
+
+  dev_path = g_build_filename(disk, "dev", NULL);
+  if (g_file_get_contents(dev_path, &dev, NULL, NULL)) {
+    *key = g_strconcat("disk:", g_strstrip(dev), NULL);
+  } else {
+    *key = g_strdup_printf("disk:%u:%u", major(statbuf.st_dev),
+                           minor(statbuf.st_dev));
+  }
+
+  if (sysfs_flag_is_set(disk, "queue/rotational") ||
+      sysfs_flag_is_set(disk, "removable")) {
+    *kind = DEVICE_KIND_SLOW;
+  } else {
+    *kind = DEVICE_KIND_FAST;
+  }
+
+  return TRUE;
+}
+
+static gboolean get_device(GFile *location, char **key, DeviceKind *kind) {
+  g_autoptr(GFileInfo) info = NULL;
+  g_autofree char *path = NULL;
+  g_autofree char *scheme = NULL;
+  const char *id;
+
+  path = g_file_get_path(location);
+  if (path != NULL) {
+    return get_native_device(path, key, kind);
+  }
+
+  *kind = DEVICE_KIND_REMOTE;
+
+  info = g_file_query_info(location, G_FILE_ATTRIBUTE_ID_FILESYSTEM,
+                           G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  id = info != NULL ? g_file_info_get_attribute_string(
+                          info, G_FILE_ATTRIBUTE_ID_FILESYSTEM)
+                    : NULL;
+  if (id != NULL) {
+    *key = g_strconcat("fs:", id, NULL);
+    return TRUE;
+  }
+
+  scheme = g_file_get_uri_scheme(location);
+  *key = g_strconcat("scheme:", scheme, NULL);
+
+  return TRUE;
+}
+
+static void classify_thread_func(GTask *task, gpointer source_object,
+                                 gpointer task_data,
+                                 GCancellable *cancellable) {
+  Job *job = task_data;
+  guint i;
+
+  for (i = 0; i < MAX_DEVICES_PER_JOB; i++) {
+    if (job->locations[i] != NULL &&
+        !get_device(job->locations[i], &job->device_keys[i],
+                    &job->device_kinds[i])) {
+      job->device_keys[i] = NULL;
+    }
+  }
+
+  g_task_return_boolean(task, TRUE);
+}
+
+static Device *lookup_device(const char *key, DeviceKind kind) {
+  Device *device;
+
+  if (devices == NULL) {
+    devices = g_hash_table_new(g_str_hash, g_str_equal);
+  }
+
+  device = g_hash_table_lookup(devices, key);
+  if (device == NULL) {
+    device = g_new0(Device, 1);
+    device->key = g_strdup(key);
+    device->kind = kind;
+    g_hash_table_insert(devices, device->key, device);
+  }
+
+  return device;
+}
+
+static void update_queued_status(Job *job) {
+  if (!job->shown_as_queued) {
+    /* Shows the job in the operations popover */
+    nautilus_progress_info_start(job->progress);
+    nautilus_progress_info_pause(job->progress);
+    job->shown_as_queued = TRUE;
+  }
+
+  if (job->held) {
+    nautilus_progress_info_set_status(job->progress, _("Paused"));
+    nautilus_progress_info_set_details(job->progress,
+                                       _("Waiting to be resumed"));
+  } else {
+    nautilus_progress_info_set_status(job->progress, _("Queued"));
+    nautilus_progress_info_set_details(
+        job->progress, _("Waiting for other operations on the same disk"));
+  }
+}
+
+static void run_job(Job *job) {
+  guint i;
+
+  if (job->state == JOB_STATE_QUEUED) {
+    g_queue_remove(&queue, job);
+  }
+  job->state = JOB_STATE_RUNNING;
+
+  for (i = 0; i < job->n_devices; i++) {
+    job->devices[i]->n_running++;
+  }
+
+  if (job->shown_as_queued) {
+    nautilus_progress_info_resume(job->progress);
+    nautilus_progress_info_set_status(job->progress, _("Preparing"));
+    nautilus_progress_info_set_details(job->progress, _("Preparing"));
+  }
+
+  DEBUG("Running job %p on %u devices", job->progress, job->n_devices);
+  nautilus_trace_instant("file operation dispatched", NULL);
+
+  g_task_run_in_thread(job->task, job->task_func);
+  g_clear_object(&job->task);
+}
+
+static guint get_max_jobs(Device *device) {
+  return get_max_jobs_for_kind(device->kind);
+}
+
+static gboolean can_run(Job *job, GHashTable *reserved) {
+  Device *device;
+  guint i;
+
+  for (i = 0; i < job->n_devices; i++) {
+    device = job->devices[i];
+    if (device->n_running >= get_max_jobs(device) ||
+        g_hash_table_contains(reserved, device)) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+static void dispatch_jobs(void) {
+  g_autoptr(GHashTable) reserved = NULL;
+  GList *l;
+  GList *next;
+  Job *job;
+  guint i;
+
+  /* The devices of a job that has to wait are kept for it, so that the
+   * jobs after it in the queue do not get ahead of it forever */
+  reserved = g_hash_table_new(NULL, NULL);
+
+  for (l = queue.head; l != NULL; l = next) {
+    next = l->next;
+    job = l->data;
+
+    if (job->held) {
+      continue;
+    }
+
+    if (can_run(job, reserved)) {
+      run_job(job);
+    } else {
+      for (i = 0; i < job->n_devices; i++) {
+        g_hash_table_add(reserved, job->devices[i]);
+      }
+    }
+  }
+
+  for (l = queue.head; l != NULL; l = l->next) {
+    job = l->data;
+    if (!job->shown_as_queued) {
+      update_queued_status(job);
+    }
+  }
+}
+
+static void classify_done(GObject *source_object, GAsyncResult *res,
+                          gpointer user_data) {
+  Job *job = user_data;
+  Device *device;
+  guint i;
+
+  for (i = 0; i < MAX_DEVICES_PER_JOB; i++) {
+    if (job->device_keys[i] == NULL) {
+      continue;
+    }
+
+    device = lookup_device(job->device_keys[i], job->device_kinds[i]);
+    if (job->n_devices == 0 || job->devices[0] != device) {
+      job->devices[job->n_devices++] = device;
+    }
+    g_clear_pointer(&job->device_keys[i], g_free);
+  }
+
+  DEBUG("Job %p classified on %u devices", job->progress, job->n_devices);
+
+  if (job->cancelled) {
+    run_job(job);
+    return;
+  }
+
+  job->state = JOB_STATE_QUEUED;
+  g_queue_push_tail(&queue, job);
+  dispatch_jobs();
+}
+
+static void on_cancelled(NautilusProgressInfo *progress, Job *job) {
+  job->cancelled = TRUE;
+
+  /* Lets it notice the cancellation and finish right away */
+  if (job->state == JOB_STATE_QUEUED) {
+    run_job(job);
+  }
+}
+
+static void job_free(Job *job) {
+  guint i;
+
+  g_signal_handlers_disconnect_by_data(job->progress, job);
+  g_clear_object(&job->task);
+  g_object_unref(job->progress);
+  for (i = 0; i < MAX_DEVICES_PER_JOB; i++) {
+    g_clear_object(&job->locations[i]);
+  }
+  g_free(job);
+}
+
+static void on_finished(NautilusProgressInfo *progress, Job *job) {
+  guint i;
+
+  if (job->state != JOB_STATE_RUNNING) {
+    return;
+  }
+
+  for (i = 0; i < job->n_devices; i++) {
+    job->devices[i]->n_running--;
+  }
+
+  g_hash_table_remove(jobs, progress);
+
+  dispatch_jobs();
+}
+
+void nautilus_job_scheduler_run_in_thread(GTask *task,
+                                          GTaskThreadFunc task_func,
+                                          NautilusProgressInfo *progress,
+                                          GFile *source, GFile *destination) {
+  g_autoptr(GTask) classify_task = NULL;
+  Job *job;
+
+  if (jobs == NULL) {
+    jobs = g_hash_table_new_full(NULL, NULL, NULL, (GDestroyNotify)job_free);
+  }
+
+  job = g_new0(Job, 1);
+  job->task = g_object_ref(task);
+  job->task_func = task_func;
+  job->progress = g_object_ref(progress);
+  job->state = JOB_STATE_CLASSIFYING;
+  job->locations[0] = source != NULL ? g_object_ref(source) : NULL;
+  job->locations[1] = destination != NULL ? g_object_ref(destination) : NULL;
+  g_hash_table_insert(jobs, progress, job);
+
+  g_signal_connect(progress, "cancelled", G_CALLBACK(on_cancelled), job);
+  g_signal_connect(progress, "finished", G_CALLBACK(on_finished), job);
+
+  /* Finding the devices may block, on remote locations in particular */
+  classify_task = g_task_new(NULL, NULL, classify_done, job);
+  g_task_set_task_data(classify_task, job, NULL);
+  g_task_run_in_thread(classify_task, classify_thread_func);
+}
+
+static Job *lookup_queued_job(NautilusProgressInfo *progress) {
+  Job *job;
+
+  job = jobs != NULL ? g_hash_table_lookup(jobs, progress) : NULL;
+
+  return job != NULL && job->state == JOB_STATE_QUEUED ? job : NULL;
+}
+
+gboolean nautilus_job_scheduler_is_queued(NautilusProgressInfo *progress) {
+  return lookup_queued_job(progress) != NULL;
+}
+
+gboolean nautilus_job_scheduler_is_held(NautilusProgressInfo *progress) {
+  Job *job;
+
+  job = lookup_queued_job(progress);
+
+  return job != NULL && job->held;
+}
+
+void nautilus_job_scheduler_set_held(NautilusProgressInfo *progress,
+                                     gboolean held) {
+  Job *job;
+
+  job = lookup_queued_job(progress);
+  if (job == NULL || job->held == held) {
+    return;
+  }
+
+  job->held = held;
+  update_queued_status(job);
+
+  if (!held) {
+    dispatch_jobs();
+  }
+}
+
+void nautilus_job_scheduler_move_to_front(NautilusProgressInfo *progress) {
+  Job *job;
+
+  job = lookup_queued_job(progress);
+  if (job == NULL) {
+    return;
+  }
+
+  job->held = FALSE;
+  g_queue_remove(&queue, job);
+  g_queue_push_head(&queue, job);
+  update_queued_status(job);
+
+  dispatch_jobs();
+}
+
+guint nautilus_job_scheduler_get_device_concurrency(GFile *location) {
+  g_autofree char *key = NULL;
+  DeviceKind kind;
+
+  if (!get_device(location, &key, &kind)) {
+    kind = DEVICE_KIND_FAST;
+  }
+
+  return get_max_jobs_for_kind(kind);
+}
+
+guint nautilus_job_scheduler_get_n_queued(void) {
+  return g_queue_get_length(&queue);
+}
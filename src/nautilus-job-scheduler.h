@@ -0,0 +1,58 @@
+/* nautilus-job-scheduler.h - Runs file operations according to their devices
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "nautilus-progress-info.h"
+
+G_BEGIN_DECLS
+
+/* File operations are grouped by the disks they read from and write to.
+ * Operations sharing a spinning or removable disk run one after the other,
+ * and a few at a time on other disks and on remote locations, while
+ * operations on unrelated disks run in parallel. The ones that have to wait
+ * are shown as queued in the operations popover, where they can be held or
+ * moved to the front of the queue.
+ *
+ * Jobs are identified by their progress info, and are forgotten once it is
+ * finished. Must only be used from the main thread, except for
+ * nautilus_job_scheduler_get_device_concurrency().
+ */
+
+/* Runs @task_func on @task in a thread once the devices of @source and
+ * @destination, either of which may be NULL, are free enough. */
+void nautilus_job_scheduler_run_in_thread(GTask *task,
+                                          GTaskThreadFunc task_func,
+                                          NautilusProgressInfo *progress,
+                                          GFile *source, GFile *destination);
+
+gboolean nautilus_job_scheduler_is_queued(NautilusProgressInfo *progress);
+gboolean nautilus_job_scheduler_is_held(NautilusProgressInfo *progress);
+/* A held job stays queued until it is released. */
+void nautilus_job_scheduler_set_held(NautilusProgressInfo *progress,
+                                     gboolean held);
+/* Releases the job and makes it the next one to run on its devices. */
+void nautilus_job_scheduler_move_to_front(NautilusProgressInfo *progress);
+
+/* How many jobs may use the device of @location at once, for jobs that do
+ * several things in parallel themselves. Blocks, so call it from a thread. */
+guint nautilus_job_scheduler_get_device_concurrency(GFile *location);
+
+guint nautilus_job_scheduler_get_n_queued(void);
+
+G_END_DECLS
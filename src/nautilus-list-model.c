@@ -70,7 +70,8 @@ typedef struct {
 
   GPtrArray *columns;
 
-  GList *highlight_files;
+  /* Set of the files, which are unique for a location */
+  GHashTable *highlight_files;
 } NautilusListModelPrivate;
 
 typedef struct {
@@ -295,7 +296,7 @@ static void nautilus_list_model_get_value(GtkTreeModel *tree_model,
   FileEntry *file_entry;
   NautilusFile *file;
   char *str;
-  GdkPixbuf *icon, *rendered_icon;
+  GdkPixbuf *icon;
   int icon_size, icon_scale;
   NautilusListZoomLevel zoom_level;
   NautilusFileIconFlags flags;
@@ -358,18 +359,13 @@ static void nautilus_list_model_get_value(GtkTreeModel *tree_model,
       icon = nautilus_file_get_icon_pixbuf(file, icon_size, TRUE, icon_scale,
                                            flags);
 
-      if (priv->highlight_files != NULL &&
-          g_list_find_custom(priv->highlight_files, file,
-                             (GCompareFunc)nautilus_file_compare_location)) {
-        rendered_icon = eel_create_spotlight_pixbuf(icon);
+      surface = gdk_cairo_surface_create_from_pixbuf(icon, icon_scale, NULL);
 
-        if (rendered_icon != NULL) {
-          g_object_unref(icon);
-          icon = rendered_icon;
-        }
+      /* This runs on every paint, so lighten the copy we already have */
+      if (priv->highlight_files != NULL &&
+          g_hash_table_contains(priv->highlight_files, file)) {
+        eel_spotlight_surface(surface);
       }
-
-      surface = gdk_cairo_surface_create_from_pixbuf(icon, icon_scale, NULL);
       g_value_take_boxed(value, surface);
       g_object_unref(icon);
     }
@@ -1417,10 +1413,7 @@ static void nautilus_list_model_finalize(GObject *object) {
   model = NAUTILUS_LIST_MODEL(object);
   priv = nautilus_list_model_get_instance_private(model);
 
-  if (priv->highlight_files != NULL) {
-    nautilus_file_list_free(priv->highlight_files);
-    priv->highlight_files = NULL;
-  }
+  g_clear_pointer(&priv->highlight_files, g_hash_table_unref);
 
   G_OBJECT_CLASS(nautilus_list_model_parent_class)->finalize(object);
 }
@@ -1549,17 +1542,46 @@ static void refresh_row(gpointer data, gpointer user_data) {
 void nautilus_list_model_set_highlight_for_files(NautilusListModel *model,
                                                  GList *files) {
   NautilusListModelPrivate *priv;
+  GHashTable *old_files;
+  GHashTableIter iter;
+  NautilusFile *file;
+  GList *l;
 
   priv = nautilus_list_model_get_instance_private(model);
 
-  if (priv->highlight_files != NULL) {
-    g_list_foreach(priv->highlight_files, refresh_row, model);
-    nautilus_file_list_free(priv->highlight_files);
-    priv->highlight_files = NULL;
-  }
+  old_files = priv->highlight_files;
+  priv->highlight_files = NULL;
 
   if (files != NULL) {
-    priv->highlight_files = nautilus_file_list_copy(files);
-    g_list_foreach(priv->highlight_files, refresh_row, model);
+    priv->highlight_files = g_hash_table_new_full(
+        NULL, NULL, (GDestroyNotify)nautilus_file_unref, NULL);
+    for (l = files; l != NULL; l = l->next) {
+      file = l->data;
+      if (!g_hash_table_contains(priv->highlight_files, file)) {
+        g_hash_table_add(priv->highlight_files, nautilus_file_ref(file));
+      }
+    }
+  }
+
+  /* Only the rows whose state changes need to be drawn again */
+  if (old_files != NULL) {
+    g_hash_table_iter_init(&iter, old_files);
+    while (g_hash_table_iter_next(&iter, (gpointer *)&file, NULL)) {
+      if (priv->highlight_files == NULL ||
+          !g_hash_table_contains(priv->highlight_files, file)) {
+        refresh_row(file, model);
+      }
+    }
   }
+
+  if (priv->highlight_files != NULL) {
+    g_hash_table_iter_init(&iter, priv->highlight_files);
+    while (g_hash_table_iter_next(&iter, (gpointer *)&file, NULL)) {
+      if (old_files == NULL || !g_hash_table_contains(old_files, file)) {
+        refresh_row(file, model);
+      }
+    }
+  }
+
+  g_clear_pointer(&old_files, g_hash_table_unref);
 }
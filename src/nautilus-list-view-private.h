@@ -79,4 +79,6 @@ struct NautilusListViewDetails {
   GtkEventController *motion_controller;
   GtkEventController *key_controller;
   GtkGesture *long_press_gesture;
+
+  guint prioritize_files_idle_id;
 };
@@ -1624,6 +1624,86 @@ static void list_view_use_tree_changed_callback(gpointer callback_data) {
   gtk_tree_view_collapse_all(tree_view);
 }
 
+static gboolean get_next_visible_iter(NautilusListView *view,
+                                      GtkTreeIter *iter) {
+  GtkTreeModel *model;
+  g_autoptr(GtkTreePath) path = NULL;
+  GtkTreeIter child;
+
+  model = GTK_TREE_MODEL(view->details->model);
+  path = gtk_tree_model_get_path(model, iter);
+
+  if (gtk_tree_view_row_expanded(view->details->tree_view, path) &&
+      gtk_tree_model_iter_children(model, &child, iter)) {
+    *iter = child;
+    return TRUE;
+  }
+
+  /* Otherwise the next sibling of the row or of its closest ancestor */
+  while (TRUE) {
+    child = *iter;
+    if (gtk_tree_model_iter_next(model, iter)) {
+      return TRUE;
+    }
+    if (!gtk_tree_model_iter_parent(model, iter, &child)) {
+      return FALSE;
+    }
+  }
+}
+
+/* Moves the attributes of the visible rows, like the item count of folders,
+ * ahead in the directory work queues. */
+static gboolean prioritize_visible_files_on_idle(gpointer user_data) {
+  NautilusListView *view;
+  GtkTreeModel *model;
+  g_autoptr(GtkTreePath) start = NULL;
+  g_autoptr(GtkTreePath) end = NULL;
+  g_autoptr(GtkTreePath) path = NULL;
+  GtkTreeIter iter;
+  GList *files = NULL;
+  NautilusFile *file;
+
+  view = NAUTILUS_LIST_VIEW(user_data);
+  view->details->prioritize_files_idle_id = 0;
+  model = GTK_TREE_MODEL(view->details->model);
+
+  if (model == NULL ||
+      !gtk_tree_view_get_visible_range(view->details->tree_view, &start,
+                                       &end) ||
+      !gtk_tree_model_get_iter(model, &iter, start)) {
+    return G_SOURCE_REMOVE;
+  }
+
+  do {
+    gtk_tree_model_get(model, &iter, NAUTILUS_LIST_MODEL_FILE_COLUMN, &file,
+                       -1);
+    if (file != NULL) {
+      files = g_list_prepend(files, file);
+    }
+
+    g_clear_pointer(&path, gtk_tree_path_free);
+    path = gtk_tree_model_get_path(model, &iter);
+  } while (gtk_tree_path_compare(path, end) < 0 &&
+           get_next_visible_iter(view, &iter));
+
+  /* The files are in reverse order, so that the top rows end up first */
+  g_list_foreach(files, (GFunc)nautilus_file_prioritize_io, NULL);
+  nautilus_file_list_free(files);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void on_vadjustment_changed(GtkAdjustment *adjustment,
+                                   gpointer user_data) {
+  NautilusListView *view = NAUTILUS_LIST_VIEW(user_data);
+
+  /* Schedule on idle to rate limit and to avoid delaying scrolling. */
+  if (view->details->prioritize_files_idle_id == 0) {
+    view->details->prioritize_files_idle_id =
+        g_idle_add(prioritize_visible_files_on_idle, view);
+  }
+}
+
 static void create_and_set_up_tree_view(NautilusListView *view) {
   GtkCellRenderer *cell;
   GtkTreeViewColumn *column;
@@ -1634,6 +1714,7 @@ static void create_and_set_up_tree_view(NautilusListView *view) {
   GtkWidget *content_widget;
   GtkGesture *gesture;
   GtkEventController *controller;
+  GtkAdjustment *vadjustment;
 
   content_widget =
       nautilus_files_view_get_content_widget(NAUTILUS_FILES_VIEW(view));
@@ -1906,6 +1987,13 @@ static void create_and_set_up_tree_view(NautilusListView *view) {
   gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(content_widget),
                                 GTK_WIDGET(view->details->tree_view));
 
+  vadjustment =
+      gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(content_widget));
+  g_signal_connect_object(vadjustment, "changed",
+                          G_CALLBACK(on_vadjustment_changed), view, 0);
+  g_signal_connect_object(vadjustment, "value-changed",
+                          G_CALLBACK(on_vadjustment_changed), view, 0);
+
   atk_obj = gtk_widget_get_accessible(GTK_WIDGET(view->details->tree_view));
   atk_object_set_name(atk_obj, _("List View"));
 
@@ -3026,6 +3114,9 @@ static void nautilus_list_view_dispose(GObject *object) {
   g_clear_object(&list_view->details->key_controller);
   g_clear_object(&list_view->details->long_press_gesture);
 
+  g_clear_handle_id(&list_view->details->prioritize_files_idle_id,
+                    g_source_remove);
+
   G_OBJECT_CLASS(nautilus_list_view_parent_class)->dispose(object);
 }
 
@@ -0,0 +1,352 @@
+/* nautilus-listing-snapshot.c - Saved listings of remote directories
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "nautilus-listing-snapshot.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define DEBUG_FLAG NAUTILUS_DEBUG_ASYNC_JOBS
+#include "nautilus-debug.h"
+#include "nautilus-file.h"
+#include "nautilus-global-preferences.h"
+
+/* Bumped whenever the format changes, older snapshots are then ignored */
+#define SNAPSHOT_VERSION 1
+/* Version, time saved in microseconds, and for each file its name, display
+ * name, type, size, modification time, content type and whether it is
+ * hidden. */
+#define SNAPSHOT_TYPE "(uxa(ssuttsb))"
+#define SNAPSHOT_ENTRY_TYPE "(ssuttsb)"
+
+typedef struct {
+  char *path;
+  gint64 mtime;
+  goffset size;
+} SnapshotUsage;
+
+/* Only one pruning of the snapshot directory at a time */
+static gint pruning;
+
+static char *get_snapshots_dir(void) {
+  return g_build_filename(g_get_user_cache_dir(), "nautilus", "listings",
+                          NULL);
+}
+
+static char *get_snapshot_path(GFile *location) {
+  g_autofree char *uri = NULL;
+  g_autofree char *checksum = NULL;
+  g_autofree char *dirname = NULL;
+
+  uri = g_file_get_uri(location);
+  checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA256, uri, -1);
+  dirname = get_snapshots_dir();
+
+  return g_build_filename(dirname, checksum, NULL);
+}
+
+gboolean nautilus_listing_snapshot_is_enabled(GFile *location) {
+  g_auto(GStrv) schemes = NULL;
+  g_autofree char *scheme = NULL;
+
+  g_return_val_if_fail(G_IS_FILE(location), FALSE);
+
+  if (g_file_is_native(location)) {
+    return FALSE;
+  }
+
+  schemes = g_settings_get_strv(nautilus_preferences,
+                                NAUTILUS_PREFERENCES_LISTING_SNAPSHOT_SCHEMES);
+  if (schemes[0] == NULL) {
+    return FALSE;
+  }
+
+  scheme = g_file_get_uri_scheme(location);
+
+  return scheme != NULL && g_strv_contains((const char *const *)schemes,
+                                           scheme);
+}
+
+static GFileInfo *create_file_info(GVariant *entry) {
+  GFileInfo *info;
+  const char *name;
+  const char *display_name;
+  const char *content_type;
+  guint32 type;
+  guint64 size;
+  guint64 mtime;
+  gboolean is_hidden;
+
+  g_variant_get(entry, "(&s&sutt&sb)", &name, &display_name, &type, &size,
+                &mtime, &content_type, &is_hidden);
+
+  if (*name == '\0' || strchr(name, '/') != NULL) {
+    return NULL;
+  }
+
+  info = g_file_info_new();
+  g_file_info_set_name(info, name);
+  g_file_info_set_display_name(info, *display_name != '\0' ? display_name
+                                                           : name);
+  g_file_info_set_file_type(info, type);
+  g_file_info_set_size(info, size);
+  g_file_info_set_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                   mtime);
+  if (*content_type != '\0') {
+    g_file_info_set_content_type(info, content_type);
+  }
+  g_file_info_set_is_hidden(info, is_hidden);
+  g_file_info_set_attribute_boolean(info, NAUTILUS_LISTING_SNAPSHOT_ATTRIBUTE,
+                                    TRUE);
+
+  return info;
+}
+
+GList *nautilus_listing_snapshot_load(GFile *location) {
+  g_autofree char *path = NULL;
+  g_autoptr(GMappedFile) mapped_file = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GVariant) snapshot = NULL;
+  g_autoptr(GVariant) entries = NULL;
+  GVariantIter iter;
+  GVariant *entry;
+  GFileInfo *info;
+  GList *infos;
+  guint32 version;
+  gint64 saved_time;
+  gint64 max_age;
+
+  g_return_val_if_fail(G_IS_FILE(location), NULL);
+
+  path = get_snapshot_path(location);
+  mapped_file = g_mapped_file_new(path, FALSE, NULL);
+  if (mapped_file == NULL) {
+    return NULL;
+  }
+
+  /* The entries are read straight from the mapped file */
+  bytes = g_mapped_file_get_bytes(mapped_file);
+  snapshot = g_variant_ref_sink(
+      g_variant_new_from_bytes(G_VARIANT_TYPE(SNAPSHOT_TYPE), bytes, FALSE));
+
+  g_variant_get_child(snapshot, 0, "u", &version);
+  g_variant_get_child(snapshot, 1, "x", &saved_time);
+  if (version != SNAPSHOT_VERSION) {
+    return NULL;
+  }
+
+  max_age = g_settings_get_uint(nautilus_preferences,
+                                NAUTILUS_PREFERENCES_LISTING_SNAPSHOT_MAX_AGE);
+  if (g_get_real_time() - saved_time > max_age * G_USEC_PER_SEC) {
+    DEBUG("Listing snapshot %s is too old", path);
+    return NULL;
+  }
+
+  entries = g_variant_get_child_value(snapshot, 2);
+  infos = NULL;
+  g_variant_iter_init(&iter, entries);
+  while ((entry = g_variant_iter_next_value(&iter)) != NULL) {
+    info = create_file_info(entry);
+    if (info != NULL) {
+      infos = g_list_prepend(infos, info);
+    }
+    g_variant_unref(entry);
+  }
+
+  DEBUG("Loaded %u files from listing snapshot %s", g_list_length(infos),
+        path);
+
+  return g_list_reverse(infos);
+}
+
+static void snapshot_usage_clear(SnapshotUsage *usage) {
+  g_free(usage->path);
+}
+
+static gint compare_usages_by_mtime(gconstpointer a, gconstpointer b) {
+  const SnapshotUsage *usage_a = a;
+  const SnapshotUsage *usage_b = b;
+
+  return (usage_a->mtime > usage_b->mtime) - (usage_a->mtime < usage_b->mtime);
+}
+
+/* Removes the snapshots that are too old to be used, then the least recently
+ * saved ones until they all fit in the maximum total size. */
+static void prune_snapshots_thread(GTask *task, gpointer source_object,
+                                   gpointer task_data,
+                                   GCancellable *cancellable) {
+  g_autofree char *dirname = NULL;
+  g_autoptr(GDir) dir = NULL;
+  g_autoptr(GArray) usages = NULL;
+  const char *name;
+  gint64 now;
+  gint64 max_age;
+  guint64 max_size;
+  guint64 total_size;
+  guint i;
+
+  dirname = get_snapshots_dir();
+  dir = g_dir_open(dirname, 0, NULL);
+  if (dir == NULL) {
+    g_atomic_int_set(&pruning, 0);
+    return;
+  }
+
+  now = g_get_real_time();
+  max_age = g_settings_get_uint(nautilus_preferences,
+                                NAUTILUS_PREFERENCES_LISTING_SNAPSHOT_MAX_AGE);
+  max_size = g_settings_get_uint64(
+                 nautilus_preferences,
+                 NAUTILUS_PREFERENCES_LISTING_SNAPSHOT_MAX_TOTAL_SIZE) *
+             1024 * 1024;
+
+  usages = g_array_new(FALSE, FALSE, sizeof(SnapshotUsage));
+  g_array_set_clear_func(usages, (GDestroyNotify)snapshot_usage_clear);
+  total_size = 0;
+
+  while ((name = g_dir_read_name(dir)) != NULL) {
+    SnapshotUsage usage;
+    GStatBuf buf;
+
+    usage.path = g_build_filename(dirname, name, NULL);
+    if (g_lstat(usage.path, &buf) != 0 || !S_ISREG(buf.st_mode)) {
+      g_free(usage.path);
+      continue;
+    }
+
+    usage.mtime = (gint64)buf.st_mtime * G_USEC_PER_SEC;
+    usage.size = buf.st_size;
+    if (now - usage.mtime > max_age * G_USEC_PER_SEC) {
+      DEBUG("Removing listing snapshot %s, too old", usage.path);
+      g_unlink(usage.path);
+      g_free(usage.path);
+      continue;
+    }
+
+    total_size += usage.size;
+    g_array_append_val(usages, usage);
+  }
+
+  g_array_sort(usages, compare_usages_by_mtime);
+  for (i = 0; i < usages->len && total_size > max_size; i++) {
+    SnapshotUsage *usage = &g_array_index(usages, SnapshotUsage, i);
+
+    DEBUG("Removing listing snapshot %s, over the total size", usage->path);
+    g_unlink(usage->path);
+    total_size -= usage->size;
+  }
+
+  g_atomic_int_set(&pruning, 0);
+}
+
+static void prune_snapshots(void) {
+  g_autoptr(GTask) task = NULL;
+
+  if (!g_atomic_int_compare_and_exchange(&pruning, 0, 1)) {
+    return;
+  }
+
+  task = g_task_new(NULL, NULL, NULL, NULL);
+  g_task_set_source_tag(task, prune_snapshots);
+  g_task_run_in_thread(task, prune_snapshots_thread);
+}
+
+static void replace_contents_callback(GObject *source_object,
+                                      GAsyncResult *res, gpointer user_data) {
+  g_autoptr(GError) error = NULL;
+
+  if (!g_file_replace_contents_finish(G_FILE(source_object), res, NULL,
+                                      &error)) {
+    DEBUG("Could not save listing snapshot: %s", error->message);
+    return;
+  }
+
+  prune_snapshots();
+}
+
+static void add_entry(GVariantBuilder *builder, NautilusFile *file) {
+  g_autofree char *name = NULL;
+  g_autofree char *display_name = NULL;
+  g_autofree char *content_type = NULL;
+  goffset size;
+
+  name = nautilus_file_get_name(file);
+  display_name = nautilus_file_get_display_name(file);
+  content_type = nautilus_file_get_mime_type(file);
+  size = nautilus_file_get_size(file);
+
+  g_variant_builder_add(builder, SNAPSHOT_ENTRY_TYPE, name,
+                        display_name != NULL ? display_name : "",
+                        (guint32)nautilus_file_get_file_type(file),
+                        (guint64)MAX(size, 0),
+                        (guint64)MAX(nautilus_file_get_mtime(file), 0),
+                        content_type != NULL ? content_type : "",
+                        nautilus_file_is_hidden_file(file));
+}
+
+void nautilus_listing_snapshot_save(GFile *location, GList *files) {
+  g_autofree char *path = NULL;
+  g_autofree char *dirname = NULL;
+  g_autoptr(GFile) snapshot_file = NULL;
+  g_autoptr(GVariant) snapshot = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  GVariantBuilder builder;
+  NautilusFile *file;
+  GList *l;
+  guint n_files;
+  guint max_files;
+
+  g_return_if_fail(G_IS_FILE(location));
+
+  path = get_snapshot_path(location);
+
+  n_files = g_list_length(files);
+  max_files = g_settings_get_uint(
+      nautilus_preferences, NAUTILUS_PREFERENCES_LISTING_SNAPSHOT_MAX_FILES);
+  if (n_files > max_files) {
+    /* Don't leave an outdated snapshot behind */
+    DEBUG("Not saving listing snapshot %s, %u files is too many", path,
+          n_files);
+    g_unlink(path);
+    return;
+  }
+
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a" SNAPSHOT_ENTRY_TYPE));
+  for (l = files; l != NULL; l = l->next) {
+    file = NAUTILUS_FILE(l->data);
+    if (!nautilus_file_is_gone(file)) {
+      add_entry(&builder, file);
+    }
+  }
+
+  snapshot = g_variant_ref_sink(
+      g_variant_new(SNAPSHOT_TYPE, SNAPSHOT_VERSION, g_get_real_time(),
+                    &builder));
+  bytes = g_variant_get_data_as_bytes(snapshot);
+
+  dirname = g_path_get_dirname(path);
+  if (g_mkdir_with_parents(dirname, 0700) != 0) {
+    return;
+  }
+
+  snapshot_file = g_file_new_for_path(path);
+  g_file_replace_contents_bytes_async(snapshot_file, bytes, NULL, FALSE,
+                                      G_FILE_CREATE_PRIVATE, NULL,
+                                      replace_contents_callback, NULL);
+}
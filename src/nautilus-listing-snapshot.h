@@ -0,0 +1,44 @@
+/* nautilus-listing-snapshot.h - Saved listings of remote directories
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+/* The last complete listing of a remote directory can be kept in the user
+ * cache directory, so that it is shown right away the next time the
+ * directory is opened instead of waiting for the server. The directory is
+ * still enumerated as usual, and the saved entries are then confirmed,
+ * updated or removed like the ones of a reloaded directory.
+ *
+ * Which locations get a snapshot, how old a snapshot can be to still be
+ * used and how big a listing can be to be saved are set in the preferences.
+ * Every save also removes the snapshots that are too old, and then the
+ * oldest ones past the total size set in the preferences.
+ */
+
+/* Set on the file infos made from a snapshot, which haven't been seen in
+ * the live listing yet. */
+#define NAUTILUS_LISTING_SNAPSHOT_ATTRIBUTE "nautilus::from-snapshot"
+
+gboolean nautilus_listing_snapshot_is_enabled(GFile *location);
+
+/* Returns a list of GFileInfo, or NULL if there is no usable snapshot. */
+GList *nautilus_listing_snapshot_load(GFile *location);
+
+/* Saves the given NautilusFile list as the listing of @location, replacing
+ * the previous snapshot. Writing is done asynchronously. */
+void nautilus_listing_snapshot_save(GFile *location, GList *files);
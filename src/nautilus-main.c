@@ -31,6 +31,7 @@
 #include "nautilus-resources.h"
 
 #include "nautilus-debug.h"
+#include "nautilus-trace.h"
 #include <eel/eel-debug.h>
 
 #include <glib/gi18n.h>
@@ -68,6 +69,8 @@ main (int   argc,
 
     g_set_prgname (APPLICATION_ID);
 
+    nautilus_trace_init ();
+
     nautilus_register_resource ();
     /* Run the nautilus application. */
     application = nautilus_application_new ();
@@ -83,6 +86,7 @@ main (int   argc,
 
     g_object_unref (application);
 
+    nautilus_trace_shutdown ();
     eel_debug_shut_down ();
 
     return retval;
@@ -332,6 +332,11 @@ static void set_replace_button_label(FileConflictDialogData *data) {
                                                              _("Merge"));
     }
   }
+
+  /* Updating only compares files with files and folders with folders */
+  if (source_is_directory != destination_is_directory) {
+    nautilus_file_conflict_dialog_disable_update(data->dialog);
+  }
 }
 
 static void file_icons_changed(NautilusFile *file,
@@ -21,6 +21,8 @@ enum {
   CONFLICT_RESPONSE_SKIP = 1,
   CONFLICT_RESPONSE_REPLACE = 2,
   CONFLICT_RESPONSE_RENAME = 3,
+  /* Replace only if the source is newer or differs in size, merge folders */
+  CONFLICT_RESPONSE_UPDATE = 4,
 };
 
 void handle_unsupported_compressed_file(GtkWindow *parent_window,
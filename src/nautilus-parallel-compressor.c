@@ -0,0 +1,291 @@
+/* nautilus-parallel-compressor.c - Creates archives on several threads
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "nautilus-parallel-compressor.h"
+
+#include <archive.h>
+#include <archive_entry.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEBUG_FLAG NAUTILUS_DEBUG_ASYNC_JOBS
+#include "nautilus-debug.h"
+
+#define BUFFER_SIZE (64 * 1024)
+#define PROGRESS_INTERVAL_USEC (100 * 1000)
+
+typedef struct {
+  struct archive *writer;
+  struct archive *disk;
+  guchar *buffer;
+
+  guint64 completed_size;
+  guint completed_files;
+  gint64 last_progress_time;
+
+  NautilusParallelCompressorProgressFunc progress_func;
+  gpointer user_data;
+  GCancellable *cancellable;
+} Compression;
+
+gboolean nautilus_parallel_compressor_is_supported(GList *source_files,
+                                                   GFile *output_file,
+                                                   AutoarFormat format,
+                                                   AutoarFilter filter) {
+  GList *l;
+
+  /* Only liblzma has a threaded encoder among the filters libarchive
+   * writes with, deflate and the others run on a single thread. */
+  if (format != AUTOAR_FORMAT_TAR || filter != AUTOAR_FILTER_XZ) {
+    return FALSE;
+  }
+
+  if (!g_file_is_native(output_file)) {
+    return FALSE;
+  }
+
+  for (l = source_files; l != NULL; l = l->next) {
+    if (!g_file_is_native(l->data)) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+static gboolean set_archive_error(struct archive *archive, GError **error) {
+  const char *message;
+
+  message = archive_error_string(archive);
+  g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                      message != NULL ? message : "Unknown archive error");
+
+  return FALSE;
+}
+
+static void notify_progress(Compression *compression, gboolean force) {
+  gint64 now;
+
+  if (compression->progress_func == NULL) {
+    return;
+  }
+
+  now = g_get_monotonic_time();
+  if (!force &&
+      now - compression->last_progress_time < PROGRESS_INTERVAL_USEC) {
+    return;
+  }
+
+  compression->last_progress_time = now;
+  compression->progress_func(compression->completed_size,
+                             compression->completed_files,
+                             compression->user_data);
+}
+
+static gboolean write_entry_data(Compression *compression, GError **error) {
+  la_ssize_t read;
+
+  while ((read = archive_read_data(compression->disk, compression->buffer,
+                                   BUFFER_SIZE)) > 0) {
+    if (g_cancellable_set_error_if_cancelled(compression->cancellable,
+                                             error)) {
+      return FALSE;
+    }
+
+    if (archive_write_data(compression->writer, compression->buffer, read) <
+        0) {
+      return set_archive_error(compression->writer, error);
+    }
+
+    compression->completed_size += read;
+    notify_progress(compression, FALSE);
+  }
+
+  if (read < 0) {
+    return set_archive_error(compression->disk, error);
+  }
+
+  return TRUE;
+}
+
+/* Adds @source and everything below it, named relative to its parent as
+ * AutoarCompressor does. */
+static gboolean write_source(Compression *compression, GFile *source,
+                             GError **error) {
+  g_autofree char *path = NULL;
+  g_autofree char *parent_path = NULL;
+  g_autoptr(GFile) parent = NULL;
+  struct archive_entry *entry;
+  gsize prefix_length;
+  gboolean success = TRUE;
+  int result;
+
+  path = g_file_get_path(source);
+  parent = g_file_get_parent(source);
+  parent_path = parent != NULL ? g_file_get_path(parent) : NULL;
+  prefix_length = parent_path != NULL ? strlen(parent_path) : 0;
+  if (prefix_length > 0 && !g_str_has_suffix(parent_path, G_DIR_SEPARATOR_S)) {
+    prefix_length++;
+  }
+
+  if (archive_read_disk_open(compression->disk, path) != ARCHIVE_OK) {
+    return set_archive_error(compression->disk, error);
+  }
+
+  entry = archive_entry_new();
+  while (success) {
+    const char *entry_path;
+
+    archive_entry_clear(entry);
+    result = archive_read_next_header2(compression->disk, entry);
+    if (result == ARCHIVE_EOF) {
+      break;
+    }
+    if (result < ARCHIVE_WARN) {
+      success = set_archive_error(compression->disk, error);
+      break;
+    }
+
+    if (g_cancellable_set_error_if_cancelled(compression->cancellable,
+                                             error)) {
+      success = FALSE;
+      break;
+    }
+
+    archive_read_disk_descend(compression->disk);
+
+    entry_path = archive_entry_pathname(entry);
+    if (entry_path != NULL && strlen(entry_path) > prefix_length) {
+      g_autofree char *relative_path = NULL;
+
+      relative_path = g_strdup(entry_path + prefix_length);
+      archive_entry_copy_pathname(entry, relative_path);
+    }
+
+    result = archive_write_header(compression->writer, entry);
+    if (result < ARCHIVE_WARN) {
+      success = set_archive_error(compression->writer, error);
+      break;
+    }
+
+    if (archive_entry_filetype(entry) == AE_IFREG &&
+        archive_entry_size(entry) > 0) {
+      success = write_entry_data(compression, error);
+    }
+
+    compression->completed_files++;
+    notify_progress(compression, FALSE);
+  }
+
+  archive_entry_free(entry);
+  archive_read_close(compression->disk);
+
+  return success;
+}
+
+gboolean nautilus_parallel_compressor_run(
+    GList *source_files, GFile *output_file, AutoarFormat format,
+    AutoarFilter filter, guint n_threads,
+    NautilusParallelCompressorProgressFunc progress_func, gpointer user_data,
+    GCancellable *cancellable, GError **error) {
+  g_autofree char *output_path = NULL;
+  g_autofree char *threads = NULL;
+  Compression compression = {0};
+  gboolean success = FALSE;
+  int fd;
+  GList *l;
+
+  g_return_val_if_fail(nautilus_parallel_compressor_is_supported(
+                           source_files, output_file, format, filter),
+                       FALSE);
+
+  output_path = g_file_get_path(output_file);
+  threads = g_strdup_printf("%u", MAX(n_threads, 1));
+
+  compression.progress_func = progress_func;
+  compression.user_data = user_data;
+  compression.cancellable = cancellable;
+  compression.buffer = g_malloc(BUFFER_SIZE);
+
+  compression.writer = archive_write_new();
+  archive_write_set_format_pax_restricted(compression.writer);
+  archive_write_add_filter_xz(compression.writer);
+  /* liblzma built without threads rejects the option and compresses on a
+   * single thread, which still makes a valid archive. */
+  if (archive_write_set_filter_option(compression.writer, "xz", "threads",
+                                      threads) != ARCHIVE_OK) {
+    DEBUG("Could not compress on %s threads: %s", threads,
+          archive_error_string(compression.writer));
+  }
+
+  compression.disk = archive_read_disk_new();
+  archive_read_disk_set_standard_lookup(compression.disk);
+  archive_read_disk_set_symlink_physical(compression.disk);
+
+  /* A file that appeared at the output path since it was chosen is left
+   * alone, so this fails instead */
+  fd = g_open(output_path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+  if (fd == -1) {
+    int saved_errno = errno;
+
+    g_set_error(error, G_IO_ERROR, g_io_error_from_errno(saved_errno),
+                "Could not create %s: %s", output_path,
+                g_strerror(saved_errno));
+    archive_read_free(compression.disk);
+    archive_write_free(compression.writer);
+    g_free(compression.buffer);
+
+    return FALSE;
+  }
+
+  if (archive_write_open_fd(compression.writer, fd) != ARCHIVE_OK) {
+    set_archive_error(compression.writer, error);
+    goto out;
+  }
+
+  for (l = source_files; l != NULL; l = l->next) {
+    if (!write_source(&compression, l->data, error)) {
+      goto out;
+    }
+  }
+
+  /* Flushes the blocks still being compressed */
+  if (archive_write_close(compression.writer) != ARCHIVE_OK) {
+    set_archive_error(compression.writer, error);
+    goto out;
+  }
+
+  notify_progress(&compression, TRUE);
+  success = TRUE;
+
+out:
+  archive_read_free(compression.disk);
+  archive_write_free(compression.writer);
+  g_free(compression.buffer);
+  close(fd);
+
+  /* Only the file created above is removed */
+  if (!success) {
+    g_unlink(output_path);
+  }
+
+  return success;
+}
@@ -0,0 +1,52 @@
+/* nautilus-parallel-compressor.h - Creates archives on several threads
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <gnome-autoar/gnome-autoar.h>
+
+G_BEGIN_DECLS
+
+/* AutoarCompressor runs its compression filter on the calling thread only.
+ * This writes the archive with libarchive directly instead, asking the
+ * filter to compress independent blocks on several threads, for the
+ * formats whose filter can do it. The archive is streamed to the output
+ * file as it is compressed, and is removed if anything goes wrong.
+ *
+ * It is only built when libarchive is found, which defines HAVE_LIBARCHIVE.
+ */
+
+typedef void (*NautilusParallelCompressorProgressFunc)(guint64 completed_size,
+                                                       guint completed_files,
+                                                       gpointer user_data);
+
+/* Whether @format and @filter can be compressed on several threads, and
+ * the files are local, as they are read with libarchive. */
+gboolean nautilus_parallel_compressor_is_supported(GList *source_files,
+                                                   GFile *output_file,
+                                                   AutoarFormat format,
+                                                   AutoarFilter filter);
+
+/* Blocks until the archive is written. @progress_func is called from the
+ * calling thread, about ten times per second. */
+gboolean nautilus_parallel_compressor_run(
+    GList *source_files, GFile *output_file, AutoarFormat format,
+    AutoarFilter filter, guint n_threads,
+    NautilusParallelCompressorProgressFunc progress_func, gpointer user_data,
+    GCancellable *cancellable, GError **error);
+
+G_END_DECLS
@@ -16,38 +16,18 @@
  *
  * Authors: William Jon McCann <mccann@jhu.edu>
  *
- * Can be profiled like so:
- *       strace -ttt -f -o /tmp/logfile.strace nautilus
- *       python plot-timeline.py -o prettygraph.png /tmp/logfile.strace
- *
- *       See: http://www.gnome.org/~federico/news-2006-03.html#09
+ * The markers are recorded as trace spans named after the function, see
+ * nautilus-trace.h for how to get them.
  */
 
 #pragma once
 
-#include <glib.h>
+#include "nautilus-trace.h"
 
 G_BEGIN_DECLS
 
-#ifdef ENABLE_PROFILING
-#ifdef G_HAVE_ISO_VARARGS
-#define nautilus_profile_start(...) _nautilus_profile_log (G_STRFUNC, "start", __VA_ARGS__)
-#define nautilus_profile_end(...)   _nautilus_profile_log (G_STRFUNC, "end", __VA_ARGS__)
-#define nautilus_profile_msg(...)   _nautilus_profile_log (NULL, NULL, __VA_ARGS__)
-#elif defined(G_HAVE_GNUC_VARARGS)
-#define nautilus_profile_start(format...) _nautilus_profile_log (G_STRFUNC, "start", format)
-#define nautilus_profile_end(format...)   _nautilus_profile_log (G_STRFUNC, "end", format)
-#define nautilus_profile_msg(format...)   _nautilus_profile_log (NULL, NULL, format)
-#endif
-#else
-#define nautilus_profile_start(...)
-#define nautilus_profile_end(...)
-#define nautilus_profile_msg(...)
-#endif
-
-void            _nautilus_profile_log    (const char *func,
-                                          const char *note,
-                                          const char *format,
-                                          ...) G_GNUC_PRINTF (3, 4);
+#define nautilus_profile_start(...) nautilus_trace_begin (G_STRFUNC, __VA_ARGS__)
+#define nautilus_profile_end(...)   nautilus_trace_end (G_STRFUNC, __VA_ARGS__)
+#define nautilus_profile_msg(...)   nautilus_trace_instant (G_STRFUNC, __VA_ARGS__)
 
-G_END_DECLS
\ No newline at end of file
+G_END_DECLS
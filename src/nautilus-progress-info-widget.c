@@ -24,6 +24,10 @@
 #include <config.h>
 
 #include "nautilus-progress-info-widget.h"
+
+#include <glib/gi18n.h>
+
+#include "nautilus-job-scheduler.h"
 struct _NautilusProgressInfoWidgetPrivate {
   NautilusProgressInfo *info;
 
@@ -32,6 +36,12 @@ struct _NautilusProgressInfoWidgetPrivate {
   GtkWidget *progress_bar;
   GtkWidget *button;
   GtkWidget *image;
+
+  /* Only shown while the operation is queued */
+  GtkWidget *queue_box;
+  GtkWidget *front_button;
+  GtkWidget *hold_button;
+  GtkWidget *hold_image;
 };
 
 enum { PROP_INFO = 1, NUM_PROPERTIES };
@@ -51,6 +61,24 @@ static void info_cancelled(NautilusProgressInfoWidget *self) {
   gtk_widget_set_sensitive(self->priv->button, FALSE);
 }
 
+static void update_queue_buttons(NautilusProgressInfoWidget *self) {
+  gboolean held;
+
+  if (!nautilus_job_scheduler_is_queued(self->priv->info)) {
+    gtk_widget_hide(self->priv->queue_box);
+    return;
+  }
+
+  held = nautilus_job_scheduler_is_held(self->priv->info);
+  gtk_image_set_from_icon_name(GTK_IMAGE(self->priv->hold_image),
+                               held ? "media-playback-start-symbolic"
+                                    : "media-playback-pause-symbolic",
+                               GTK_ICON_SIZE_BUTTON);
+  gtk_widget_set_tooltip_text(self->priv->hold_button,
+                              held ? _("Resume") : _("Pause"));
+  gtk_widget_show(self->priv->queue_box);
+}
+
 static void update_data(NautilusProgressInfoWidget *self) {
   char *status, *details;
   char *markup;
@@ -64,6 +92,8 @@ static void update_data(NautilusProgressInfoWidget *self) {
   gtk_label_set_markup(GTK_LABEL(self->priv->details), markup);
   g_free(details);
   g_free(markup);
+
+  update_queue_buttons(self);
 }
 
 static void update_progress(NautilusProgressInfoWidget *self) {
@@ -85,6 +115,17 @@ static void button_clicked(GtkWidget *button,
   }
 }
 
+static void front_button_clicked(GtkWidget *button,
+                                 NautilusProgressInfoWidget *self) {
+  nautilus_job_scheduler_move_to_front(self->priv->info);
+}
+
+static void hold_button_clicked(GtkWidget *button,
+                                NautilusProgressInfoWidget *self) {
+  nautilus_job_scheduler_set_held(
+      self->priv->info, !nautilus_job_scheduler_is_held(self->priv->info));
+}
+
 static void nautilus_progress_info_widget_dispose(GObject *obj) {
   NautilusProgressInfoWidget *self = NAUTILUS_PROGRESS_INFO_WIDGET(obj);
 
@@ -150,6 +191,10 @@ nautilus_progress_info_widget_init(NautilusProgressInfoWidget *self) {
 
   g_signal_connect(self->priv->button, "clicked", G_CALLBACK(button_clicked),
                    self);
+  g_signal_connect(self->priv->front_button, "clicked",
+                   G_CALLBACK(front_button_clicked), self);
+  g_signal_connect(self->priv->hold_button, "clicked",
+                   G_CALLBACK(hold_button_clicked), self);
 }
 
 static void nautilus_progress_info_widget_class_init(
@@ -184,6 +229,14 @@ static void nautilus_progress_info_widget_class_init(
       widget_class, NautilusProgressInfoWidget, button);
   gtk_widget_class_bind_template_child_private(
       widget_class, NautilusProgressInfoWidget, image);
+  gtk_widget_class_bind_template_child_private(
+      widget_class, NautilusProgressInfoWidget, queue_box);
+  gtk_widget_class_bind_template_child_private(
+      widget_class, NautilusProgressInfoWidget, front_button);
+  gtk_widget_class_bind_template_child_private(
+      widget_class, NautilusProgressInfoWidget, hold_button);
+  gtk_widget_class_bind_template_child_private(
+      widget_class, NautilusProgressInfoWidget, hold_image);
 }
 
 GtkWidget *nautilus_progress_info_widget_new(NautilusProgressInfo *info) {
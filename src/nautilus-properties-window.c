@@ -206,6 +206,7 @@ struct _NautilusPropertiesWindow {
   GList *permission_buttons;
   GList *permission_combos;
   GList *change_permission_combos;
+  GtkWidget *apply_ownership_check;
   GHashTable *initial_permissions;
   gboolean has_recursive_apply;
 
@@ -3202,13 +3203,18 @@ static void on_change_permissions_response(GtkDialog *dialog, int response,
   GtkTreeIter iter;
   PermissionType type;
   int new_perm, mask;
+  gboolean apply_ownership;
 
   if (response != GTK_RESPONSE_OK) {
     g_clear_pointer(&self->change_permission_combos, g_list_free);
+    self->apply_ownership_check = NULL;
     gtk_widget_destroy(GTK_WIDGET(dialog));
     return;
   }
 
+  apply_ownership = gtk_toggle_button_get_active(
+      GTK_TOGGLE_BUTTON(self->apply_ownership_check));
+
   file_permission = 0;
   file_permission_mask = 0;
   dir_permission = 0;
@@ -3265,10 +3271,14 @@ static void on_change_permissions_response(GtkDialog *dialog, int response,
       g_object_ref(self);
       nautilus_file_set_permissions_recursive(
           uri, file_permission, file_permission_mask, dir_permission,
-          dir_permission_mask, set_recursive_permissions_done, self);
+          dir_permission_mask,
+          apply_ownership ? nautilus_file_get_uid(file) : -1,
+          apply_ownership ? nautilus_file_get_gid(file) : -1,
+          set_recursive_permissions_done, self);
     }
   }
   g_clear_pointer(&self->change_permission_combos, g_list_free);
+  self->apply_ownership_check = NULL;
   gtk_widget_destroy(GTK_WIDGET(dialog));
 }
 
@@ -3391,6 +3401,9 @@ static void on_change_permissions_clicked(GtkWidget *button,
       g_list_prepend(self->change_permission_combos, combo);
   set_active_from_umask(combo, PERMISSION_OTHER, TRUE);
 
+  self->apply_ownership_check = GTK_WIDGET(gtk_builder_get_object(
+      change_permissions_builder, "apply_ownership_check"));
+
   g_signal_connect(dialog, "response",
                    G_CALLBACK(on_change_permissions_response), self);
   gtk_widget_show_all(dialog);
@@ -348,6 +348,31 @@ NautilusQuery *nautilus_query_new(void) {
   return g_object_new(NAUTILUS_TYPE_QUERY, NULL);
 }
 
+/* A snapshot of @query, which is not changed along with it. The MIME types
+ * and date range are shared, since they are never modified once set. */
+NautilusQuery *nautilus_query_copy(NautilusQuery *query) {
+  NautilusQuery *copy;
+
+  g_return_val_if_fail(NAUTILUS_IS_QUERY(query), NULL);
+
+  copy = nautilus_query_new();
+
+  copy->text = g_strdup(query->text);
+  g_set_object(&copy->location, query->location);
+  g_clear_pointer(&copy->mime_types, g_ptr_array_unref);
+  copy->mime_types = g_ptr_array_ref(query->mime_types);
+  copy->show_hidden = query->show_hidden;
+  if (query->date_range != NULL) {
+    copy->date_range = g_ptr_array_ref(query->date_range);
+  }
+  copy->recursive = query->recursive;
+  copy->search_type = query->search_type;
+  copy->search_content = query->search_content;
+  copy->searching = query->searching;
+
+  return copy;
+}
+
 char *nautilus_query_get_text(NautilusQuery *query) {
   g_return_val_if_fail(NAUTILUS_IS_QUERY(query), NULL);
 
@@ -550,6 +575,95 @@ void nautilus_query_set_recursive(NautilusQuery *query,
   }
 }
 
+static gboolean date_ranges_equal(GPtrArray *a, GPtrArray *b) {
+  guint i;
+
+  if (a == NULL || b == NULL) {
+    return a == b;
+  }
+
+  if (a->len != b->len) {
+    return FALSE;
+  }
+
+  for (i = 0; i < a->len; i++) {
+    if (!g_date_time_equal(g_ptr_array_index(a, i), g_ptr_array_index(b, i))) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+static gboolean mime_types_equal(GPtrArray *a, GPtrArray *b) {
+  guint i;
+
+  if (a->len != b->len) {
+    return FALSE;
+  }
+
+  for (i = 0; i < a->len; i++) {
+    if (g_strcmp0(g_ptr_array_index(a, i), g_ptr_array_index(b, i)) != 0) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/* Whether every file matching @query also matches @previous, so that the
+ * results of @query can be found among the results of @previous. That's the
+ * case when only the text changed, and each word of the previous text is
+ * part of a word of the new one, as when typing more letters. Content search
+ * is left out, since the indexer matches content on its own terms. */
+gboolean nautilus_query_is_refinement_of(NautilusQuery *query,
+                                         NautilusQuery *previous) {
+  g_autofree gchar *prepared_text = NULL;
+  g_autofree gchar *prepared_previous_text = NULL;
+  g_auto(GStrv) words = NULL;
+  g_auto(GStrv) previous_words = NULL;
+  gboolean found;
+  guint i, j;
+
+  g_return_val_if_fail(NAUTILUS_IS_QUERY(query), FALSE);
+  g_return_val_if_fail(NAUTILUS_IS_QUERY(previous), FALSE);
+
+  if (query->text == NULL || previous->text == NULL ||
+      g_strcmp0(query->text, previous->text) == 0) {
+    return FALSE;
+  }
+
+  if (query->location == NULL || previous->location == NULL ||
+      !g_file_equal(query->location, previous->location) ||
+      query->show_hidden != previous->show_hidden ||
+      query->recursive != previous->recursive ||
+      query->search_type != previous->search_type ||
+      query->search_content != NAUTILUS_QUERY_SEARCH_CONTENT_SIMPLE ||
+      previous->search_content != NAUTILUS_QUERY_SEARCH_CONTENT_SIMPLE ||
+      !mime_types_equal(query->mime_types, previous->mime_types) ||
+      !date_ranges_equal(query->date_range, previous->date_range)) {
+    return FALSE;
+  }
+
+  prepared_text = prepare_string_for_compare(query->text);
+  prepared_previous_text = prepare_string_for_compare(previous->text);
+  words = g_strsplit(prepared_text, " ", -1);
+  previous_words = g_strsplit(prepared_previous_text, " ", -1);
+
+  for (i = 0; previous_words[i] != NULL; i++) {
+    found = FALSE;
+    for (j = 0; words[j] != NULL && !found; j++) {
+      found = strstr(words[j], previous_words[i]) != NULL;
+    }
+
+    if (!found) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
 gboolean nautilus_query_is_empty(NautilusQuery *query) {
   if (!query) {
     return TRUE;
@@ -47,6 +47,7 @@ typedef enum {
 G_DECLARE_FINAL_TYPE(NautilusQuery, nautilus_query, NAUTILUS, QUERY, GObject)
 
 NautilusQuery *nautilus_query_new(void);
+NautilusQuery *nautilus_query_copy(NautilusQuery *query);
 
 char *nautilus_query_get_text(NautilusQuery *query);
 void nautilus_query_set_text(NautilusQuery *query, const char *text);
@@ -87,3 +88,6 @@ gdouble nautilus_query_matches_string(NautilusQuery *query,
 char *nautilus_query_to_readable_string(NautilusQuery *query);
 
 gboolean nautilus_query_is_empty(NautilusQuery *query);
+
+gboolean nautilus_query_is_refinement_of(NautilusQuery *query,
+                                         NautilusQuery *previous);
@@ -35,6 +35,11 @@
 #include "nautilus-search-engine.h"
 #include "nautilus-search-provider.h"
 
+/* Files are only made for this many hits at a time. Broad searches can find
+ * millions of files, and the rest of the hits are kept as they are until the
+ * user scrolls down to them. */
+#define SEARCH_RESULTS_PAGE_SIZE 5000
+
 struct _NautilusSearchDirectory
 {
     NautilusDirectory parent_instance;
@@ -61,8 +66,15 @@ struct _NautilusSearchDirectory
     gboolean search_ready_and_valid;
 
     GList *files;
+    /* Files shown, to the record of the hit they were made for */
     GHashTable *files_hash;
 
+    /* Records of the hits that didn't fit in the window of files shown */
+    GArray *hidden_hits;
+    /* Least relevant first, so that the next page is taken from the end */
+    gboolean hidden_hits_sorted;
+    guint window_size;
+
     GList *monitor_list;
     GList *callback_list;
     GList *pending_callback_list;
@@ -72,6 +84,14 @@ struct _NautilusSearchDirectory
     NautilusDirectory *base_model;
 };
 
+/* What is kept of a hit, which may be one of very many */
+typedef struct
+{
+    char *uri; /* Shared with the hit, see nautilus_search_hit_get_uri() */
+    gchar *fts_snippet; /* Only for full text matches */
+    gdouble relevance;
+} SearchHitRecord;
+
 typedef struct
 {
     gboolean monitor_hidden_files;
@@ -128,33 +148,43 @@ static void file_changed (NautilusFile            *file,
                           NautilusSearchDirectory *self);
 
 static void
-reset_file_list (NautilusSearchDirectory *self)
+remove_file_connections (NautilusSearchDirectory *self,
+                         NautilusFile            *file)
 {
-    GList *list, *monitor_list;
-    NautilusFile *file;
+    GList *monitor_list;
     SearchMonitor *monitor;
 
-    /* Remove file connections */
-    for (list = self->files; list != NULL; list = list->next)
+    /* Disconnect change handler */
+    g_signal_handlers_disconnect_by_func (file, file_changed, self);
+
+    /* Remove monitors */
+    for (monitor_list = self->monitor_list; monitor_list;
+         monitor_list = monitor_list->next)
     {
-        file = list->data;
+        monitor = monitor_list->data;
+        nautilus_file_monitor_remove (file, monitor);
+    }
+}
 
-        /* Disconnect change handler */
-        g_signal_handlers_disconnect_by_func (file, file_changed, self);
+static void
+reset_file_list (NautilusSearchDirectory *self)
+{
+    GList *list;
 
-        /* Remove monitors */
-        for (monitor_list = self->monitor_list; monitor_list;
-             monitor_list = monitor_list->next)
-        {
-            monitor = monitor_list->data;
-            nautilus_file_monitor_remove (file, monitor);
-        }
+    /* Remove file connections */
+    for (list = self->files; list != NULL; list = list->next)
+    {
+        remove_file_connections (self, list->data);
     }
 
     nautilus_file_list_free (self->files);
     self->files = NULL;
 
     g_hash_table_remove_all (self->files_hash);
+
+    g_array_set_size (self->hidden_hits, 0);
+    self->hidden_hits_sorted = TRUE;
+    self->window_size = SEARCH_RESULTS_PAGE_SIZE;
 }
 
 static void
@@ -601,6 +631,92 @@ on_search_directory_search_ready_and_valid (NautilusSearchDirectory *self)
     self->search_ready_and_valid = TRUE;
 }
 
+static void
+search_hit_record_init (SearchHitRecord   *record,
+                        NautilusSearchHit *hit)
+{
+    record->uri = g_ref_string_acquire ((char *) nautilus_search_hit_get_uri (hit));
+    record->fts_snippet = g_strdup (nautilus_search_hit_get_fts_snippet (hit));
+    record->relevance = nautilus_search_hit_get_relevance (hit);
+}
+
+static void
+search_hit_record_clear (SearchHitRecord *record)
+{
+    g_clear_pointer (&record->uri, g_ref_string_release);
+    g_clear_pointer (&record->fts_snippet, g_free);
+}
+
+static void
+search_hit_record_free (SearchHitRecord *record)
+{
+    search_hit_record_clear (record);
+    g_free (record);
+}
+
+static gint
+compare_records_by_relevance (gconstpointer a,
+                              gconstpointer b)
+{
+    const SearchHitRecord *record_a = a;
+    const SearchHitRecord *record_b = b;
+
+    /* Least relevant first */
+    return (record_a->relevance > record_b->relevance) -
+           (record_a->relevance < record_b->relevance);
+}
+
+/* Takes over the strings of @record */
+static NautilusFile *
+add_file_for_record (NautilusSearchDirectory *self,
+                     SearchHitRecord         *record)
+{
+    NautilusFile *file;
+    SearchMonitor *monitor;
+    GList *monitor_list;
+    SearchHitRecord *shown_record;
+
+    file = nautilus_file_get_by_uri (record->uri);
+    nautilus_file_set_search_relevance (file, record->relevance);
+    nautilus_file_set_search_fts_snippet (file, record->fts_snippet);
+
+    for (monitor_list = self->monitor_list; monitor_list; monitor_list = monitor_list->next)
+    {
+        monitor = monitor_list->data;
+
+        /* Add monitors */
+        nautilus_file_monitor_add (file, monitor, monitor->monitor_attributes);
+    }
+
+    g_signal_connect (file, "changed", G_CALLBACK (file_changed), self),
+
+    shown_record = g_new (SearchHitRecord, 1);
+    *shown_record = *record;
+    g_hash_table_insert (self->files_hash, file, shown_record);
+
+    return file;
+}
+
+static void
+emit_files_added (NautilusSearchDirectory *self,
+                  GList                   *file_list)
+{
+    NautilusFile *file;
+
+    self->files = g_list_concat (self->files, file_list);
+
+    if (file_list != NULL)
+    {
+        nautilus_directory_emit_files_added (NAUTILUS_DIRECTORY (self), file_list);
+    }
+
+    file = nautilus_directory_get_corresponding_file (NAUTILUS_DIRECTORY (self));
+    nautilus_file_emit_changed (file);
+    nautilus_file_unref (file);
+
+    search_directory_add_pending_files_callbacks (self);
+}
+
 static void
 search_engine_hits_added (NautilusSearchEngine    *engine,
                           GList                   *hits,
@@ -609,47 +725,91 @@ search_engine_hits_added (NautilusSearchEngine    *engine,
     GList *hit_list;
     GList *file_list;
     NautilusFile *file;
-    SearchMonitor *monitor;
-    GList *monitor_list;
+    guint n_files;
 
     file_list = NULL;
+    n_files = g_hash_table_size (self->files_hash);
 
     for (hit_list = hits; hit_list != NULL; hit_list = hit_list->next)
     {
         NautilusSearchHit *hit = hit_list->data;
-        const char *uri;
-
-        uri = nautilus_search_hit_get_uri (hit);
+        SearchHitRecord record;
 
         nautilus_search_hit_compute_scores (hit, self->query);
+        search_hit_record_init (&record, hit);
 
-        file = nautilus_file_get_by_uri (uri);
-        nautilus_file_set_search_relevance (file, nautilus_search_hit_get_relevance (hit));
-        nautilus_file_set_search_fts_snippet (file, nautilus_search_hit_get_fts_snippet (hit));
-
-        for (monitor_list = self->monitor_list; monitor_list; monitor_list = monitor_list->next)
+        if (n_files >= self->window_size)
         {
-            monitor = monitor_list->data;
-
-            /* Add monitors */
-            nautilus_file_monitor_add (file, monitor, monitor->monitor_attributes);
+            g_array_append_val (self->hidden_hits, record);
+            self->hidden_hits_sorted = FALSE;
+            continue;
         }
 
-        g_signal_connect (file, "changed", G_CALLBACK (file_changed), self),
-
+        file = add_file_for_record (self, &record);
         file_list = g_list_prepend (file_list, file);
-        g_hash_table_add (self->files_hash, file);
+        n_files++;
     }
 
-    self->files = g_list_concat (self->files, file_list);
+    emit_files_added (self, file_list);
+}
 
-    nautilus_directory_emit_files_added (NAUTILUS_DIRECTORY (self), file_list);
+static void
+sort_hidden_hits (NautilusSearchDirectory *self)
+{
+    if (!self->hidden_hits_sorted)
+    {
+        g_array_sort (self->hidden_hits, compare_records_by_relevance);
+        self->hidden_hits_sorted = TRUE;
+    }
+}
 
-    file = nautilus_directory_get_corresponding_file (NAUTILUS_DIRECTORY (self));
-    nautilus_file_emit_changed (file);
-    nautilus_file_unref (file);
+guint
+nautilus_search_directory_get_n_hidden_hits (NautilusSearchDirectory *self)
+{
+    g_return_val_if_fail (NAUTILUS_IS_SEARCH_DIRECTORY (self), 0);
 
-    search_directory_add_pending_files_callbacks (self);
+    return self->hidden_hits->len;
+}
+
+/* Makes files for the next page of the most relevant hits not shown yet */
+void
+nautilus_search_directory_show_more_hits (NautilusSearchDirectory *self)
+{
+    GList *file_list;
+    NautilusFile *file;
+    guint n_shown;
+    guint i;
+
+    g_return_if_fail (NAUTILUS_IS_SEARCH_DIRECTORY (self));
+
+    if (self->hidden_hits->len == 0)
+    {
+        return;
+    }
+
+    self->window_size += SEARCH_RESULTS_PAGE_SIZE;
+
+    sort_hidden_hits (self);
+
+    /* The records at the end are the most relevant, and are taken over by
+     * the files, so dropping them from the array costs nothing */
+    n_shown = MIN (SEARCH_RESULTS_PAGE_SIZE, self->hidden_hits->len);
+    file_list = NULL;
+    for (i = 0; i < n_shown; i++)
+    {
+        SearchHitRecord *record;
+
+        record = &g_array_index (self->hidden_hits, SearchHitRecord,
+                                 self->hidden_hits->len - 1 - i);
+        file = add_file_for_record (self, record);
+        file_list = g_list_prepend (file_list, file);
+        record->uri = NULL;
+        record->fts_snippet = NULL;
+    }
+
+    g_array_set_size (self->hidden_hits, self->hidden_hits->len - n_shown);
+
+    emit_files_added (self, file_list);
 }
 
 static void
@@ -666,6 +826,97 @@ search_engine_error (NautilusSearchEngine    *engine,
     g_error_free (error);
 }
 
+static gint
+compare_files_by_record_relevance (gconstpointer a,
+                                   gconstpointer b,
+                                   gpointer      user_data)
+{
+    GHashTable *files_hash = user_data;
+
+    /* Least relevant first */
+    return compare_records_by_relevance (g_hash_table_lookup (files_hash, *(NautilusFile **) a),
+                                         g_hash_table_lookup (files_hash, *(NautilusFile **) b));
+}
+
+/* The window is filled in the order the hits come in, so that they are shown
+ * as soon as they are found. Once they are all in, this swaps the least
+ * relevant files shown for the most relevant hits left out, if any. */
+static void
+show_most_relevant_hits (NautilusSearchDirectory *self)
+{
+    g_autoptr (GPtrArray) shown = NULL;
+    GList *added = NULL;
+    GList *removed = NULL;
+    GList *l;
+    guint i;
+
+    if (self->hidden_hits->len == 0)
+    {
+        return;
+    }
+
+    sort_hidden_hits (self);
+
+    shown = g_ptr_array_sized_new (g_hash_table_size (self->files_hash));
+    for (l = self->files; l != NULL; l = l->next)
+    {
+        g_ptr_array_add (shown, l->data);
+    }
+    g_ptr_array_sort_with_data (shown, compare_files_by_record_relevance, self->files_hash);
+
+    for (i = 0; i < shown->len && i < self->hidden_hits->len; i++)
+    {
+        NautilusFile *file = g_ptr_array_index (shown, i);
+        SearchHitRecord *hidden_record;
+        SearchHitRecord *shown_record;
+        SearchHitRecord record;
+
+        hidden_record = &g_array_index (self->hidden_hits, SearchHitRecord,
+                                        self->hidden_hits->len - 1 - i);
+        shown_record = g_hash_table_lookup (self->files_hash, file);
+        if (hidden_record->relevance <= shown_record->relevance)
+        {
+            break;
+        }
+
+        /* The record of the file taken out is hidden in place of this one */
+        record = *hidden_record;
+        *hidden_record = *shown_record;
+        shown_record->uri = NULL;
+        shown_record->fts_snippet = NULL;
+        remove_file_connections (self, file);
+        g_hash_table_remove (self->files_hash, file);
+        removed = g_list_prepend (removed, file);
+
+        added = g_list_prepend (added, add_file_for_record (self, &record));
+    }
+
+    if (removed == NULL)
+    {
+        return;
+    }
+
+    /* The records swapped in are less relevant than the ones left */
+    self->hidden_hits_sorted = FALSE;
+
+    for (l = self->files; l != NULL;)
+    {
+        GList *next = l->next;
+
+        if (!g_hash_table_contains (self->files_hash, l->data))
+        {
+            self->files = g_list_delete_link (self->files, l);
+        }
+        l = next;
+    }
+
+    /* The files no longer in the directory are taken out of the views */
+    nautilus_directory_emit_files_changed (NAUTILUS_DIRECTORY (self), removed);
+    nautilus_file_list_free (removed);
+
+    emit_files_added (self, added);
+}
+
 static void
 search_engine_finished (NautilusSearchEngine         *engine,
                         NautilusSearchProviderStatus  status,
@@ -681,6 +932,7 @@ search_engine_finished (NautilusSearchEngine         *engine,
      * happening. */
     if (status == NAUTILUS_SEARCH_PROVIDER_STATUS_NORMAL)
     {
+        show_most_relevant_hits (self);
         on_search_directory_search_ready_and_valid (self);
         nautilus_directory_emit_done_loading (NAUTILUS_DIRECTORY (self));
     }
@@ -921,6 +1173,7 @@ search_finalize (GObject *object)
     self = NAUTILUS_SEARCH_DIRECTORY (object);
 
     g_hash_table_destroy (self->files_hash);
+    g_array_unref (self->hidden_hits);
 
     G_OBJECT_CLASS (nautilus_search_directory_parent_class)->finalize (object);
 }
@@ -929,7 +1182,12 @@ static void
 nautilus_search_directory_init (NautilusSearchDirectory *self)
 {
     self->query = NULL;
-    self->files_hash = g_hash_table_new (g_direct_hash, g_direct_equal);
+    self->files_hash = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                              NULL, (GDestroyNotify) search_hit_record_free);
+    self->hidden_hits = g_array_new (FALSE, FALSE, sizeof (SearchHitRecord));
+    g_array_set_clear_func (self->hidden_hits, (GDestroyNotify) search_hit_record_clear);
+    self->hidden_hits_sorted = TRUE;
+    self->window_size = SEARCH_RESULTS_PAGE_SIZE;
 
     self->engine = nautilus_search_engine_new ();
     search_connect_engine (self);
@@ -41,3 +41,6 @@ NautilusDirectory *
                nautilus_search_directory_get_base_model (NautilusSearchDirectory  *self);
 void           nautilus_search_directory_set_base_model (NautilusSearchDirectory  *self,
 							 NautilusDirectory        *base_model);
+
+guint          nautilus_search_directory_get_n_hidden_hits (NautilusSearchDirectory *self);
+void           nautilus_search_directory_show_more_hits    (NautilusSearchDirectory *self);
@@ -178,6 +178,7 @@ static void cursor_callback(GObject *object, GAsyncResult *result,
 
   hit = nautilus_search_hit_new(uri);
   match = nautilus_query_matches_string(tracker->query, basename);
+  nautilus_search_hit_set_fts_base_rank(hit, rank);
   nautilus_search_hit_set_fts_rank(hit, rank + match);
   g_free(basename);
 
@@ -32,13 +32,35 @@
 #include "nautilus-search-engine-simple.h"
 #include "nautilus-search-engine-tracker.h"
 
+/* Results older than this are not reused for a narrower query */
+#define REFINEMENT_MAX_AGE (30 * G_USEC_PER_SEC)
+/* Nor are results of searches this broad, to not hold on to their memory */
+#define REFINEMENT_MAX_HITS 50000
+
 typedef struct {
   NautilusSearchEngineTracker *tracker;
   NautilusSearchEngineRecent *recent;
   NautilusSearchEngineSimple *simple;
   NautilusSearchEngineModel *model;
 
-  GHashTable *uris;
+  NautilusQuery *query;
+
+  /* Hits of the current search by URI, the URIs being owned by the hits.
+   * Once a search over all the providers completes, they are kept together
+   * with its query, so that a narrower query can be answered from them. */
+  GHashTable *hits;
+  /* Past REFINEMENT_MAX_HITS the search can't be refined anyway, so only the
+   * URIs are kept, to not report a hit twice. They are shared with the hits,
+   * which are #GRefStrings. */
+  GHashTable *overflow_uris;
+  /* A copy of the query, which the caller may change in place */
+  NautilusQuery *hits_query;
+  /* When the providers last ran, which a refinement doesn't change */
+  gint64 hits_time;
+  guint refine_id;
+  gboolean refined;
+  gboolean all_providers;
+
   guint providers_running;
   guint providers_finished;
   guint providers_error;
@@ -69,6 +91,8 @@ static void nautilus_search_engine_set_query(NautilusSearchProvider *provider,
   engine = NAUTILUS_SEARCH_ENGINE(provider);
   priv = nautilus_search_engine_get_instance_private(engine);
 
+  g_set_object(&priv->query, query);
+
   nautilus_search_provider_set_query(NAUTILUS_SEARCH_PROVIDER(priv->tracker),
                                      query);
   nautilus_search_provider_set_query(NAUTILUS_SEARCH_PROVIDER(priv->recent),
@@ -132,10 +156,122 @@ static void search_engine_start_real_simple(NautilusSearchEngine *engine) {
   nautilus_search_provider_start(NAUTILUS_SEARCH_PROVIDER(priv->simple));
 }
 
+static void check_providers_status(NautilusSearchEngine *engine);
+
+static void forget_hits(NautilusSearchEngine *engine) {
+  NautilusSearchEnginePrivate *priv;
+
+  priv = nautilus_search_engine_get_instance_private(engine);
+
+  g_hash_table_remove_all(priv->hits);
+  g_hash_table_remove_all(priv->overflow_uris);
+  g_clear_object(&priv->hits_query);
+}
+
+static void drop_hit_objects(NautilusSearchEngine *engine) {
+  NautilusSearchEnginePrivate *priv;
+  GHashTableIter iter;
+  const char *uri;
+
+  priv = nautilus_search_engine_get_instance_private(engine);
+
+  DEBUG("Search engine found more than %u hits, not keeping them",
+        REFINEMENT_MAX_HITS);
+
+  g_hash_table_iter_init(&iter, priv->hits);
+  while (g_hash_table_iter_next(&iter, (gpointer *)&uri, NULL)) {
+    g_hash_table_add(priv->overflow_uris, g_ref_string_acquire((char *)uri));
+  }
+  g_hash_table_remove_all(priv->hits);
+}
+
+static gboolean hits_overflowed(NautilusSearchEnginePrivate *priv) {
+  return g_hash_table_size(priv->overflow_uris) > 0;
+}
+
+static gboolean can_refine_hits(NautilusSearchEngine *engine) {
+  NautilusSearchEnginePrivate *priv;
+
+  priv = nautilus_search_engine_get_instance_private(engine);
+
+  return priv->hits_query != NULL && priv->query != NULL &&
+         g_get_monotonic_time() - priv->hits_time < REFINEMENT_MAX_AGE &&
+         nautilus_query_is_refinement_of(priv->query, priv->hits_query);
+}
+
+/* Keeps the hits of the previous search that match the new query, and
+ * reports them as if they had been found again. */
+static gboolean refine_hits_idle(gpointer user_data) {
+  NautilusSearchEngine *engine = user_data;
+  NautilusSearchEnginePrivate *priv;
+  GHashTableIter iter;
+  NautilusSearchHit *hit;
+  GList *kept = NULL;
+  gdouble match;
+
+  priv = nautilus_search_engine_get_instance_private(engine);
+  priv->refine_id = 0;
+
+  g_clear_object(&priv->hits_query);
+
+  g_hash_table_iter_init(&iter, priv->hits);
+  while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&hit)) {
+    g_autoptr(GFile) location = NULL;
+    g_autofree gchar *basename = NULL;
+
+    location = g_file_new_for_uri(nautilus_search_hit_get_uri(hit));
+    basename = g_file_get_basename(location);
+    match = nautilus_query_matches_string(priv->query, basename);
+    if (match == -1) {
+      g_hash_table_iter_remove(&iter);
+      continue;
+    }
+
+    /* As the providers do, on top of their own relevance */
+    nautilus_search_hit_set_fts_rank(
+        hit, nautilus_search_hit_get_fts_base_rank(hit) + match);
+    kept = g_list_prepend(kept, hit);
+  }
+
+  DEBUG("Search engine refined the previous results to %u hits",
+        g_hash_table_size(priv->hits));
+
+  if (kept != NULL && priv->running && !priv->restart) {
+    nautilus_search_provider_hits_added(NAUTILUS_SEARCH_PROVIDER(engine),
+                                        kept);
+  }
+  g_list_free(kept);
+
+  priv->providers_finished++;
+  check_providers_status(engine);
+
+  return G_SOURCE_REMOVE;
+}
+
 static void search_engine_start_real(NautilusSearchEngine *engine,
                                      NautilusSearchEngineTarget target_engine) {
+  NautilusSearchEnginePrivate *priv;
+
+  priv = nautilus_search_engine_get_instance_private(engine);
+
   search_engine_start_real_setup(engine);
 
+  /* Typing more letters narrows the search, and the new results are among
+   * the ones already found, so there's no need to query all the providers
+   * and crawl again. */
+  priv->all_providers = target_engine == NAUTILUS_SEARCH_ENGINE_ALL_ENGINES;
+  priv->refined = priv->all_providers && can_refine_hits(engine);
+
+  if (priv->refined) {
+    DEBUG("Search engine refining the previous results");
+
+    priv->providers_running++;
+    priv->refine_id = g_idle_add(refine_hits_idle, engine);
+    return;
+  }
+
+  forget_hits(engine);
+
   switch (target_engine) {
   case NAUTILUS_SEARCH_ENGINE_TRACKER_ENGINE: {
     search_engine_start_real_tracker(engine);
@@ -264,15 +400,24 @@ static void search_provider_hits_added(NautilusSearchProvider *provider,
 
   for (l = hits; l != NULL; l = l->next) {
     NautilusSearchHit *hit = l->data;
-    int count;
     const char *uri;
 
     uri = nautilus_search_hit_get_uri(hit);
-    count = GPOINTER_TO_INT(g_hash_table_lookup(priv->uris, uri));
-    if (count == 0) {
-      added = g_list_prepend(added, hit);
+    if (hits_overflowed(priv)) {
+      if (g_hash_table_contains(priv->overflow_uris, uri)) {
+        continue;
+      }
+      g_hash_table_add(priv->overflow_uris, g_ref_string_acquire((char *)uri));
+    } else {
+      if (g_hash_table_contains(priv->hits, uri)) {
+        continue;
+      }
+      g_hash_table_insert(priv->hits, (gpointer)uri, g_object_ref(hit));
+      if (g_hash_table_size(priv->hits) > REFINEMENT_MAX_HITS) {
+        drop_hit_objects(engine);
+      }
     }
-    g_hash_table_replace(priv->uris, g_strdup(uri), GINT_TO_POINTER(++count));
+    added = g_list_prepend(added, hit);
   }
   if (added != NULL) {
     added = g_list_reverse(added);
@@ -310,11 +455,22 @@ static void check_providers_status(NautilusSearchEngine *engine) {
                       : NAUTILUS_SEARCH_PROVIDER_STATUS_NORMAL);
   }
 
+  /* Only a search that ran to its end over all the providers has all the
+   * hits a narrower query can be answered from */
+  if (priv->running && !priv->restart && priv->providers_error == 0 &&
+      priv->all_providers && !hits_overflowed(priv)) {
+    g_clear_object(&priv->hits_query);
+    priv->hits_query = nautilus_query_copy(priv->query);
+    if (!priv->refined) {
+      priv->hits_time = g_get_monotonic_time();
+    }
+  } else {
+    forget_hits(engine);
+  }
+
   priv->running = FALSE;
   g_object_notify(G_OBJECT(engine), "running");
 
-  g_hash_table_remove_all(priv->uris);
-
   if (priv->restart) {
     nautilus_search_engine_start(NAUTILUS_SEARCH_PROVIDER(engine));
   }
@@ -384,7 +540,11 @@ static void nautilus_search_engine_finalize(GObject *object) {
   engine = NAUTILUS_SEARCH_ENGINE(object);
   priv = nautilus_search_engine_get_instance_private(engine);
 
-  g_hash_table_destroy(priv->uris);
+  g_clear_handle_id(&priv->refine_id, g_source_remove);
+  g_hash_table_destroy(priv->hits);
+  g_hash_table_destroy(priv->overflow_uris);
+  g_clear_object(&priv->hits_query);
+  g_clear_object(&priv->query);
 
   g_clear_object(&priv->tracker);
   g_clear_object(&priv->recent);
@@ -431,7 +591,11 @@ static void nautilus_search_engine_init(NautilusSearchEngine *engine) {
   NautilusSearchEnginePrivate *priv;
 
   priv = nautilus_search_engine_get_instance_private(engine);
-  priv->uris = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  priv->hits =
+      g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_object_unref);
+  priv->overflow_uris =
+      g_hash_table_new_full(g_str_hash, g_str_equal,
+                            (GDestroyNotify)g_ref_string_release, NULL);
 
   priv->tracker = nautilus_search_engine_tracker_new();
   connect_provider_signals(engine, NAUTILUS_SEARCH_PROVIDER(priv->tracker));
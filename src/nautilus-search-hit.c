@@ -30,12 +30,13 @@
 struct _NautilusSearchHit {
   GObject parent_instance;
 
-  char *uri;
+  char *uri; /* A GRefString */
 
   GDateTime *modification_time;
   GDateTime *access_time;
   GDateTime *creation_time;
   gdouble fts_rank;
+  gdouble fts_base_rank;
   gchar *fts_snippet;
 
   gdouble relevance;
@@ -141,14 +142,23 @@ const gchar *nautilus_search_hit_get_fts_snippet(NautilusSearchHit *hit) {
 
 static void nautilus_search_hit_set_uri(NautilusSearchHit *hit,
                                         const char *uri) {
-  g_free(hit->uri);
-  hit->uri = g_strdup(uri);
+  g_clear_pointer(&hit->uri, g_ref_string_release);
+  hit->uri = uri != NULL ? g_ref_string_new(uri) : NULL;
 }
 
 void nautilus_search_hit_set_fts_rank(NautilusSearchHit *hit, gdouble rank) {
   hit->fts_rank = rank;
 }
 
+void nautilus_search_hit_set_fts_base_rank(NautilusSearchHit *hit,
+                                           gdouble base_rank) {
+  hit->fts_base_rank = base_rank;
+}
+
+gdouble nautilus_search_hit_get_fts_base_rank(NautilusSearchHit *hit) {
+  return hit->fts_base_rank;
+}
+
 void nautilus_search_hit_set_modification_time(NautilusSearchHit *hit,
                                                GDateTime *date) {
   if (hit->modification_time != NULL) {
@@ -279,7 +289,7 @@ static void nautilus_search_hit_get_property(GObject *object, guint arg_id,
 static void nautilus_search_hit_finalize(GObject *object) {
   NautilusSearchHit *hit = NAUTILUS_SEARCH_HIT(object);
 
-  g_free(hit->uri);
+  g_clear_pointer(&hit->uri, g_ref_string_release);
 
   if (hit->access_time != NULL) {
     g_date_time_unref(hit->access_time);
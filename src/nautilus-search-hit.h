@@ -32,6 +32,12 @@ G_DECLARE_FINAL_TYPE(NautilusSearchHit, nautilus_search_hit, NAUTILUS,
 NautilusSearchHit *nautilus_search_hit_new(const char *uri);
 
 void nautilus_search_hit_set_fts_rank(NautilusSearchHit *hit, gdouble fts_rank);
+/* The part of the rank that does not depend on the name, such as the full
+ * text relevance, which is kept when the rank is computed again for a
+ * narrower query. */
+void nautilus_search_hit_set_fts_base_rank(NautilusSearchHit *hit,
+                                           gdouble base_rank);
+gdouble nautilus_search_hit_get_fts_base_rank(NautilusSearchHit *hit);
 void nautilus_search_hit_set_modification_time(NautilusSearchHit *hit,
                                                GDateTime *date);
 void nautilus_search_hit_set_access_time(NautilusSearchHit *hit,
@@ -43,6 +49,8 @@ void nautilus_search_hit_set_fts_snippet(NautilusSearchHit *hit,
 void nautilus_search_hit_compute_scores(NautilusSearchHit *hit,
                                         NautilusQuery *query);
 
+/* The URI is a #GRefString, so that whoever keeps it after the hit is gone
+ * can share it with g_ref_string_acquire() rather than copy it. */
 const char *nautilus_search_hit_get_uri(NautilusSearchHit *hit);
 gdouble nautilus_search_hit_get_relevance(NautilusSearchHit *hit);
 const gchar *nautilus_search_hit_get_fts_snippet(NautilusSearchHit *hit);
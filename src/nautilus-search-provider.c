@@ -19,6 +19,7 @@
 #include <config.h>
 #include "nautilus-search-provider.h"
 #include "nautilus-enum-types.h"
+#include "nautilus-trace.h"
 
 #include <glib-object.h>
 
@@ -94,6 +95,7 @@ nautilus_search_provider_start (NautilusSearchProvider *provider)
     g_return_if_fail (NAUTILUS_IS_SEARCH_PROVIDER (provider));
     g_return_if_fail (NAUTILUS_SEARCH_PROVIDER_GET_IFACE (provider)->start != NULL);
 
+    nautilus_trace_async_begin (G_OBJECT_TYPE_NAME (provider), provider, NULL);
     NAUTILUS_SEARCH_PROVIDER_GET_IFACE (provider)->start (provider);
 }
 
@@ -112,6 +114,8 @@ nautilus_search_provider_hits_added (NautilusSearchProvider *provider,
 {
     g_return_if_fail (NAUTILUS_IS_SEARCH_PROVIDER (provider));
 
+    nautilus_trace_instant (G_OBJECT_TYPE_NAME (provider), "%u hits",
+                            g_list_length (hits));
     g_signal_emit (provider, signals[HITS_ADDED], 0, hits);
 }
 
@@ -121,6 +125,7 @@ nautilus_search_provider_finished (NautilusSearchProvider       *provider,
 {
     g_return_if_fail (NAUTILUS_IS_SEARCH_PROVIDER (provider));
 
+    nautilus_trace_async_end (G_OBJECT_TYPE_NAME (provider), provider, NULL);
     g_signal_emit (provider, signals[FINISHED], 0, status);
 }
 
@@ -0,0 +1,137 @@
+/* nautilus-statistics.c - Counters describing what Nautilus is busy with
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "nautilus-statistics.h"
+
+#include "nautilus-directory-private.h"
+#include "nautilus-file-changes-queue.h"
+#include "nautilus-file.h"
+#include "nautilus-job-scheduler.h"
+#include "nautilus-progress-info-manager.h"
+#include "nautilus-progress-info.h"
+#include "nautilus-thumbnail-cache.h"
+#include "nautilus-thumbnails.h"
+
+static const guint64 latency_buckets[] = NAUTILUS_STATISTICS_LATENCY_BUCKETS;
+
+#define N_LATENCY_BUCKETS (G_N_ELEMENTS(latency_buckets) + 1)
+
+static guint64 directory_load_latencies[N_LATENCY_BUCKETS];
+
+static void add_latency(guint64 *histogram, gint64 duration_usec) {
+  guint64 duration_ms;
+  guint i;
+
+  duration_ms = MAX(duration_usec, 0) / 1000;
+  for (i = 0; i < G_N_ELEMENTS(latency_buckets); i++) {
+    if (duration_ms <= latency_buckets[i]) {
+      break;
+    }
+  }
+
+  histogram[i]++;
+}
+
+void nautilus_statistics_add_directory_load(gint64 duration_usec) {
+  add_latency(directory_load_latencies, duration_usec);
+}
+
+static GVariant *get_histogram(guint64 *histogram) {
+  GVariantBuilder builder;
+  guint i;
+
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a(tt)"));
+  for (i = 0; i < N_LATENCY_BUCKETS; i++) {
+    g_variant_builder_add(&builder, "(tt)",
+                          i < G_N_ELEMENTS(latency_buckets) ? latency_buckets[i]
+                                                            : G_MAXUINT64,
+                          histogram[i]);
+  }
+
+  return g_variant_builder_end(&builder);
+}
+
+static void add_counter(GVariantBuilder *builder, const char *name,
+                        gint64 value) {
+  g_variant_builder_add(builder, "{sv}", name, g_variant_new_int64(value));
+}
+
+static void add_progress_counters(GVariantBuilder *builder) {
+  g_autoptr(NautilusProgressInfoManager) manager = NULL;
+  NautilusProgressInfo *info;
+  GList *l;
+  gint64 running = 0;
+  gint64 paused = 0;
+
+  manager = nautilus_progress_info_manager_dup_singleton();
+  for (l = nautilus_progress_info_manager_get_all_infos(manager); l != NULL;
+       l = l->next) {
+    info = l->data;
+    if (nautilus_progress_info_get_is_finished(info) ||
+        nautilus_progress_info_get_is_cancelled(info)) {
+      continue;
+    }
+
+    if (nautilus_progress_info_get_is_paused(info)) {
+      paused++;
+    } else {
+      running++;
+    }
+  }
+
+  add_counter(builder, "file-operations-running", running);
+  add_counter(builder, "file-operations-paused", paused);
+  add_counter(builder, "file-operations-queued",
+              nautilus_job_scheduler_get_n_queued());
+}
+
+GVariant *nautilus_statistics_get(void) {
+  NautilusThumbnailCacheStatistics thumbnail_cache;
+  GVariantBuilder builder;
+  guint async_jobs_running;
+  guint async_jobs_waiting;
+
+  g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+
+  nautilus_directory_get_async_job_counts(&async_jobs_running,
+                                          &async_jobs_waiting);
+  add_counter(&builder, "async-jobs-running", async_jobs_running);
+  add_counter(&builder, "directories-waiting-for-async-jobs",
+              async_jobs_waiting);
+
+  add_counter(&builder, "thumbnails-to-make",
+              nautilus_thumbnail_get_queue_length());
+  add_counter(&builder, "file-changes-queued",
+              nautilus_file_changes_queue_get_length());
+  add_progress_counters(&builder);
+
+  nautilus_thumbnail_cache_get_statistics(&thumbnail_cache);
+  add_counter(&builder, "thumbnail-cache-entries", thumbnail_cache.n_entries);
+  add_counter(&builder, "thumbnail-cache-bytes", thumbnail_cache.size);
+  add_counter(&builder, "thumbnail-cache-budget-bytes", thumbnail_cache.budget);
+  add_counter(&builder, "thumbnail-cache-hits", thumbnail_cache.hits);
+  add_counter(&builder, "thumbnail-cache-misses", thumbnail_cache.misses);
+  add_counter(&builder, "thumbnail-cache-evictions", thumbnail_cache.evictions);
+
+  add_counter(&builder, "files-alive", nautilus_file_get_n_alive());
+
+  g_variant_builder_add(&builder, "{sv}", "directory-load-latency",
+                        get_histogram(directory_load_latencies));
+
+  return g_variant_builder_end(&builder);
+}
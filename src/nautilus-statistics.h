@@ -0,0 +1,38 @@
+/* nautilus-statistics.h - Counters describing what Nautilus is busy with
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+/* Gathers the queue depths, jobs in flight, cache use and latencies of the
+ * running instance, for the org.gnome.Nautilus.Statistics D-Bus interface.
+ * Counters are kept by the code they describe and only read here, except
+ * for the latency histograms, which are recorded through this module.
+ * Must only be used from the main thread.
+ */
+
+/* Upper bounds of the latency histogram buckets, in milliseconds. Latencies
+ * above the last one go to an extra bucket. */
+#define NAUTILUS_STATISTICS_LATENCY_BUCKETS                                    \
+  { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000 }
+
+void nautilus_statistics_add_directory_load(gint64 duration_usec);
+
+/* Returns a floating a{sv}. Counters are "x" values, and histograms are
+ * "a(tt)" lists of bucket upper bounds in milliseconds, with G_MAXUINT64 for
+ * the last one, and counts. */
+GVariant *nautilus_statistics_get(void);
@@ -0,0 +1,157 @@
+/* nautilus-stats.c - Prints the statistics of the running Nautilus
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <gio/gio.h>
+#include <stdlib.h>
+
+static gboolean watch;
+static gint interval = 1;
+
+static GOptionEntry entries[] = {
+    {"watch", 'w', 0, G_OPTION_ARG_NONE, &watch,
+     "Print the statistics again every interval", NULL},
+    {"interval", 'i', 0, G_OPTION_ARG_INT, &interval,
+     "Seconds between two prints with --watch", "SECONDS"},
+    {NULL}};
+
+static void print_histogram(const char *name, GVariant *histogram) {
+  GVariantIter iter;
+  guint64 bound;
+  guint64 count;
+  guint64 total;
+
+  total = 0;
+  g_variant_iter_init(&iter, histogram);
+  while (g_variant_iter_next(&iter, "(tt)", &bound, &count)) {
+    total += count;
+  }
+
+  g_print("%s (%" G_GUINT64_FORMAT "):\n", name, total);
+
+  g_variant_iter_init(&iter, histogram);
+  while (g_variant_iter_next(&iter, "(tt)", &bound, &count)) {
+    if (count == 0) {
+      continue;
+    }
+
+    if (bound == G_MAXUINT64) {
+      g_print("  %10s ms  %" G_GUINT64_FORMAT "\n", "more", count);
+    } else {
+      g_print("  <= %7" G_GUINT64_FORMAT " ms  %" G_GUINT64_FORMAT "\n",
+              bound, count);
+    }
+  }
+}
+
+static void print_statistics(GVariant *statistics) {
+  g_autofree const char **keys = NULL;
+  g_autoptr(GVariantDict) dict = NULL;
+  GPtrArray *names;
+  GVariantIter iter;
+  const char *key;
+  guint i;
+
+  dict = g_variant_dict_new(statistics);
+  names = g_ptr_array_new();
+
+  g_variant_iter_init(&iter, statistics);
+  while (g_variant_iter_next(&iter, "{&sv}", &key, NULL)) {
+    g_ptr_array_add(names, (gpointer)key);
+  }
+  g_ptr_array_sort(names, (GCompareFunc)g_strcmp0);
+  g_ptr_array_add(names, NULL);
+  keys = (const char **)g_ptr_array_free(names, FALSE);
+
+  /* Counters first, then the histograms which take several lines */
+  for (i = 0; keys[i] != NULL; i++) {
+    g_autoptr(GVariant) value = NULL;
+
+    value = g_variant_dict_lookup_value(dict, keys[i], G_VARIANT_TYPE_INT64);
+    if (value != NULL) {
+      g_print("%-40s %" G_GINT64_FORMAT "\n", keys[i],
+              g_variant_get_int64(value));
+    }
+  }
+
+  for (i = 0; keys[i] != NULL; i++) {
+    g_autoptr(GVariant) value = NULL;
+
+    value = g_variant_dict_lookup_value(dict, keys[i], G_VARIANT_TYPE("a(tt)"));
+    if (value != NULL) {
+      g_print("\n");
+      print_histogram(keys[i], value);
+    }
+  }
+}
+
+static gboolean get_statistics(GDBusConnection *connection, GError **error) {
+  g_autoptr(GVariant) reply = NULL;
+  g_autoptr(GVariant) statistics = NULL;
+
+  reply = g_dbus_connection_call_sync(
+      connection, APPLICATION_ID, "/org/gnome/Nautilus" PROFILE "/Statistics",
+      "org.gnome.Nautilus.Statistics", "GetStatistics", NULL,
+      G_VARIANT_TYPE("(a{sv})"), G_DBUS_CALL_FLAGS_NO_AUTO_START, -1, NULL,
+      error);
+  if (reply == NULL) {
+    return FALSE;
+  }
+
+  g_variant_get(reply, "(@a{sv})", &statistics);
+  print_statistics(statistics);
+
+  return TRUE;
+}
+
+int main(int argc, char *argv[]) {
+  g_autoptr(GOptionContext) context = NULL;
+  g_autoptr(GDBusConnection) connection = NULL;
+  g_autoptr(GError) error = NULL;
+
+  context = g_option_context_new(NULL);
+  g_option_context_set_summary(
+      context, "Prints the counters of the running Nautilus instance.");
+  g_option_context_add_main_entries(context, entries, NULL);
+  if (!g_option_context_parse(context, &argc, &argv, &error)) {
+    g_printerr("%s\n", error->message);
+    return EXIT_FAILURE;
+  }
+
+  connection = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, &error);
+  if (connection == NULL) {
+    g_printerr("Could not connect to the session bus: %s\n", error->message);
+    return EXIT_FAILURE;
+  }
+
+  while (TRUE) {
+    if (!get_statistics(connection, &error)) {
+      g_printerr("Could not get the statistics of Nautilus: %s\n",
+                 error->message);
+      return EXIT_FAILURE;
+    }
+
+    if (!watch) {
+      break;
+    }
+
+    g_usleep(MAX(interval, 1) * G_USEC_PER_SEC);
+    g_print("\n");
+  }
+
+  return EXIT_SUCCESS;
+}
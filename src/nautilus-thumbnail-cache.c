@@ -0,0 +1,212 @@
+/* nautilus-thumbnail-cache.c - Process-wide cache of thumbnail pixbufs
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "nautilus-thumbnail-cache.h"
+
+#define DEBUG_FLAG NAUTILUS_DEBUG_THUMBNAILS
+#include "nautilus-debug.h"
+
+/* Used until the preference is read */
+#define DEFAULT_BUDGET (256 * 1024 * 1024)
+
+typedef struct {
+  /* Position in the LRU queue, with the entry as data */
+  GList link;
+  guint handle;
+
+  GdkPixbuf *pixbuf;
+  GdkPixbuf *scaled_pixbuf;
+  double scale;
+
+  gsize size;
+} CacheEntry;
+
+static GHashTable *entries;
+/* Most recently used first */
+static GQueue lru = G_QUEUE_INIT;
+static guint last_handle;
+
+static gsize size;
+static gsize budget = DEFAULT_BUDGET;
+
+static guint64 hits;
+static guint64 misses;
+static guint64 evictions;
+
+static gsize get_pixbuf_size(GdkPixbuf *pixbuf) {
+  if (pixbuf == NULL) {
+    return 0;
+  }
+
+  return gdk_pixbuf_get_byte_length(pixbuf);
+}
+
+static void cache_entry_free(CacheEntry *entry) {
+  g_clear_object(&entry->pixbuf);
+  g_clear_object(&entry->scaled_pixbuf);
+  g_free(entry);
+}
+
+static CacheEntry *get_entry(guint handle) {
+  if (entries == NULL || handle == 0) {
+    return NULL;
+  }
+
+  return g_hash_table_lookup(entries, GUINT_TO_POINTER(handle));
+}
+
+static void mark_used(CacheEntry *entry) {
+  g_queue_unlink(&lru, &entry->link);
+  g_queue_push_head_link(&lru, &entry->link);
+}
+
+static void drop_entry(CacheEntry *entry) {
+  g_queue_unlink(&lru, &entry->link);
+  size -= entry->size;
+  /* Frees the entry */
+  g_hash_table_remove(entries, GUINT_TO_POINTER(entry->handle));
+}
+
+static void log_statistics(void) {
+  DEBUG("Thumbnail cache: %u entries, %" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT
+        " bytes, %" G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT
+        " misses, %" G_GUINT64_FORMAT " evictions",
+        lru.length, size, budget, hits, misses, evictions);
+}
+
+/* Drops the least recently used entries until the cache fits in its budget.
+ * The most recently used entry is always kept, so that a thumbnail that is
+ * bigger than the whole budget can still be shown. */
+static void trim(void) {
+  gboolean evicted = FALSE;
+
+  while (size > budget && lru.length > 1) {
+    drop_entry(lru.tail->data);
+    evictions++;
+    evicted = TRUE;
+  }
+
+  if (evicted) {
+    log_statistics();
+  }
+}
+
+guint nautilus_thumbnail_cache_insert(GdkPixbuf *pixbuf) {
+  CacheEntry *entry;
+
+  g_return_val_if_fail(GDK_IS_PIXBUF(pixbuf), 0);
+
+  if (entries == NULL) {
+    entries = g_hash_table_new_full(NULL, NULL, NULL,
+                                    (GDestroyNotify)cache_entry_free);
+  }
+
+  /* Skip 0 and handles still in use after wrapping around */
+  do {
+    last_handle++;
+  } while (last_handle == 0 ||
+           g_hash_table_contains(entries, GUINT_TO_POINTER(last_handle)));
+
+  entry = g_new0(CacheEntry, 1);
+  entry->link.data = entry;
+  entry->handle = last_handle;
+  entry->pixbuf = g_object_ref(pixbuf);
+  entry->size = get_pixbuf_size(pixbuf);
+
+  g_hash_table_insert(entries, GUINT_TO_POINTER(entry->handle), entry);
+  g_queue_push_head_link(&lru, &entry->link);
+  size += entry->size;
+
+  trim();
+
+  return entry->handle;
+}
+
+void nautilus_thumbnail_cache_remove(guint handle) {
+  CacheEntry *entry;
+
+  entry = get_entry(handle);
+  if (entry != NULL) {
+    drop_entry(entry);
+  }
+}
+
+GdkPixbuf *nautilus_thumbnail_cache_lookup(guint handle) {
+  CacheEntry *entry;
+
+  entry = get_entry(handle);
+  if (entry == NULL) {
+    misses++;
+    return NULL;
+  }
+
+  hits++;
+  mark_used(entry);
+
+  return g_object_ref(entry->pixbuf);
+}
+
+GdkPixbuf *nautilus_thumbnail_cache_lookup_scaled(guint handle, double scale) {
+  CacheEntry *entry;
+
+  entry = get_entry(handle);
+  if (entry == NULL || entry->scaled_pixbuf == NULL || entry->scale != scale) {
+    return NULL;
+  }
+
+  return g_object_ref(entry->scaled_pixbuf);
+}
+
+void nautilus_thumbnail_cache_set_scaled(guint handle, GdkPixbuf *scaled,
+                                         double scale) {
+  CacheEntry *entry;
+
+  g_return_if_fail(GDK_IS_PIXBUF(scaled));
+
+  entry = get_entry(handle);
+  if (entry == NULL) {
+    return;
+  }
+
+  size -= get_pixbuf_size(entry->scaled_pixbuf);
+  g_set_object(&entry->scaled_pixbuf, scaled);
+  entry->scale = scale;
+
+  entry->size = get_pixbuf_size(entry->pixbuf) + get_pixbuf_size(scaled);
+  size += get_pixbuf_size(scaled);
+
+  mark_used(entry);
+  trim();
+}
+
+void nautilus_thumbnail_cache_set_budget(gsize new_budget) {
+  budget = new_budget;
+  trim();
+}
+
+void nautilus_thumbnail_cache_get_statistics(
+    NautilusThumbnailCacheStatistics *statistics) {
+  g_return_if_fail(statistics != NULL);
+
+  statistics->hits = hits;
+  statistics->misses = misses;
+  statistics->evictions = evictions;
+  statistics->n_entries = lru.length;
+  statistics->size = size;
+  statistics->budget = budget;
+}
@@ -0,0 +1,50 @@
+/* nautilus-thumbnail-cache.h - Process-wide cache of thumbnail pixbufs
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+/* Files keep a handle to their thumbnail instead of the pixbuf itself. The
+ * decoded thumbnails, together with the last scaled copy made for display,
+ * share a byte budget, and the least recently used ones are dropped once it
+ * is exceeded. A dropped thumbnail is simply loaded again from the thumbnail
+ * file when it is needed. Must only be used from the main thread.
+ */
+
+typedef struct {
+  guint64 hits;
+  guint64 misses;
+  guint64 evictions;
+  guint n_entries;
+  gsize size;
+  gsize budget;
+} NautilusThumbnailCacheStatistics;
+
+/* Returns a handle for @pixbuf, which is never 0. */
+guint nautilus_thumbnail_cache_insert(GdkPixbuf *pixbuf);
+void nautilus_thumbnail_cache_remove(guint handle);
+
+/* These return a new reference, or NULL if the thumbnail was dropped. */
+GdkPixbuf *nautilus_thumbnail_cache_lookup(guint handle);
+GdkPixbuf *nautilus_thumbnail_cache_lookup_scaled(guint handle, double scale);
+
+void nautilus_thumbnail_cache_set_scaled(guint handle, GdkPixbuf *scaled,
+                                         double scale);
+
+void nautilus_thumbnail_cache_set_budget(gsize budget);
+void nautilus_thumbnail_cache_get_statistics(
+    NautilusThumbnailCacheStatistics *statistics);
@@ -28,6 +28,7 @@
 #include "nautilus-directory-notify.h"
 #include "nautilus-global-preferences.h"
 #include "nautilus-file-utilities.h"
+#include "nautilus-trace.h"
 #include <math.h>
 #include <eel/eel-graphic-effects.h>
 #include <eel/eel-string.h>
@@ -237,6 +238,18 @@ nautilus_thumbnail_prioritize (const char *file_uri)
     g_mutex_unlock (&thumbnails_mutex);
 }
 
+guint
+nautilus_thumbnail_get_queue_length (void)
+{
+    guint length;
+
+    g_mutex_lock (&thumbnails_mutex);
+    length = g_queue_get_length ((GQueue *) &thumbnails_to_make);
+    g_mutex_unlock (&thumbnails_mutex);
+
+    return length;
+}
+
 
 /***************************************************************************
  * Thumbnail Thread Functions.
@@ -527,6 +540,7 @@ thumbnail_thread_func (GTask        *task,
         DEBUG ("(Thumbnail Thread) Creating thumbnail: %s\n",
                info->image_uri);
 
+        nautilus_trace_begin ("thumbnail generation", "%s", info->mime_type);
         pixbuf = gnome_desktop_thumbnail_factory_generate_thumbnail (thumbnail_factory,
                                                                      info->image_uri,
                                                                      info->mime_type);
@@ -551,6 +565,8 @@ thumbnail_thread_func (GTask        *task,
                                                                      info->image_uri,
                                                                      current_orig_mtime);
         }
+        nautilus_trace_end ("thumbnail generation", NULL);
+
         /* We need to call nautilus_file_changed(), but I don't think that is
          *  thread safe. So add an idle handler and do it from the main loop. */
         g_idle_add_full (G_PRIORITY_HIGH_IDLE,
@@ -0,0 +1,282 @@
+/* nautilus-trace.c - Timestamped spans and counters for profiling
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "nautilus-trace.h"
+
+#include <stdarg.h>
+#include <unistd.h>
+
+/* About 300 kB per running thread that recorded something */
+#define EVENTS_PER_THREAD 4096
+/* Of the threads that exited, the most recent events kept */
+#define MAX_RETIRED_EVENTS (4 * EVENTS_PER_THREAD)
+#define DETAIL_SIZE 48
+
+typedef struct {
+  gint64 time;
+  const char *name;
+  /* The value of a counter, or the id of an async span */
+  gint64 id;
+  char phase;
+  char detail[DETAIL_SIZE];
+} TraceEvent;
+
+typedef struct {
+  guint tid;
+  /* Only written by the thread owning the buffer. The last
+   * EVENTS_PER_THREAD of the events recorded so far are kept. */
+  gint n_events;
+  TraceEvent events[EVENTS_PER_THREAD];
+} ThreadBuffer;
+
+/* The events a thread had recorded when it exited */
+typedef struct {
+  guint tid;
+  guint n_events;
+  TraceEvent events[];
+} RetiredBuffer;
+
+gboolean _nautilus_trace_enabled;
+
+static void retire_thread_buffer(gpointer data);
+
+static GPrivate thread_buffer = G_PRIVATE_INIT(retire_thread_buffer);
+static GMutex buffers_mutex;
+static GPtrArray *buffers;
+static GPtrArray *retired_buffers;
+static guint n_retired_events;
+static guint last_tid;
+static gint64 start_time;
+
+static ThreadBuffer *get_thread_buffer(void) {
+  ThreadBuffer *buffer;
+
+  buffer = g_private_get(&thread_buffer);
+  if (G_LIKELY(buffer != NULL)) {
+    return buffer;
+  }
+
+  buffer = g_new0(ThreadBuffer, 1);
+
+  g_mutex_lock(&buffers_mutex);
+  if (buffers == NULL) {
+    buffers = g_ptr_array_new();
+  }
+  buffer->tid = ++last_tid;
+  g_ptr_array_add(buffers, buffer);
+  g_mutex_unlock(&buffers_mutex);
+
+  g_private_set(&thread_buffer, buffer);
+
+  return buffer;
+}
+
+/* A thread's ring buffer is freed when it exits, but its events are still
+ * written: they are moved to a buffer of their size, and dropped oldest
+ * first past MAX_RETIRED_EVENTS, so that short lived threads add up to
+ * little. */
+static void retire_thread_buffer(gpointer data) {
+  ThreadBuffer *buffer = data;
+  RetiredBuffer *retired;
+  guint n_events, first, j;
+
+  n_events = (guint)g_atomic_int_get(&buffer->n_events);
+  first = n_events > EVENTS_PER_THREAD ? n_events - EVENTS_PER_THREAD : 0;
+
+  retired = g_malloc(sizeof(RetiredBuffer) +
+                     (n_events - first) * sizeof(TraceEvent));
+  retired->tid = buffer->tid;
+  retired->n_events = n_events - first;
+  for (j = first; j < n_events; j++) {
+    retired->events[j - first] = buffer->events[j % EVENTS_PER_THREAD];
+  }
+
+  g_mutex_lock(&buffers_mutex);
+  g_ptr_array_remove_fast(buffers, buffer);
+  if (retired_buffers == NULL) {
+    retired_buffers = g_ptr_array_new_with_free_func(g_free);
+  }
+  g_ptr_array_add(retired_buffers, retired);
+  n_retired_events += retired->n_events;
+  while (n_retired_events > MAX_RETIRED_EVENTS) {
+    retired = g_ptr_array_index(retired_buffers, 0);
+    n_retired_events -= retired->n_events;
+    g_ptr_array_remove_index(retired_buffers, 0);
+  }
+  g_mutex_unlock(&buffers_mutex);
+
+  g_free(buffer);
+}
+
+void _nautilus_trace_record(char phase, const char *name, gint64 id,
+                            const char *format, ...) {
+  ThreadBuffer *buffer;
+  TraceEvent *event;
+  va_list args;
+  gint n_events;
+
+  buffer = get_thread_buffer();
+  n_events = g_atomic_int_get(&buffer->n_events);
+  event = &buffer->events[(guint)n_events % EVENTS_PER_THREAD];
+
+  event->time = g_get_monotonic_time();
+  event->name = name;
+  event->id = id;
+  event->phase = phase;
+  if (format != NULL) {
+    va_start(args, format);
+    g_vsnprintf(event->detail, DETAIL_SIZE, format, args);
+    va_end(args);
+  } else {
+    event->detail[0] = '\0';
+  }
+
+  /* Publishes the event to the writer */
+  g_atomic_int_set(&buffer->n_events, n_events + 1);
+}
+
+void nautilus_trace_set_enabled(gboolean enabled) {
+  if (enabled && start_time == 0) {
+    start_time = g_get_monotonic_time();
+  }
+
+  _nautilus_trace_enabled = enabled;
+}
+
+void nautilus_trace_init(void) {
+#ifdef ENABLE_PROFILING
+  if (g_getenv("NAUTILUS_TRACE") != NULL) {
+    nautilus_trace_set_enabled(TRUE);
+  }
+#endif
+}
+
+static void append_json_string(GString *json, const char *str) {
+  g_autofree char *valid = NULL;
+  const char *p;
+
+  /* The detail may have been cut in the middle of a character */
+  valid = g_utf8_make_valid(str, -1);
+
+  g_string_append_c(json, '"');
+  for (p = valid; *p != '\0'; p++) {
+    if (*p == '"' || *p == '\\') {
+      g_string_append_c(json, '\\');
+      g_string_append_c(json, *p);
+    } else if ((guchar)*p < 0x20) {
+      g_string_append_printf(json, "\\u%04x", (guchar)*p);
+    } else {
+      g_string_append_c(json, *p);
+    }
+  }
+  g_string_append_c(json, '"');
+}
+
+static void append_event(GString *json, guint tid, TraceEvent *event) {
+  g_string_append(json, "{\"name\":");
+  append_json_string(json, event->name != NULL ? event->name : "");
+  g_string_append_printf(json,
+                         ",\"cat\":\"nautilus\",\"ph\":\"%c\""
+                         ",\"ts\":%" G_GINT64_FORMAT ",\"pid\":%d,\"tid\":%u",
+                         event->phase, event->time - start_time, (int)getpid(),
+                         tid);
+
+  switch (event->phase) {
+  case 'C':
+    g_string_append_printf(json, ",\"args\":{\"value\":%" G_GINT64_FORMAT "}",
+                           event->id);
+    return;
+  case 'b':
+  case 'e':
+    g_string_append_printf(json, ",\"id\":\"0x%" G_GINT64_MODIFIER "x\"",
+                           event->id);
+    break;
+  case 'i':
+    g_string_append(json, ",\"s\":\"t\"");
+    break;
+  default:
+    break;
+  }
+
+  if (event->detail[0] != '\0') {
+    g_string_append(json, ",\"args\":{\"detail\":");
+    append_json_string(json, event->detail);
+    g_string_append_c(json, '}');
+  }
+  g_string_append_c(json, '}');
+}
+
+/* Events being recorded by other threads while this runs may come out
+ * garbled, so this is best called once they are idle. */
+gboolean nautilus_trace_write(const char *filename, GError **error) {
+  g_autoptr(GString) json = NULL;
+  ThreadBuffer *buffer;
+  gboolean first;
+  guint i;
+  guint n_events, j;
+
+  json = g_string_new("{\"traceEvents\":[\n");
+  first = TRUE;
+
+  g_mutex_lock(&buffers_mutex);
+  for (i = 0; buffers != NULL && i < buffers->len; i++) {
+    buffer = g_ptr_array_index(buffers, i);
+    n_events = (guint)g_atomic_int_get(&buffer->n_events);
+
+    j = n_events > EVENTS_PER_THREAD ? n_events - EVENTS_PER_THREAD : 0;
+    for (; j < n_events; j++) {
+      if (!first) {
+        g_string_append(json, ",\n");
+      }
+      first = FALSE;
+      append_event(json, buffer->tid,
+                   &buffer->events[j % EVENTS_PER_THREAD]);
+    }
+  }
+  for (i = 0; retired_buffers != NULL && i < retired_buffers->len; i++) {
+    RetiredBuffer *retired = g_ptr_array_index(retired_buffers, i);
+
+    for (j = 0; j < retired->n_events; j++) {
+      if (!first) {
+        g_string_append(json, ",\n");
+      }
+      first = FALSE;
+      append_event(json, retired->tid, &retired->events[j]);
+    }
+  }
+  g_mutex_unlock(&buffers_mutex);
+
+  g_string_append(json, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  return g_file_set_contents(filename, json->str, json->len, error);
+}
+
+void nautilus_trace_shutdown(void) {
+  g_autoptr(GError) error = NULL;
+  const char *filename;
+
+  filename = g_getenv("NAUTILUS_TRACE");
+  if (!_nautilus_trace_enabled || filename == NULL) {
+    return;
+  }
+
+  _nautilus_trace_enabled = FALSE;
+  if (!nautilus_trace_write(filename, &error)) {
+    g_warning("Could not write the trace to %s: %s", filename, error->message);
+  }
+}
@@ -0,0 +1,79 @@
+/* nautilus-trace.h - Timestamped spans and counters for profiling
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Trace points are compiled in with -Dprofiling=true, and do nothing until
+ * tracing is turned on by setting NAUTILUS_TRACE to a file name. Each thread
+ * then records its events in its own ring buffer, allocated with its first
+ * event, and from then on without locking nor allocating. Only the most
+ * recent events are kept, and a thread's buffer is shrunk to the events it
+ * holds when the thread exits. The buffers are written to that file on exit,
+ * in the Chrome trace event format, which chrome://tracing and Perfetto can
+ * show.
+ *
+ * Names must be static strings, as only the pointer is kept. The optional
+ * printf-style detail is truncated to a few dozen bytes.
+ */
+
+extern gboolean _nautilus_trace_enabled;
+
+#ifdef ENABLE_PROFILING
+#define NAUTILUS_TRACE(phase, name, id, ...)                                   \
+  G_STMT_START {                                                               \
+    if (G_UNLIKELY(_nautilus_trace_enabled)) {                                 \
+      _nautilus_trace_record(phase, name, id, __VA_ARGS__);                    \
+    }                                                                          \
+  }                                                                            \
+  G_STMT_END
+#else
+#define NAUTILUS_TRACE(phase, name, id, ...)                                   \
+  G_STMT_START {}                                                              \
+  G_STMT_END
+#endif
+
+/* A span that starts and ends on the same thread */
+#define nautilus_trace_begin(name, ...)                                        \
+  NAUTILUS_TRACE('B', name, 0, __VA_ARGS__)
+#define nautilus_trace_end(name, ...)                                          \
+  NAUTILUS_TRACE('E', name, 0, __VA_ARGS__)
+/* A span that ends in a callback or on another thread, told apart from the
+ * other ones with the same name by @id, usually the address of its state */
+#define nautilus_trace_async_begin(name, id, ...)                              \
+  NAUTILUS_TRACE('b', name, (gint64)GPOINTER_TO_SIZE(id), __VA_ARGS__)
+#define nautilus_trace_async_end(name, id, ...)                                \
+  NAUTILUS_TRACE('e', name, (gint64)GPOINTER_TO_SIZE(id), __VA_ARGS__)
+#define nautilus_trace_instant(name, ...)                                      \
+  NAUTILUS_TRACE('i', name, 0, __VA_ARGS__)
+#define nautilus_trace_counter(name, value)                                    \
+  NAUTILUS_TRACE('C', name, value, NULL)
+
+/* Turns tracing on if NAUTILUS_TRACE is set. */
+void nautilus_trace_init(void);
+/* Writes the trace to the NAUTILUS_TRACE file, if tracing is on. */
+void nautilus_trace_shutdown(void);
+
+void nautilus_trace_set_enabled(gboolean enabled);
+gboolean nautilus_trace_write(const char *filename, GError **error);
+
+void _nautilus_trace_record(char phase, const char *name, gint64 id,
+                            const char *format, ...) G_GNUC_PRINTF(4, 5);
+
+G_END_DECLS
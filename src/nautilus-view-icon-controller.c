@@ -4,7 +4,6 @@
 #include "nautilus-files-view.h"
 #include "nautilus-global-preferences.h"
 #include "nautilus-metadata.h"
-#include "nautilus-thumbnails.h"
 #include "nautilus-view-icon-item-ui.h"
 #include "nautilus-view-item-model.h"
 #include "nautilus-view-model.h"
@@ -1075,9 +1074,8 @@ static void prioritize_thumbnailing_on_idle(NautilusViewIconController *self) {
     g_return_if_fail(item != NULL);
 
     file = nautilus_view_item_model_get_file(NAUTILUS_VIEW_ITEM_MODEL(item));
-    if (file != NULL && nautilus_file_is_thumbnailing(file)) {
-      g_autofree gchar *uri = nautilus_file_get_uri(file);
-      nautilus_thumbnail_prioritize(uri);
+    if (file != NULL) {
+      nautilus_file_prioritize_io(file);
     }
   }
 }
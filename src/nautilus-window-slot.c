@@ -26,6 +26,7 @@
 #include "nautilus-application.h"
 #include "nautilus-bookmark-list.h"
 #include "nautilus-bookmark.h"
+#include "nautilus-directory.h"
 #include "nautilus-mime-actions.h"
 #include "nautilus-places-view.h"
 #include "nautilus-query-editor.h"
@@ -50,6 +51,11 @@
 #include <eel/eel-vfs-extensions.h>
 #include <nautilus-extension.h>
 
+/* Wait for the selection and the view to settle before guessing
+ * where the user goes next, in milliseconds */
+#define PREFETCH_DELAY 300
+#define MAX_PREFETCHED_DIRECTORIES 4
+
 enum {
   PROP_ACTIVE = 1,
   PROP_WINDOW,
@@ -142,6 +148,10 @@ struct _NautilusWindowSlot {
   GBinding *templates_menu_binding;
   gboolean searching;
   GList *selection;
+
+  /* Directories loaded ahead of time, in case they're visited next */
+  GList *prefetched_directories;
+  guint prefetch_timeout_id;
 };
 
 G_DEFINE_TYPE(NautilusWindowSlot, nautilus_window_slot, GTK_TYPE_BOX);
@@ -598,16 +608,147 @@ nautilus_window_slot_add_extra_location_widget(NautilusWindowSlot *self,
   gtk_widget_show(self->extra_location_widgets);
 }
 
+static void schedule_prefetch(NautilusWindowSlot *self);
+
 static void nautilus_window_slot_set_searching(NautilusWindowSlot *self,
                                                gboolean searching) {
+  gboolean was_searching = self->searching;
+
   self->searching = searching;
   g_object_notify_by_pspec(G_OBJECT(self), properties[PROP_SEARCHING]);
+
+  if (searching) {
+    g_clear_handle_id(&self->prefetch_timeout_id, g_source_remove);
+  } else if (was_searching) {
+    schedule_prefetch(self);
+  }
+}
+
+static gboolean is_prefetch_target(GList *targets,
+                                   NautilusDirectory *directory) {
+  GFile *location;
+  GList *l;
+
+  location = nautilus_directory_get_location(directory);
+  for (l = targets; l != NULL; l = l->next) {
+    if (g_file_equal(l->data, location)) {
+      g_object_unref(location);
+      return TRUE;
+    }
+  }
+  g_object_unref(location);
+
+  return FALSE;
+}
+
+/* Drops the prefetched directories that aren't in @targets, a list of
+ * GFile. */
+static void stop_prefetching(NautilusWindowSlot *self, GList *targets) {
+  NautilusDirectory *directory;
+  GList *l, *next;
+
+  for (l = self->prefetched_directories; l != NULL; l = next) {
+    next = l->next;
+    directory = l->data;
+
+    if (!is_prefetch_target(targets, directory)) {
+      nautilus_directory_file_monitor_remove(directory, self);
+      nautilus_directory_unref(directory);
+      self->prefetched_directories =
+          g_list_delete_link(self->prefetched_directories, l);
+    }
+  }
+}
+
+static void prefetch_location(NautilusWindowSlot *self, GFile *location) {
+  NautilusDirectory *directory;
+
+  /* Only local folders are cheap enough to read just in case */
+  if (location == NULL || !g_file_is_native(location) ||
+      (self->location != NULL && g_file_equal(location, self->location)) ||
+      g_list_length(self->prefetched_directories) >=
+          MAX_PREFETCHED_DIRECTORIES) {
+    return;
+  }
+
+  directory = nautilus_directory_get(location);
+  if (g_list_find(self->prefetched_directories, directory) != NULL) {
+    nautilus_directory_unref(directory);
+    return;
+  }
+
+  nautilus_directory_file_monitor_add(directory, self, TRUE,
+                                      NAUTILUS_FILE_ATTRIBUTE_INFO, NULL, NULL);
+  self->prefetched_directories =
+      g_list_prepend(self->prefetched_directories, directory);
+}
+
+/* The likeliest next locations first: the selected folder, then the parent
+ * folder and the neighbours in the history. */
+static GList *get_prefetch_targets(NautilusWindowSlot *self) {
+  NautilusFile *file;
+  GList *targets;
+
+  targets = NULL;
+
+  if (self->selection != NULL && self->selection->next == NULL) {
+    file = NAUTILUS_FILE(self->selection->data);
+    if (nautilus_file_is_directory(file)) {
+      targets = g_list_prepend(targets, nautilus_file_get_location(file));
+    }
+  }
+
+  if (self->location != NULL && g_file_has_parent(self->location, NULL)) {
+    targets = g_list_prepend(targets, g_file_get_parent(self->location));
+  }
+
+  if (self->back_list != NULL) {
+    targets = g_list_prepend(
+        targets, nautilus_bookmark_get_location(self->back_list->data));
+  }
+
+  if (self->forward_list != NULL) {
+    targets = g_list_prepend(
+        targets, nautilus_bookmark_get_location(self->forward_list->data));
+  }
+
+  return g_list_reverse(targets);
+}
+
+static gboolean prefetch_timeout_callback(gpointer user_data) {
+  NautilusWindowSlot *self;
+  GList *targets, *l;
+
+  self = NAUTILUS_WINDOW_SLOT(user_data);
+  self->prefetch_timeout_id = 0;
+
+  /* Never compete with the location being shown, nor with a search */
+  if (self->allow_stop || self->searching) {
+    return G_SOURCE_REMOVE;
+  }
+
+  targets = get_prefetch_targets(self);
+  stop_prefetching(self, targets);
+  for (l = targets; l != NULL; l = l->next) {
+    prefetch_location(self, l->data);
+  }
+  g_list_free_full(targets, g_object_unref);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void schedule_prefetch(NautilusWindowSlot *self) {
+  g_clear_handle_id(&self->prefetch_timeout_id, g_source_remove);
+  self->prefetch_timeout_id =
+      g_timeout_add(PREFETCH_DELAY, prefetch_timeout_callback, self);
 }
 
 static void nautilus_window_slot_set_selection(NautilusWindowSlot *self,
                                                GList *selection) {
   self->selection = selection;
   g_object_notify_by_pspec(G_OBJECT(self), properties[PROP_SELECTION]);
+
+  schedule_prefetch(self);
 }
 
 static void real_set_extensions_background_menu(NautilusWindowSlot *self,
@@ -1091,6 +1232,8 @@ static void begin_location_change(NautilusWindowSlot *self, GFile *location,
                                   GList *new_selection,
                                   NautilusLocationChangeType type,
                                   guint distance, const char *scroll_pos) {
+  GList *targets;
+
   g_assert(self != NULL);
   g_assert(location != NULL);
   g_assert(type == NAUTILUS_LOCATION_CHANGE_BACK ||
@@ -1106,6 +1249,13 @@ static void begin_location_change(NautilusWindowSlot *self, GFile *location,
 
   nautilus_window_slot_set_allow_stop(self, TRUE);
 
+  /* A prefetched directory is only worth keeping if it's the one that is
+   * going to be shown. */
+  g_clear_handle_id(&self->prefetch_timeout_id, g_source_remove);
+  targets = g_list_prepend(NULL, location);
+  stop_prefetching(self, targets);
+  g_list_free(targets);
+
   new_selection = check_select_old_location_containing_folder(
       new_selection, location, previous_location);
 
@@ -2262,6 +2412,8 @@ static void view_ended_loading(NautilusWindowSlot *self, NautilusView *view) {
   nautilus_window_slot_set_allow_stop(self, FALSE);
 
   nautilus_window_slot_set_loading(self, FALSE);
+
+  schedule_prefetch(self);
 }
 
 static void view_is_loading_changed_cb(GObject *object, GParamSpec *pspec,
@@ -2450,6 +2602,9 @@ static void nautilus_window_slot_dispose(GObject *object) {
   nautilus_window_slot_clear_forward_list(self);
   nautilus_window_slot_clear_back_list(self);
 
+  g_clear_handle_id(&self->prefetch_timeout_id, g_source_remove);
+  stop_prefetching(self, NULL);
+
   nautilus_window_slot_remove_extra_location_widgets(self);
 
   g_clear_pointer(&self->searching_binding, g_binding_unbind);
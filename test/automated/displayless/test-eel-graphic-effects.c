@@ -0,0 +1,173 @@
+#include <glib.h>
+
+#include "eel/eel-graphic-effects.h"
+
+/* Odd widths, so that both the vectorized part of a row and the bytes left
+ * at its end are covered */
+#define WIDTH 37
+#define HEIGHT 3
+
+static GdkPixbuf *
+create_test_pixbuf (gboolean has_alpha)
+{
+    GdkPixbuf *pixbuf;
+    guchar *pixels;
+    int n_channels, rowstride;
+    int x, y, c;
+
+    pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, has_alpha, 8, WIDTH, HEIGHT);
+    pixels = gdk_pixbuf_get_pixels (pixbuf);
+    n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+    rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+    for (y = 0; y < HEIGHT; y++)
+    {
+        for (x = 0; x < WIDTH; x++)
+        {
+            for (c = 0; c < n_channels; c++)
+            {
+                pixels[y * rowstride + x * n_channels + c] = (x * 13 + y * 61 + c * 97) & 0xff;
+            }
+        }
+    }
+
+    return pixbuf;
+}
+
+static void
+check_spotlight (gboolean has_alpha)
+{
+    g_autoptr (GdkPixbuf) src = create_test_pixbuf (has_alpha);
+    g_autoptr (GdkPixbuf) dest = NULL;
+    guchar *src_pixels, *dest_pixels;
+    int n_channels, rowstride;
+    int x, y, c;
+    int expected;
+
+    dest = eel_create_spotlight_pixbuf (src);
+    src_pixels = gdk_pixbuf_get_pixels (src);
+    dest_pixels = gdk_pixbuf_get_pixels (dest);
+    n_channels = gdk_pixbuf_get_n_channels (src);
+    rowstride = gdk_pixbuf_get_rowstride (src);
+
+    for (y = 0; y < HEIGHT; y++)
+    {
+        for (x = 0; x < WIDTH; x++)
+        {
+            for (c = 0; c < n_channels; c++)
+            {
+                int offset = y * rowstride + x * n_channels + c;
+
+                expected = c == 3 ? src_pixels[offset] : MIN (src_pixels[offset] + 15, 255);
+                g_assert_cmpint (dest_pixels[offset], ==, expected);
+            }
+        }
+    }
+}
+
+static void
+test_spotlight_pixbuf (void)
+{
+    check_spotlight (TRUE);
+    check_spotlight (FALSE);
+}
+
+static void
+test_spotlight_pixbuf_is_reused (void)
+{
+    g_autoptr (GdkPixbuf) src = create_test_pixbuf (TRUE);
+    g_autoptr (GdkPixbuf) first = NULL;
+    g_autoptr (GdkPixbuf) second = NULL;
+
+    first = eel_get_spotlight_pixbuf (src);
+    second = eel_get_spotlight_pixbuf (src);
+
+    g_assert_true (first == second);
+}
+
+static void
+test_spotlight_surface (void)
+{
+    cairo_surface_t *surface;
+    guint32 *pixels;
+    guint32 pixel;
+    int x;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, WIDTH, 1);
+    pixels = (guint32 *) cairo_image_surface_get_data (surface);
+    for (x = 0; x < WIDTH; x++)
+    {
+        /* Opaque, and half transparent with components at the alpha */
+        pixels[x] = x % 2 == 0 ? 0xff10f0fa : 0x80808080;
+    }
+    cairo_surface_mark_dirty (surface);
+
+    eel_spotlight_surface (surface);
+
+    cairo_surface_flush (surface);
+    for (x = 0; x < WIDTH; x++)
+    {
+        pixel = pixels[x];
+        g_assert_cmphex (pixel, ==, x % 2 == 0 ? 0xff1fffff : 0x80808080);
+    }
+
+    cairo_surface_destroy (surface);
+}
+
+static void
+test_colorized_pixbuf (void)
+{
+    g_autoptr (GdkPixbuf) src = create_test_pixbuf (TRUE);
+    g_autoptr (GdkPixbuf) dest = create_test_pixbuf (TRUE);
+    g_autoptr (GdkPixbuf) original = gdk_pixbuf_copy (dest);
+    guchar *src_pixels, *dest_pixels, *original_pixels;
+    int rowstride;
+    int x, y, c;
+    int expected;
+
+    eel_create_colorized_pixbuf (src, dest);
+
+    src_pixels = gdk_pixbuf_get_pixels (src);
+    dest_pixels = gdk_pixbuf_get_pixels (dest);
+    original_pixels = gdk_pixbuf_get_pixels (original);
+    rowstride = gdk_pixbuf_get_rowstride (src);
+
+    for (y = 0; y < HEIGHT; y++)
+    {
+        for (x = 0; x < WIDTH; x++)
+        {
+            for (c = 0; c < 4; c++)
+            {
+                int offset = y * rowstride + x * 4 + c;
+
+                expected = c == 3 ? src_pixels[offset] : (src_pixels[offset] * original_pixels[offset]) >> 8;
+                g_assert_cmpint (dest_pixels[offset], ==, expected);
+            }
+        }
+    }
+}
+
+static void
+setup_test_suite (void)
+{
+    g_test_add_func ("/graphic-effects-spotlight/1.0",
+                     test_spotlight_pixbuf);
+    g_test_add_func ("/graphic-effects-spotlight/1.1",
+                     test_spotlight_pixbuf_is_reused);
+    g_test_add_func ("/graphic-effects-spotlight/1.2",
+                     test_spotlight_surface);
+    g_test_add_func ("/graphic-effects-colorize/1.0",
+                     test_colorized_pixbuf);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+
+    setup_test_suite ();
+
+    return g_test_run ();
+}
@@ -1847,6 +1847,82 @@ test_move_fourth_hierarchy_undo_redo (void)
     empty_directory_by_prefix (root, "move");
 }
 
+/* Files of the same size, which only the Update choice tells apart by their
+ * modification times */
+static GFile *
+create_update_file (GFile       *dir,
+                    const gchar *name,
+                    const gchar *contents,
+                    guint64      mtime)
+{
+    GFile *file;
+
+    file = g_file_get_child (dir, name);
+    g_assert_true (g_file_replace_contents (file, contents, strlen (contents),
+                                            NULL, FALSE, G_FILE_CREATE_NONE,
+                                            NULL, NULL, NULL));
+    g_assert_true (g_file_set_attribute_uint64 (file, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                                mtime, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                                NULL, NULL));
+
+    return file;
+}
+
+static void
+assert_file_contents (GFile       *file,
+                      const gchar *expected)
+{
+    g_autofree gchar *contents = NULL;
+
+    g_assert_true (g_file_load_contents (file, NULL, &contents, NULL, NULL, NULL));
+    g_assert_cmpstr (contents, ==, expected);
+}
+
+static void
+test_move_update (void)
+{
+    g_autoptr (GFile) root = NULL;
+    g_autoptr (GFile) first_dir = NULL;
+    g_autoptr (GFile) second_dir = NULL;
+    g_autoptr (GFile) older = NULL;
+    g_autoptr (GFile) duplicate = NULL;
+    g_autoptr (GFile) newer = NULL;
+    g_autoptr (GFile) older_target = NULL;
+    g_autoptr (GFile) duplicate_target = NULL;
+    g_autoptr (GFile) newer_target = NULL;
+    g_autolist (GFile) files = NULL;
+
+    root = g_file_new_for_path (test_get_tmp_dir ());
+    first_dir = g_file_get_child (root, "move_update_first_dir");
+    g_assert_true (g_file_make_directory (first_dir, NULL, NULL));
+    second_dir = g_file_get_child (root, "move_update_second_dir");
+    g_assert_true (g_file_make_directory (second_dir, NULL, NULL));
+
+    older = create_update_file (first_dir, "move_update_older", "source", 1000000);
+    older_target = create_update_file (second_dir, "move_update_older", "target", 2000000);
+    duplicate = create_update_file (first_dir, "move_update_duplicate", "source", 1000000);
+    duplicate_target = create_update_file (second_dir, "move_update_duplicate", "source", 2000000);
+    newer = create_update_file (first_dir, "move_update_newer", "source", 2000000);
+    newer_target = create_update_file (second_dir, "move_update_newer", "target", 1000000);
+
+    files = g_list_prepend (files, g_object_ref (older));
+    files = g_list_prepend (files, g_object_ref (duplicate));
+    files = g_list_prepend (files, g_object_ref (newer));
+
+    nautilus_file_operations_move_update_sync (files, second_dir);
+
+    /* An older file is skipped and stays where it was, even if the contents
+     * differ; it is only taken away if it is the same as its copy */
+    assert_file_contents (older, "source");
+    assert_file_contents (older_target, "target");
+    g_assert_false (g_file_query_exists (duplicate, NULL));
+    assert_file_contents (duplicate_target, "source");
+    g_assert_false (g_file_query_exists (newer, NULL));
+    assert_file_contents (newer_target, "source");
+
+    empty_directory_by_prefix (root, "move_update");
+}
+
 static void
 setup_test_suite (void)
 {
@@ -1928,6 +2004,8 @@ setup_test_suite (void)
                      test_move_fourth_hierarchy_undo);
     g_test_add_func ("/test-move-hierarchy-undo-redo/1.4",
                      test_move_fourth_hierarchy_undo_redo);
+    g_test_add_func ("/test-move-update/1.0",
+                     test_move_update);
 }
 
 int
@@ -1941,6 +2019,8 @@ main (int   argc,
     g_test_init (&argc, &argv, NULL);
     g_test_set_nonfatal_assertions ();
     nautilus_ensure_extension_points ();
+    /* The Update choice reads its settings */
+    nautilus_global_preferences_init ();
 
     setup_test_suite ();
 
@@ -0,0 +1,215 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "test-utilities.h"
+
+static void
+quit_loop_done_callback (gboolean success,
+                         gpointer callback_data)
+{
+    g_main_loop_quit (callback_data);
+}
+
+static void
+set_owner_and_permissions_recursive_sync (GFile   *directory,
+                                          guint32  file_permissions,
+                                          guint32  dir_permissions,
+                                          int      uid,
+                                          int      gid)
+{
+    g_autoptr (GMainLoop) loop = NULL;
+    g_autoptr (GMainContext) context = NULL;
+    g_autofree gchar *uri = NULL;
+
+    context = g_main_context_new ();
+    g_main_context_push_thread_default (context);
+    loop = g_main_loop_new (context, FALSE);
+
+    uri = g_file_get_uri (directory);
+    nautilus_file_set_permissions_recursive (uri,
+                                             file_permissions, 0777,
+                                             dir_permissions, 0777,
+                                             uid, gid,
+                                             quit_loop_done_callback,
+                                             loop);
+
+    g_main_loop_run (loop);
+
+    g_main_context_pop_thread_default (context);
+}
+
+static void
+set_permissions_recursive_sync (GFile   *directory,
+                                guint32  file_permissions,
+                                guint32  dir_permissions)
+{
+    set_owner_and_permissions_recursive_sync (directory,
+                                              file_permissions, dir_permissions,
+                                              -1, -1);
+}
+
+static guint32
+get_mode (GFile *file)
+{
+    g_autofree gchar *path = NULL;
+    GStatBuf statbuf;
+
+    path = g_file_get_path (file);
+    g_assert_cmpint (g_lstat (path, &statbuf), ==, 0);
+
+    return statbuf.st_mode & 0777;
+}
+
+static gid_t
+get_gid (GFile *file)
+{
+    g_autofree gchar *path = NULL;
+    GStatBuf statbuf;
+
+    path = g_file_get_path (file);
+    g_assert_cmpint (g_lstat (path, &statbuf), ==, 0);
+
+    return statbuf.st_gid;
+}
+
+/* A group other than the one of @file that the user may give it, or the
+ * same one if the user is in no other group */
+static gid_t
+get_other_group (GFile *file)
+{
+    gid_t groups[NGROUPS_MAX];
+    int n_groups;
+
+    n_groups = getgroups (G_N_ELEMENTS (groups), groups);
+    for (int i = 0; i < n_groups; i++)
+    {
+        if (groups[i] != get_gid (file))
+        {
+            return groups[i];
+        }
+    }
+
+    return get_gid (file);
+}
+
+static void
+test_set_permissions_recursive (void)
+{
+    g_autoptr (GFile) root = NULL;
+    g_autoptr (GFile) first_dir = NULL;
+    g_autoptr (GFile) child_dir = NULL;
+    g_autoptr (GFile) file = NULL;
+
+    create_one_file ("set_permissions");
+
+    root = g_file_new_for_path (test_get_tmp_dir ());
+    first_dir = g_file_get_child (root, "set_permissions_first_dir");
+    file = g_file_get_child (first_dir, "set_permissions_first_dir_child");
+
+    child_dir = g_file_get_child (first_dir, "set_permissions_child_dir");
+    g_assert_true (g_file_make_directory (child_dir, NULL, NULL));
+
+    set_permissions_recursive_sync (first_dir, 0600, 0700);
+
+    g_assert_cmpuint (get_mode (file), ==, 0600);
+    g_assert_cmpuint (get_mode (child_dir), ==, 0700);
+
+    /* Running it again must leave everything as it is */
+    set_permissions_recursive_sync (first_dir, 0600, 0700);
+
+    g_assert_cmpuint (get_mode (file), ==, 0600);
+    g_assert_cmpuint (get_mode (child_dir), ==, 0700);
+
+    empty_directory_by_prefix (root, "set_permissions");
+}
+
+static void
+test_set_permissions_recursive_undo (void)
+{
+    g_autoptr (GFile) root = NULL;
+    g_autoptr (GFile) first_dir = NULL;
+    g_autoptr (GFile) file = NULL;
+    guint32 original_mode;
+
+    create_one_file ("set_permissions_undo");
+
+    root = g_file_new_for_path (test_get_tmp_dir ());
+    first_dir = g_file_get_child (root, "set_permissions_undo_first_dir");
+    file = g_file_get_child (first_dir, "set_permissions_undo_first_dir_child");
+    original_mode = get_mode (file);
+
+    set_permissions_recursive_sync (first_dir, original_mode ^ 0040, 0700);
+    g_assert_cmpuint (get_mode (file), ==, original_mode ^ 0040);
+
+    test_operation_undo ();
+
+    g_assert_cmpuint (get_mode (file), ==, original_mode);
+
+    empty_directory_by_prefix (root, "set_permissions_undo");
+}
+
+static void
+test_set_owner_recursive (void)
+{
+    g_autoptr (GFile) root = NULL;
+    g_autoptr (GFile) first_dir = NULL;
+    g_autoptr (GFile) child_dir = NULL;
+    g_autoptr (GFile) file = NULL;
+    gid_t gid;
+
+    create_one_file ("set_owner");
+
+    root = g_file_new_for_path (test_get_tmp_dir ());
+    first_dir = g_file_get_child (root, "set_owner_first_dir");
+    file = g_file_get_child (first_dir, "set_owner_first_dir_child");
+
+    child_dir = g_file_get_child (first_dir, "set_owner_child_dir");
+    g_assert_true (g_file_make_directory (child_dir, NULL, NULL));
+
+    gid = get_other_group (file);
+
+    /* The group is changed in the same walk as the mode, and the mode is
+     * still the one asked for once the group has changed */
+    set_owner_and_permissions_recursive_sync (first_dir, 0640, 0750, -1, gid);
+
+    g_assert_cmpuint (get_gid (file), ==, gid);
+    g_assert_cmpuint (get_gid (child_dir), ==, gid);
+    g_assert_cmpuint (get_mode (file), ==, 0640);
+    g_assert_cmpuint (get_mode (child_dir), ==, 0750);
+
+    empty_directory_by_prefix (root, "set_owner");
+}
+
+static void
+setup_test_suite (void)
+{
+    g_test_add_func ("/test-set-permissions-recursive/1.0",
+                     test_set_permissions_recursive);
+    g_test_add_func ("/test-set-permissions-recursive-undo/1.0",
+                     test_set_permissions_recursive_undo);
+    g_test_add_func ("/test-set-owner-recursive/1.0",
+                     test_set_owner_recursive);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_autoptr (NautilusFileUndoManager) undo_manager = NULL;
+    int ret;
+
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+    nautilus_ensure_extension_points ();
+    undo_manager = nautilus_file_undo_manager_new ();
+
+    setup_test_suite ();
+
+    ret = g_test_run ();
+
+    test_clear_tmp_dir ();
+
+    return ret;
+}
@@ -27,6 +27,37 @@ test_trash_one_file (void)
     empty_directory_by_prefix (root, "trash_or_delete");
 }
 
+static void
+test_trash_one_file_undo (void)
+{
+    g_autoptr (GFile) root = NULL;
+    g_autoptr (GFile) first_dir = NULL;
+    g_autoptr (GFile) file = NULL;
+    g_autolist (GFile) files = NULL;
+
+    create_one_file ("trash_or_delete");
+
+    root = g_file_new_for_path (test_get_tmp_dir ());
+    g_assert_true (root != NULL);
+
+    first_dir = g_file_get_child (root, "trash_or_delete_first_dir");
+    g_assert_true (first_dir != NULL);
+
+    file = g_file_get_child (first_dir, "trash_or_delete_first_dir_child");
+    g_assert_true (file != NULL);
+    files = g_list_prepend (files, g_object_ref (file));
+
+    nautilus_file_operations_trash_or_delete_sync (files);
+
+    g_assert_false (g_file_query_exists (file, NULL));
+
+    test_operation_undo ();
+
+    g_assert_true (g_file_query_exists (file, NULL));
+
+    empty_directory_by_prefix (root, "trash_or_delete");
+}
+
 static void
 test_trash_more_files_func (gint files_to_trash)
 {
@@ -537,6 +568,8 @@ setup_test_suite (void)
 {
     g_test_add_func ("/test-trash-one-file/1.0",
                      test_trash_one_file);
+    g_test_add_func ("/test-trash-one-file-undo/1.0",
+                     test_trash_one_file_undo);
     g_test_add_func ("/test-trash-more-files/1.0",
                      test_trash_more_files);
     g_test_add_func ("/test-delete-one-file/1.0",
@@ -0,0 +1,182 @@
+#include <glib.h>
+#include "src/nautilus-file-undo-journal.h"
+
+/* Enough records for the journal to go past its memory budget */
+#define LARGE_JOURNAL_LENGTH 40000
+
+typedef struct
+{
+    guint index;
+    gboolean with_target;
+} CheckData;
+
+static gchar *
+get_uri (const gchar *prefix,
+         guint        index)
+{
+    /* Alternate the first directory so that consecutive URIs share little */
+    return g_strdup_printf ("file:///tmp/%s/%c/%0100u", prefix, 'a' + index % 26, index);
+}
+
+static void
+append_records (NautilusFileUndoJournal *journal,
+                guint                    length,
+                gboolean                 with_target)
+{
+    for (guint i = 0; i < length; i++)
+    {
+        g_autofree gchar *origin_uri = get_uri ("origin", i);
+        g_autofree gchar *target_uri = get_uri ("target", i);
+        g_autoptr (GFile) origin = g_file_new_for_uri (origin_uri);
+        g_autoptr (GFile) target = g_file_new_for_uri (target_uri);
+
+        nautilus_file_undo_journal_append (journal, origin,
+                                           with_target ? target : NULL, i);
+    }
+}
+
+static gboolean
+check_record (GFile    *origin,
+              GFile    *target,
+              guint32   value,
+              gpointer  user_data)
+{
+    CheckData *data = user_data;
+    g_autofree gchar *expected_origin = get_uri ("origin", data->index);
+    g_autofree gchar *expected_target = get_uri ("target", data->index);
+    g_autofree gchar *origin_uri = g_file_get_uri (origin);
+
+    g_assert_cmpstr (origin_uri, ==, expected_origin);
+    g_assert_cmpuint (value, ==, data->index);
+    if (data->with_target)
+    {
+        g_autofree gchar *target_uri = g_file_get_uri (target);
+
+        g_assert_cmpstr (target_uri, ==, expected_target);
+    }
+    else
+    {
+        g_assert_null (target);
+    }
+
+    data->index++;
+
+    return TRUE;
+}
+
+static gboolean
+stop_at_first (GFile    *origin,
+               GFile    *target,
+               guint32   value,
+               gpointer  user_data)
+{
+    guint *calls = user_data;
+
+    (*calls)++;
+
+    return FALSE;
+}
+
+static void
+test_empty_journal (void)
+{
+    NautilusFileUndoJournal *journal;
+    GList *origins;
+
+    journal = nautilus_file_undo_journal_new ();
+
+    g_assert_cmpuint (nautilus_file_undo_journal_get_length (journal), ==, 0);
+    origins = nautilus_file_undo_journal_get_origins (journal);
+    g_assert_null (origins);
+
+    nautilus_file_undo_journal_free (journal);
+}
+
+static void
+test_small_journal (void)
+{
+    NautilusFileUndoJournal *journal;
+    CheckData data = { 0, TRUE };
+    guint calls = 0;
+    g_autolist (GFile) targets = NULL;
+    g_autofree gchar *first_target = NULL;
+    g_autofree gchar *expected_first_target = get_uri ("target", 0);
+
+    journal = nautilus_file_undo_journal_new ();
+    append_records (journal, 10, TRUE);
+
+    g_assert_cmpuint (nautilus_file_undo_journal_get_length (journal), ==, 10);
+    nautilus_file_undo_journal_foreach (journal, check_record, &data);
+    g_assert_cmpuint (data.index, ==, 10);
+
+    nautilus_file_undo_journal_foreach (journal, stop_at_first, &calls);
+    g_assert_cmpuint (calls, ==, 1);
+
+    targets = nautilus_file_undo_journal_get_targets (journal);
+    g_assert_cmpuint (g_list_length (targets), ==, 10);
+    first_target = g_file_get_uri (targets->data);
+    g_assert_cmpstr (first_target, ==, expected_first_target);
+
+    nautilus_file_undo_journal_free (journal);
+}
+
+static void
+test_large_journal (void)
+{
+    NautilusFileUndoJournal *journal;
+    CheckData data = { 0, FALSE };
+
+    journal = nautilus_file_undo_journal_new ();
+    append_records (journal, LARGE_JOURNAL_LENGTH, FALSE);
+
+    g_assert_cmpuint (nautilus_file_undo_journal_get_length (journal), ==, LARGE_JOURNAL_LENGTH);
+    nautilus_file_undo_journal_foreach (journal, check_record, &data);
+    g_assert_cmpuint (data.index, ==, LARGE_JOURNAL_LENGTH);
+
+    /* Reading twice must give the same records */
+    data.index = 0;
+    nautilus_file_undo_journal_foreach (journal, check_record, &data);
+    g_assert_cmpuint (data.index, ==, LARGE_JOURNAL_LENGTH);
+
+    nautilus_file_undo_journal_free (journal);
+}
+
+static void
+test_large_journal_with_targets (void)
+{
+    NautilusFileUndoJournal *journal;
+    CheckData data = { 0, TRUE };
+
+    journal = nautilus_file_undo_journal_new ();
+    append_records (journal, LARGE_JOURNAL_LENGTH, TRUE);
+
+    nautilus_file_undo_journal_foreach (journal, check_record, &data);
+    g_assert_cmpuint (data.index, ==, LARGE_JOURNAL_LENGTH);
+
+    nautilus_file_undo_journal_free (journal);
+}
+
+static void
+setup_test_suite (void)
+{
+    g_test_add_func ("/file-undo-journal-empty/1.0",
+                     test_empty_journal);
+    g_test_add_func ("/file-undo-journal-small/1.0",
+                     test_small_journal);
+    g_test_add_func ("/file-undo-journal-large/1.0",
+                     test_large_journal);
+    g_test_add_func ("/file-undo-journal-large/1.1",
+                     test_large_journal_with_targets);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+
+    setup_test_suite ();
+
+    return g_test_run ();
+}
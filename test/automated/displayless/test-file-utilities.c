@@ -1,5 +1,7 @@
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <glib/gstdio.h>
+#include <string.h>
 #include "src/nautilus-directory.h"
 #include "src/nautilus-file-utilities.h"
 #include "src/nautilus-search-directory.h"
@@ -205,6 +207,88 @@ test_multiple_files_different_large (void)
     g_assert_false (nautilus_file_selection_equal (first_selection, second_selection));
 }
 
+/* Large enough for a difference to be far from the start and the end */
+#define UP_TO_DATE_FILE_SIZE (512 * 1024)
+
+static GFile *
+create_file_with_mtime (const gchar  *dir,
+                        const gchar  *name,
+                        const guchar *contents,
+                        gsize         length,
+                        guint64       mtime)
+{
+    g_autofree gchar *path = NULL;
+    GFile *file;
+
+    path = g_build_filename (dir, name, NULL);
+    g_assert_true (g_file_set_contents (path, (const gchar *) contents, length, NULL));
+
+    file = g_file_new_for_path (path);
+    g_assert_true (g_file_set_attribute_uint64 (file, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                                mtime, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                                NULL, NULL));
+    g_assert_true (g_file_set_attribute_uint32 (file, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                                                0, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                                NULL, NULL));
+
+    return file;
+}
+
+/* Tests which copies the Update choice of the conflict dialog leaves alone */
+static void
+test_is_up_to_date_copy (void)
+{
+    g_autofree gchar *dir = NULL;
+    g_autofree guchar *contents = NULL;
+    g_autofree guchar *edited = NULL;
+    g_autoptr (GFile) copy = NULL;
+    g_autoptr (GFile) older = NULL;
+    g_autoptr (GFile) barely_newer = NULL;
+    g_autoptr (GFile) newer_same = NULL;
+    g_autoptr (GFile) newer_edited = NULL;
+    g_autoptr (GFile) shorter = NULL;
+
+    dir = g_dir_make_tmp ("nautilus-up-to-date.XXXXXX", NULL);
+    g_assert_nonnull (dir);
+
+    contents = g_malloc (UP_TO_DATE_FILE_SIZE);
+    for (gsize i = 0; i < UP_TO_DATE_FILE_SIZE; i++)
+    {
+        contents[i] = i % 251;
+    }
+    /* Edited in place, away from the start, the middle and the end */
+    edited = g_malloc (UP_TO_DATE_FILE_SIZE);
+    memcpy (edited, contents, UP_TO_DATE_FILE_SIZE);
+    edited[UP_TO_DATE_FILE_SIZE / 4] ^= 0xff;
+
+    copy = create_file_with_mtime (dir, "copy", contents, UP_TO_DATE_FILE_SIZE, 1000000);
+    older = create_file_with_mtime (dir, "older", contents, UP_TO_DATE_FILE_SIZE, 900000);
+    barely_newer = create_file_with_mtime (dir, "barely-newer", edited, UP_TO_DATE_FILE_SIZE, 1000001);
+    newer_same = create_file_with_mtime (dir, "newer-same", contents, UP_TO_DATE_FILE_SIZE, 1100000);
+    newer_edited = create_file_with_mtime (dir, "newer-edited", edited, UP_TO_DATE_FILE_SIZE, 1100000);
+    shorter = create_file_with_mtime (dir, "shorter", contents, UP_TO_DATE_FILE_SIZE - 1, 900000);
+
+    /* Same size and not newer */
+    g_assert_true (nautilus_is_up_to_date_copy (older, copy, FALSE, NULL));
+    /* Newer by less than the precision of FAT modification times */
+    g_assert_true (nautilus_is_up_to_date_copy (barely_newer, copy, FALSE, NULL));
+    /* A different size is always copied */
+    g_assert_false (nautilus_is_up_to_date_copy (shorter, copy, FALSE, NULL));
+    g_assert_false (nautilus_is_up_to_date_copy (shorter, copy, TRUE, NULL));
+    /* Newer, only left alone if the contents are compared and equal */
+    g_assert_false (nautilus_is_up_to_date_copy (newer_same, copy, FALSE, NULL));
+    g_assert_true (nautilus_is_up_to_date_copy (newer_same, copy, TRUE, NULL));
+    g_assert_false (nautilus_is_up_to_date_copy (newer_edited, copy, TRUE, NULL));
+
+    g_file_delete (copy, NULL, NULL);
+    g_file_delete (older, NULL, NULL);
+    g_file_delete (barely_newer, NULL, NULL);
+    g_file_delete (newer_same, NULL, NULL);
+    g_file_delete (newer_edited, NULL, NULL);
+    g_file_delete (shorter, NULL, NULL);
+    g_rmdir (dir);
+}
+
 static void
 setup_test_suite (void)
 {
@@ -224,6 +308,8 @@ setup_test_suite (void)
                      test_multiple_files_different_medium);
     g_test_add_func ("/file-selection-different-files/1.2",
                      test_multiple_files_different_large);
+    g_test_add_func ("/is-up-to-date-copy/1.0",
+                     test_is_up_to_date_copy);
 }
 
 int
@@ -0,0 +1,113 @@
+#include "test-utilities.h"
+
+#include <src/nautilus-directory.h>
+#include <src/nautilus-file-private.h>
+#include <src/nautilus-listing-snapshot.h>
+
+typedef struct
+{
+    const gchar *name;
+    const gchar *display_name;
+    GFileType type;
+    guint64 size;
+    guint64 mtime;
+    const gchar *content_type;
+} SnapshotEntry;
+
+static const SnapshotEntry entries[] =
+{
+    { "report.pdf", "report.pdf", G_FILE_TYPE_REGULAR, 123456, 1600000000, "application/pdf" },
+    { "Photos", "Photos", G_FILE_TYPE_DIRECTORY, 4096, 1500000000, "inode/directory" },
+    { ".hidden", ".hidden", G_FILE_TYPE_REGULAR, 0, 1400000000, "text/plain" },
+    { "café", "café", G_FILE_TYPE_REGULAR, 42, 1300000000, "text/plain" },
+};
+
+static GList *
+create_files (NautilusDirectory *directory)
+{
+    GList *files = NULL;
+
+    for (guint i = 0; i < G_N_ELEMENTS (entries); i++)
+    {
+        g_autoptr (GFileInfo) info = NULL;
+
+        info = g_file_info_new ();
+        g_file_info_set_name (info, entries[i].name);
+        g_file_info_set_display_name (info, entries[i].display_name);
+        g_file_info_set_file_type (info, entries[i].type);
+        g_file_info_set_size (info, entries[i].size);
+        g_file_info_set_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                          entries[i].mtime);
+        g_file_info_set_content_type (info, entries[i].content_type);
+        g_file_info_set_is_hidden (info, entries[i].name[0] == '.');
+
+        files = g_list_prepend (files, nautilus_file_new_from_info (directory, info));
+    }
+
+    return g_list_reverse (files);
+}
+
+static void
+test_listing_snapshot_round_trip (void)
+{
+    g_autoptr (GFile) location = NULL;
+    g_autoptr (NautilusDirectory) directory = NULL;
+    GList *files;
+    GList *infos;
+    GList *l;
+    guint i;
+
+    location = g_file_new_for_uri ("sftp://example.com/snapshot");
+    directory = nautilus_directory_get (location);
+    files = create_files (directory);
+
+    g_assert_null (nautilus_listing_snapshot_load (location));
+
+    /* The snapshot is written asynchronously */
+    nautilus_listing_snapshot_save (location, files);
+    while ((infos = nautilus_listing_snapshot_load (location)) == NULL)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    g_assert_cmpuint (g_list_length (infos), ==, G_N_ELEMENTS (entries));
+    for (l = infos, i = 0; l != NULL; l = l->next, i++)
+    {
+        GFileInfo *info = l->data;
+
+        g_assert_cmpstr (g_file_info_get_name (info), ==, entries[i].name);
+        g_assert_cmpstr (g_file_info_get_display_name (info), ==, entries[i].display_name);
+        g_assert_cmpint (g_file_info_get_file_type (info), ==, entries[i].type);
+        g_assert_cmpuint (g_file_info_get_size (info), ==, entries[i].size);
+        g_assert_cmpuint (g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED),
+                          ==, entries[i].mtime);
+        g_assert_cmpstr (g_file_info_get_content_type (info), ==, entries[i].content_type);
+        g_assert_cmpint (g_file_info_get_is_hidden (info), ==, entries[i].name[0] == '.');
+        g_assert_true (g_file_info_get_attribute_boolean (info, NAUTILUS_LISTING_SNAPSHOT_ATTRIBUTE));
+    }
+
+    g_list_free_full (infos, g_object_unref);
+    nautilus_file_list_free (files);
+}
+
+static void
+setup_test_suite (void)
+{
+    g_test_add_func ("/listing-snapshot/round-trip",
+                     test_listing_snapshot_round_trip);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    /* The snapshots are saved in a temporary cache directory */
+    g_test_init (&argc, &argv, G_TEST_OPTION_ISOLATE_DIRS, NULL);
+    g_test_set_nonfatal_assertions ();
+    nautilus_ensure_extension_points ();
+    nautilus_global_preferences_init ();
+
+    setup_test_suite ();
+
+    return g_test_run ();
+}
@@ -0,0 +1,91 @@
+#include "test-utilities.h"
+
+static NautilusQuery *
+create_query (const gchar *text)
+{
+    NautilusQuery *query;
+    g_autoptr (GFile) location = NULL;
+
+    location = g_file_new_for_path (test_get_tmp_dir ());
+
+    query = nautilus_query_new ();
+    nautilus_query_set_text (query, text);
+    nautilus_query_set_location (query, location);
+
+    return query;
+}
+
+static void
+test_refinement_more_letters (void)
+{
+    g_autoptr (NautilusQuery) previous = create_query ("rep");
+    g_autoptr (NautilusQuery) query = create_query ("Report");
+
+    g_assert_true (nautilus_query_is_refinement_of (query, previous));
+    g_assert_false (nautilus_query_is_refinement_of (previous, query));
+}
+
+static void
+test_refinement_more_words (void)
+{
+    g_autoptr (NautilusQuery) previous = create_query ("report");
+    g_autoptr (NautilusQuery) query = create_query ("2020 report");
+    g_autoptr (NautilusQuery) other = create_query ("2020 summary");
+
+    g_assert_true (nautilus_query_is_refinement_of (query, previous));
+    g_assert_false (nautilus_query_is_refinement_of (other, previous));
+}
+
+static void
+test_refinement_same_text (void)
+{
+    g_autoptr (NautilusQuery) previous = create_query ("report");
+    g_autoptr (NautilusQuery) query = create_query ("report");
+
+    /* Searching again for the same thing is a reload */
+    g_assert_false (nautilus_query_is_refinement_of (query, previous));
+}
+
+static void
+test_refinement_other_constraints (void)
+{
+    g_autoptr (NautilusQuery) previous = create_query ("rep");
+    g_autoptr (NautilusQuery) query = create_query ("report");
+    g_autoptr (GFile) location = NULL;
+
+    nautilus_query_set_search_content (query, NAUTILUS_QUERY_SEARCH_CONTENT_FULL_TEXT);
+    g_assert_false (nautilus_query_is_refinement_of (query, previous));
+
+    nautilus_query_set_search_content (query, NAUTILUS_QUERY_SEARCH_CONTENT_SIMPLE);
+    location = g_file_new_for_path (g_get_home_dir ());
+    nautilus_query_set_location (query, location);
+    g_assert_false (nautilus_query_is_refinement_of (query, previous));
+}
+
+static void
+setup_test_suite (void)
+{
+    g_test_add_func ("/query-refinement/1.0",
+                     test_refinement_more_letters);
+    g_test_add_func ("/query-refinement/1.1",
+                     test_refinement_more_words);
+    g_test_add_func ("/query-refinement/1.2",
+                     test_refinement_same_text);
+    g_test_add_func ("/query-refinement/1.3",
+                     test_refinement_other_constraints);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+    nautilus_ensure_extension_points ();
+    /* Needed for nautilus-query.c. */
+    nautilus_global_preferences_init ();
+
+    setup_test_suite ();
+
+    return g_test_run ();
+}
@@ -0,0 +1,106 @@
+#include "test-utilities.h"
+
+#include <src/nautilus-directory.h>
+#include <src/nautilus-file.h>
+#include <src/nautilus-query.h>
+#include <src/nautilus-search-directory.h>
+
+/* Files are made for this many hits at a time */
+#define PAGE_SIZE 5000
+/* One page and a bit, and the directory create_multiple_files() makes */
+#define N_FILES (PAGE_SIZE + 1500)
+#define N_HITS (N_FILES + 1)
+
+static void
+search_ready_cb (NautilusDirectory *directory,
+                 GList             *files,
+                 gpointer           user_data)
+{
+    g_main_loop_quit (user_data);
+}
+
+static void
+test_search_directory_paging (void)
+{
+    g_autoptr (GMainLoop) loop = NULL;
+    g_autoptr (NautilusQuery) query = NULL;
+    g_autoptr (GFile) location = NULL;
+    g_autofree gchar *uri = NULL;
+    NautilusDirectory *directory;
+    NautilusSearchDirectory *search_directory;
+    GList *files;
+
+    loop = g_main_loop_new (NULL, FALSE);
+
+    create_multiple_files ("search_paging", N_FILES);
+
+    location = g_file_new_for_path (test_get_tmp_dir ());
+    query = nautilus_query_new ();
+    nautilus_query_set_text (query, "search_paging");
+    nautilus_query_set_location (query, location);
+
+    uri = nautilus_search_directory_generate_new_uri ();
+    directory = nautilus_directory_get_by_uri (uri);
+    g_assert_true (NAUTILUS_IS_SEARCH_DIRECTORY (directory));
+    search_directory = NAUTILUS_SEARCH_DIRECTORY (directory);
+    nautilus_search_directory_set_query (search_directory, query);
+
+    nautilus_directory_call_when_ready (directory, 0, TRUE,
+                                        search_ready_cb, loop);
+    g_main_loop_run (loop);
+
+    /* Only the first page is made into files */
+    files = nautilus_directory_get_file_list (directory);
+    g_assert_cmpuint (g_list_length (files), ==, PAGE_SIZE);
+    nautilus_file_list_free (files);
+    g_assert_cmpuint (nautilus_search_directory_get_n_hidden_hits (search_directory),
+                      ==, N_HITS - PAGE_SIZE);
+
+    /* The rest fits in the next page */
+    nautilus_search_directory_show_more_hits (search_directory);
+    files = nautilus_directory_get_file_list (directory);
+    g_assert_cmpuint (g_list_length (files), ==, N_HITS);
+    nautilus_file_list_free (files);
+    g_assert_cmpuint (nautilus_search_directory_get_n_hidden_hits (search_directory), ==, 0);
+
+    /* Nothing left to show */
+    nautilus_search_directory_show_more_hits (search_directory);
+    files = nautilus_directory_get_file_list (directory);
+    g_assert_cmpuint (g_list_length (files), ==, N_HITS);
+    nautilus_file_list_free (files);
+
+    nautilus_directory_unref (directory);
+
+    empty_directory_by_prefix (location, "search_paging");
+}
+
+static void
+setup_test_suite (void)
+{
+    g_test_add_func ("/search-directory-paging/show-more-hits",
+                     test_search_directory_paging);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    int ret;
+
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+    nautilus_ensure_extension_points ();
+    /* Needed for nautilus-query.c.
+     * FIXME: tests are not installed, so the system does not
+     * have the gschema. Installed tests is a long term GNOME goal.
+     */
+    nautilus_global_preferences_init ();
+
+    setup_test_suite ();
+
+    ret = g_test_run ();
+
+    test_clear_tmp_dir ();
+
+    return ret;
+}
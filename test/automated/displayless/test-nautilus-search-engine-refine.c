@@ -0,0 +1,118 @@
+#include "test-utilities.h"
+
+static void
+hits_added_cb (NautilusSearchEngine *engine,
+               GList                *hits,
+               GHashTable           *uris)
+{
+    for (GList *l = hits; l != NULL; l = l->next)
+    {
+        g_hash_table_add (uris, g_strdup (nautilus_search_hit_get_uri (l->data)));
+    }
+}
+
+static void
+finished_cb (NautilusSearchEngine         *engine,
+             NautilusSearchProviderStatus  status,
+             gpointer                      user_data)
+{
+    g_main_loop_quit (user_data);
+}
+
+static GHashTable *
+search_sync (NautilusSearchEngine *engine,
+             NautilusQuery        *query)
+{
+    g_autoptr (GMainLoop) loop = NULL;
+    GHashTable *uris;
+    gulong hits_added_id;
+    gulong finished_id;
+
+    loop = g_main_loop_new (NULL, FALSE);
+    uris = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    hits_added_id = g_signal_connect (engine, "hits-added",
+                                      G_CALLBACK (hits_added_cb), uris);
+    finished_id = g_signal_connect (engine, "finished",
+                                    G_CALLBACK (finished_cb), loop);
+
+    nautilus_search_provider_set_query (NAUTILUS_SEARCH_PROVIDER (engine), query);
+    nautilus_search_provider_start (NAUTILUS_SEARCH_PROVIDER (engine));
+    g_main_loop_run (loop);
+
+    g_signal_handler_disconnect (engine, hits_added_id);
+    g_signal_handler_disconnect (engine, finished_id);
+
+    return uris;
+}
+
+/* The query editor changes its query in place as more letters are typed, and
+ * the second search must still be answered from the hits of the first one */
+static void
+test_search_engine_refines_query_changed_in_place (void)
+{
+    g_autoptr (NautilusSearchEngine) engine = NULL;
+    g_autoptr (NautilusQuery) query = NULL;
+    g_autoptr (GFile) location = NULL;
+    g_autoptr (GHashTable) first_uris = NULL;
+    g_autoptr (GHashTable) refined_uris = NULL;
+    GHashTableIter iter;
+    const gchar *uri;
+
+    create_search_file_hierarchy ("refine");
+
+    location = g_file_new_for_path (test_get_tmp_dir ());
+    query = nautilus_query_new ();
+    nautilus_query_set_text (query, "engine");
+    nautilus_query_set_location (query, location);
+
+    engine = nautilus_search_engine_new ();
+    first_uris = search_sync (engine, query);
+    g_assert_cmpuint (g_hash_table_size (first_uris), >, 0);
+
+    /* Crawling again would find nothing */
+    delete_search_file_hierarchy ("refine");
+
+    nautilus_query_set_text (query, "engine_refine");
+    refined_uris = search_sync (engine, query);
+
+    g_assert_cmpuint (g_hash_table_size (refined_uris), >, 0);
+    g_assert_cmpuint (g_hash_table_size (refined_uris), <=,
+                      g_hash_table_size (first_uris));
+    g_hash_table_iter_init (&iter, refined_uris);
+    while (g_hash_table_iter_next (&iter, (gpointer *) &uri, NULL))
+    {
+        g_assert_true (g_hash_table_contains (first_uris, uri));
+    }
+}
+
+static void
+setup_test_suite (void)
+{
+    g_test_add_func ("/search-engine-refine/query-changed-in-place",
+                     test_search_engine_refines_query_changed_in_place);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    int ret;
+
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+    nautilus_ensure_extension_points ();
+    /* Needed for nautilus-query.c.
+     * FIXME: tests are not installed, so the system does not
+     * have the gschema. Installed tests is a long term GNOME goal.
+     */
+    nautilus_global_preferences_init ();
+
+    setup_test_suite ();
+
+    ret = g_test_run ();
+
+    test_clear_tmp_dir ();
+
+    return ret;
+}
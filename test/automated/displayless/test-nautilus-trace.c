@@ -0,0 +1,186 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "src/nautilus-trace.h"
+
+static char *
+write_trace (void)
+{
+    g_autoptr (GError) error = NULL;
+    g_autofree char *filename = NULL;
+    char *contents;
+    int fd;
+
+    fd = g_file_open_tmp ("nautilus-trace-XXXXXX.json", &filename, &error);
+    g_assert_no_error (error);
+    close (fd);
+
+    g_assert_true (nautilus_trace_write (filename, &error));
+    g_assert_no_error (error);
+
+    g_assert_true (g_file_get_contents (filename, &contents, NULL, NULL));
+    g_unlink (filename);
+
+    return contents;
+}
+
+static guint
+count_occurrences (const char *haystack,
+                   const char *needle)
+{
+    const char *p;
+    guint n;
+
+    n = 0;
+    for (p = strstr (haystack, needle); p != NULL; p = strstr (p + 1, needle))
+    {
+        n++;
+    }
+
+    return n;
+}
+
+static gpointer
+record_in_thread (gpointer data)
+{
+    _nautilus_trace_record ('B', "thread span", 0, NULL);
+    _nautilus_trace_record ('E', "thread span", 0, NULL);
+
+    return NULL;
+}
+
+static void
+test_spans_and_counters (void)
+{
+    g_autofree char *trace = NULL;
+    GThread *thread;
+
+    nautilus_trace_set_enabled (TRUE);
+
+    _nautilus_trace_record ('B', "main span", 0, "%d files", 42);
+    _nautilus_trace_record ('C', "jobs", 3, NULL);
+    _nautilus_trace_record ('b', "async span", 0xabc, NULL);
+    _nautilus_trace_record ('E', "main span", 0, NULL);
+
+    thread = g_thread_new ("trace", record_in_thread, NULL);
+    g_thread_join (thread);
+
+    trace = write_trace ();
+
+    g_assert_true (g_str_has_prefix (trace, "{\"traceEvents\":["));
+    g_assert_nonnull (strstr (trace, "\"name\":\"main span\",\"cat\":\"nautilus\",\"ph\":\"B\""));
+    g_assert_nonnull (strstr (trace, "\"args\":{\"detail\":\"42 files\"}"));
+    g_assert_nonnull (strstr (trace, "\"args\":{\"value\":3}"));
+    g_assert_nonnull (strstr (trace, "\"id\":\"0xabc\""));
+    g_assert_cmpuint (count_occurrences (trace, "\"thread span\""), ==, 2);
+    /* Each thread has its own buffer */
+    g_assert_nonnull (strstr (trace, "\"tid\":2"));
+}
+
+static void
+test_escaping (void)
+{
+    g_autofree char *trace = NULL;
+
+    nautilus_trace_set_enabled (TRUE);
+
+    _nautilus_trace_record ('i', "escaped", 0, "a \"quoted\\path\"\n");
+
+    trace = write_trace ();
+
+    g_assert_nonnull (strstr (trace, "\"detail\":\"a \\\"quoted\\\\path\\\"\\u000a\""));
+}
+
+static void
+test_ring_buffer_wraps (void)
+{
+    g_autofree char *trace = NULL;
+    guint i;
+    guint n_events;
+
+    nautilus_trace_set_enabled (TRUE);
+
+    for (i = 0; i < 10000; i++)
+    {
+        _nautilus_trace_record ('C', "wrapping", i, NULL);
+    }
+
+    trace = write_trace ();
+
+    /* Only the most recent events of a thread are kept */
+    n_events = count_occurrences (trace, "\"ph\":");
+    g_assert_cmpuint (n_events, <, 10000);
+    g_assert_nonnull (strstr (trace, "\"args\":{\"value\":9999}"));
+    g_assert_null (strstr (trace, "\"args\":{\"value\":0}"));
+}
+
+#define EXITED_THREADS 8
+#define EVENTS_PER_EXITED_THREAD 4096
+
+static gpointer
+record_many_in_thread (gpointer data)
+{
+    guint thread_number = GPOINTER_TO_UINT (data);
+
+    for (guint i = 0; i < EVENTS_PER_EXITED_THREAD; i++)
+    {
+        _nautilus_trace_record ('C', "exited",
+                                thread_number * EVENTS_PER_EXITED_THREAD + i, NULL);
+    }
+
+    return NULL;
+}
+
+static void
+test_exited_threads (void)
+{
+    g_autofree char *trace = NULL;
+    g_autofree char *last_value = NULL;
+    guint n_events;
+
+    nautilus_trace_set_enabled (TRUE);
+
+    for (guint i = 0; i < EXITED_THREADS; i++)
+    {
+        g_thread_join (g_thread_new ("trace", record_many_in_thread,
+                                     GUINT_TO_POINTER (i)));
+    }
+
+    trace = write_trace ();
+
+    /* The events of the threads that exited are still written, but only
+     * the most recent ones are kept */
+    n_events = count_occurrences (trace, "\"name\":\"exited\"");
+    g_assert_cmpuint (n_events, >, 0);
+    g_assert_cmpuint (n_events, <, EXITED_THREADS * EVENTS_PER_EXITED_THREAD);
+    last_value = g_strdup_printf ("\"args\":{\"value\":%u}",
+                                  EXITED_THREADS * EVENTS_PER_EXITED_THREAD - 1);
+    g_assert_nonnull (strstr (trace, last_value));
+}
+
+static void
+setup_test_suite (void)
+{
+    g_test_add_func ("/trace-record/1.0",
+                     test_spans_and_counters);
+    g_test_add_func ("/trace-record/1.1",
+                     test_escaping);
+    g_test_add_func ("/trace-record/1.2",
+                     test_ring_buffer_wraps);
+    g_test_add_func ("/trace-record/1.3",
+                     test_exited_threads);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+
+    setup_test_suite ();
+
+    return g_test_run ();
+}
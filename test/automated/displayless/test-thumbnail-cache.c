@@ -0,0 +1,158 @@
+#include <glib.h>
+#include "src/nautilus-thumbnail-cache.h"
+
+#define THUMBNAIL_SIZE 64
+
+static GdkPixbuf *
+create_thumbnail (void)
+{
+    return gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8,
+                           THUMBNAIL_SIZE, THUMBNAIL_SIZE);
+}
+
+static gsize
+get_thumbnail_size (void)
+{
+    g_autoptr (GdkPixbuf) pixbuf = create_thumbnail ();
+
+    return gdk_pixbuf_get_byte_length (pixbuf);
+}
+
+static void
+test_insert_and_lookup (void)
+{
+    g_autoptr (GdkPixbuf) pixbuf = create_thumbnail ();
+    g_autoptr (GdkPixbuf) found = NULL;
+    NautilusThumbnailCacheStatistics before;
+    NautilusThumbnailCacheStatistics after;
+    guint handle;
+
+    nautilus_thumbnail_cache_set_budget (G_MAXSIZE);
+    nautilus_thumbnail_cache_get_statistics (&before);
+
+    handle = nautilus_thumbnail_cache_insert (pixbuf);
+    g_assert_cmpuint (handle, !=, 0);
+
+    found = nautilus_thumbnail_cache_lookup (handle);
+    g_assert_true (found == pixbuf);
+
+    nautilus_thumbnail_cache_remove (handle);
+    g_assert_null (nautilus_thumbnail_cache_lookup (handle));
+
+    nautilus_thumbnail_cache_get_statistics (&after);
+    g_assert_cmpuint (after.hits - before.hits, ==, 1);
+    g_assert_cmpuint (after.misses - before.misses, ==, 1);
+    g_assert_cmpuint (after.n_entries, ==, before.n_entries);
+}
+
+static void
+test_scaled (void)
+{
+    g_autoptr (GdkPixbuf) pixbuf = create_thumbnail ();
+    g_autoptr (GdkPixbuf) scaled = NULL;
+    g_autoptr (GdkPixbuf) found = NULL;
+    guint handle;
+
+    nautilus_thumbnail_cache_set_budget (G_MAXSIZE);
+
+    handle = nautilus_thumbnail_cache_insert (pixbuf);
+    g_assert_null (nautilus_thumbnail_cache_lookup_scaled (handle, 0.5));
+
+    scaled = gdk_pixbuf_scale_simple (pixbuf, THUMBNAIL_SIZE / 2,
+                                      THUMBNAIL_SIZE / 2, GDK_INTERP_BILINEAR);
+    nautilus_thumbnail_cache_set_scaled (handle, scaled, 0.5);
+
+    found = nautilus_thumbnail_cache_lookup_scaled (handle, 0.5);
+    g_assert_true (found == scaled);
+    g_assert_null (nautilus_thumbnail_cache_lookup_scaled (handle, 0.25));
+
+    nautilus_thumbnail_cache_remove (handle);
+}
+
+static void
+test_eviction (void)
+{
+    g_autoptr (GdkPixbuf) pixbuf = create_thumbnail ();
+    g_autoptr (GdkPixbuf) found = NULL;
+    NautilusThumbnailCacheStatistics before;
+    NautilusThumbnailCacheStatistics after;
+    guint first;
+    guint second;
+    guint third;
+
+    /* Room for two thumbnails */
+    nautilus_thumbnail_cache_set_budget (2 * get_thumbnail_size ());
+    nautilus_thumbnail_cache_get_statistics (&before);
+
+    first = nautilus_thumbnail_cache_insert (pixbuf);
+    second = nautilus_thumbnail_cache_insert (pixbuf);
+
+    /* Using the first one makes the second the least recently used */
+    found = nautilus_thumbnail_cache_lookup (first);
+    g_assert_nonnull (found);
+
+    third = nautilus_thumbnail_cache_insert (pixbuf);
+
+    g_clear_object (&found);
+    found = nautilus_thumbnail_cache_lookup (second);
+    g_assert_null (found);
+    found = nautilus_thumbnail_cache_lookup (first);
+    g_assert_nonnull (found);
+    g_clear_object (&found);
+    found = nautilus_thumbnail_cache_lookup (third);
+    g_assert_nonnull (found);
+
+    nautilus_thumbnail_cache_get_statistics (&after);
+    g_assert_cmpuint (after.evictions - before.evictions, ==, 1);
+    g_assert_cmpuint (after.size, <=, after.budget);
+
+    /* Shrinking the budget drops the least recently used first */
+    nautilus_thumbnail_cache_set_budget (get_thumbnail_size ());
+    g_clear_object (&found);
+    found = nautilus_thumbnail_cache_lookup (first);
+    g_assert_null (found);
+
+    nautilus_thumbnail_cache_remove (third);
+}
+
+static void
+test_oversized_entry (void)
+{
+    g_autoptr (GdkPixbuf) pixbuf = create_thumbnail ();
+    g_autoptr (GdkPixbuf) found = NULL;
+    guint handle;
+
+    /* The most recent thumbnail is kept even when it doesn't fit */
+    nautilus_thumbnail_cache_set_budget (1);
+
+    handle = nautilus_thumbnail_cache_insert (pixbuf);
+    found = nautilus_thumbnail_cache_lookup (handle);
+    g_assert_nonnull (found);
+
+    nautilus_thumbnail_cache_remove (handle);
+}
+
+static void
+setup_test_suite (void)
+{
+    g_test_add_func ("/thumbnail-cache-insert/1.0",
+                     test_insert_and_lookup);
+    g_test_add_func ("/thumbnail-cache-scaled/1.0",
+                     test_scaled);
+    g_test_add_func ("/thumbnail-cache-eviction/1.0",
+                     test_eviction);
+    g_test_add_func ("/thumbnail-cache-eviction/1.1",
+                     test_oversized_entry);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+
+    setup_test_suite ();
+
+    return g_test_run ();
+}